@@ -0,0 +1,255 @@
+// HMAC-SHA256 and MD5 throughput: OpenSSL's EVP interface, which the Linux driver.azure hash
+// streambufs use, against the cryptlite code in bolt/auth, plus the base64 and hex encodings
+// Signature runs on every request against the stream based code they replaced.
+//
+// Usage: hashbenchmark [seconds per case]
+// Prints one line per case: implementation, message size, ns per message and MB/s.
+// hashbenchmark_portable is the same program built with CRYPTLITE_NO_SHA_NI.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <openssl/evp.h>
+#include <cryptlite/sha256.h>
+#include <cryptlite/hmac.h>
+#include <cryptlite/base64.h>
+#include <cryptlite/hex.h>
+
+namespace
+{
+	// Same construction as basic_hash_hmac_sha256_streambuf
+	class evp_hmac_sha256
+	{
+	public:
+		explicit evp_hmac_sha256(const std::vector<unsigned char> &key) : m_context(EVP_MD_CTX_create())
+		{
+			unsigned char block[64] = {};
+			std::memcpy(block, key.data(), key.size() < sizeof(block) ? key.size() : sizeof(block));
+			for (size_t i = 0; i < sizeof(block); ++i)
+			{
+				m_inner_pad[i] = block[i] ^ 0x36;
+				m_outer_pad[i] = block[i] ^ 0x5c;
+			}
+		}
+
+		~evp_hmac_sha256()
+		{
+			EVP_MD_CTX_destroy(m_context);
+		}
+
+		void sign(const unsigned char *data, size_t size, unsigned char digest[32])
+		{
+			unsigned char inner[EVP_MAX_MD_SIZE];
+			unsigned int length = 0;
+			EVP_DigestInit_ex(m_context, EVP_sha256(), nullptr);
+			EVP_DigestUpdate(m_context, m_inner_pad, sizeof(m_inner_pad));
+			EVP_DigestUpdate(m_context, data, size);
+			EVP_DigestFinal_ex(m_context, inner, &length);
+			EVP_DigestInit_ex(m_context, EVP_sha256(), nullptr);
+			EVP_DigestUpdate(m_context, m_outer_pad, sizeof(m_outer_pad));
+			EVP_DigestUpdate(m_context, inner, length);
+			EVP_DigestFinal_ex(m_context, digest, &length);
+		}
+
+	private:
+		EVP_MD_CTX *m_context;
+		unsigned char m_inner_pad[64];
+		unsigned char m_outer_pad[64];
+	};
+
+	// The encoders as they were before the table driven ones
+	std::string stream_base64(const unsigned char *s, unsigned int size)
+	{
+		static const char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+		std::ostringstream os;
+		unsigned int i = 0;
+		while (i < size)
+		{
+			unsigned char c1 = s[i++];
+			if (i == size)
+			{
+				os << table[c1 >> 2] << table[(c1 & 0x3) << 4] << "==";
+				break;
+			}
+			unsigned char c2 = s[i++];
+			if (i == size)
+			{
+				os << table[c1 >> 2] << table[((c1 & 0x3) << 4) | ((c2 & 0xf0) >> 4)] << table[(c2 & 0xf) << 2] << '=';
+				break;
+			}
+			unsigned char c3 = s[i++];
+			os << table[c1 >> 2] << table[((c1 & 0x3) << 4) | ((c2 & 0xf0) >> 4)]
+				<< table[((c2 & 0xf) << 2) | ((c3 & 0xc0) >> 6)] << table[c3 & 0x3f];
+		}
+		return os.str();
+	}
+
+	std::string stream_hex(const unsigned char *s, unsigned int size)
+	{
+		std::ostringstream oss;
+		oss << std::hex << std::setfill('0');
+		for (unsigned int i = 0; i < size; ++i)
+		{
+			oss << std::setw(2) << (s[i] & 0xff);
+		}
+		return oss.str();
+	}
+
+	volatile unsigned char g_sink;
+
+	template <typename Fn>
+	void run(const char *name, size_t size, double seconds, Fn fn)
+	{
+		typedef std::chrono::steady_clock clock;
+		size_t iterations = 0;
+		auto start = clock::now();
+		auto deadline = start + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(seconds));
+		auto now = start;
+		do
+		{
+			for (int i = 0; i < 64; ++i)
+			{
+				fn();
+			}
+			iterations += 64;
+			now = clock::now();
+		} while (now < deadline);
+
+		double elapsed = std::chrono::duration<double>(now - start).count();
+		printf("%-22s %7zu bytes %10.1f ns %9.1f MB/s\n", name, size,
+			elapsed * 1e9 / iterations, iterations * size / elapsed / 1e6);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	double seconds = argc > 1 ? std::atof(argv[1]) : 1.0;
+
+#ifdef CRYPTLITE_SHA_NI
+	printf("cryptlite sha256: %s\n", cryptlite::detail::sha256_has_sha_ni() ? "SHA-NI" : "portable, no SHA-NI on this CPU");
+#else
+	printf("cryptlite sha256: portable\n");
+#endif
+
+	std::vector<unsigned char> key(32);
+	for (size_t i = 0; i < key.size(); ++i)
+	{
+		key[i] = static_cast<unsigned char>(i * 31 + 7);
+	}
+
+	evp_hmac_sha256 evp(key);
+	cryptlite::hmac<cryptlite::sha256> signer(key.data(), static_cast<int>(key.size()));
+	EVP_MD_CTX *md = EVP_MD_CTX_create();
+
+	// 256 bytes is about the size of a table request's string to sign
+	const size_t sizes[] = { 64, 256, 1024, 4096, 65536 };
+	for (size_t size : sizes)
+	{
+		std::vector<unsigned char> data(size);
+		for (size_t i = 0; i < size; ++i)
+		{
+			data[i] = static_cast<unsigned char>(i);
+		}
+
+		unsigned char expected[32];
+		unsigned char actual[32];
+		evp.sign(data.data(), data.size(), expected);
+		cryptlite::hmac<cryptlite::sha256>::calc(data.data(), static_cast<int>(data.size()), key.data(), static_cast<int>(key.size()), actual);
+		if (std::memcmp(expected, actual, sizeof(expected)) != 0)
+		{
+			fprintf(stderr, "HMAC mismatch at %zu bytes\n", size);
+			return 1;
+		}
+
+		run("openssl hmac-sha256", size, seconds, [&]
+		{
+			evp.sign(data.data(), data.size(), actual);
+			g_sink = actual[0];
+		});
+		run("cryptlite hmac-sha256", size, seconds, [&]
+		{
+			cryptlite::hmac<cryptlite::sha256>::calc(data.data(), static_cast<int>(data.size()), key.data(), static_cast<int>(key.size()), actual);
+			g_sink = actual[0];
+		});
+		run("cryptlite hmac sign", size, seconds, [&]
+		{
+			signer.sign(data.data(), static_cast<int>(data.size()), actual);
+			g_sink = actual[0];
+		});
+		run("openssl sha256", size, seconds, [&]
+		{
+			unsigned int length = 0;
+			EVP_DigestInit_ex(md, EVP_sha256(), nullptr);
+			EVP_DigestUpdate(md, data.data(), data.size());
+			EVP_DigestFinal_ex(md, actual, &length);
+			g_sink = actual[0];
+		});
+		run("cryptlite sha256", size, seconds, [&]
+		{
+			cryptlite::sha256 ctx;
+			ctx.input(data.data(), static_cast<unsigned int>(data.size()));
+			ctx.result(actual);
+			g_sink = actual[0];
+		});
+		run("openssl md5", size, seconds, [&]
+		{
+			unsigned int length = 0;
+			EVP_DigestInit_ex(md, EVP_md5(), nullptr);
+			EVP_DigestUpdate(md, data.data(), data.size());
+			EVP_DigestFinal_ex(md, actual, &length);
+			g_sink = actual[0];
+		});
+	}
+
+	// The encodings of a signature digest, and of a larger payload
+	const size_t encode_sizes[] = { 32, 4096 };
+	for (size_t size : encode_sizes)
+	{
+		std::vector<unsigned char> data(size);
+		for (size_t i = 0; i < size; ++i)
+		{
+			data[i] = static_cast<unsigned char>(i * 13);
+		}
+		const unsigned int length = static_cast<unsigned int>(size);
+
+		std::string encoded = cryptlite::base64::encode_from_array(data.data(), length);
+		std::vector<unsigned char> decoded;
+		cryptlite::base64::decode(encoded, decoded);
+		if (encoded != stream_base64(data.data(), length) || decoded != data
+			|| cryptlite::hex::encode_from_array(data.data(), length) != stream_hex(data.data(), length))
+		{
+			fprintf(stderr, "encoding mismatch at %zu bytes\n", size);
+			return 1;
+		}
+
+		run("stream base64", size, seconds, [&]
+		{
+			g_sink = stream_base64(data.data(), length)[0];
+		});
+		run("cryptlite base64", size, seconds, [&]
+		{
+			g_sink = cryptlite::base64::encode_from_array(data.data(), length)[0];
+		});
+		run("cryptlite base64 dec", size, seconds, [&]
+		{
+			auto result = cryptlite::base64::decode_to_array(encoded);
+			g_sink = result.get<0>()[0];
+		});
+		run("stream hex", size, seconds, [&]
+		{
+			g_sink = stream_hex(data.data(), length)[0];
+		});
+		run("cryptlite hex", size, seconds, [&]
+		{
+			g_sink = cryptlite::hex::encode_from_array(data.data(), length)[0];
+		});
+	}
+
+	EVP_MD_CTX_destroy(md);
+	return 0;
+}
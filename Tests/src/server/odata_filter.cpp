@@ -0,0 +1,171 @@
+#define BOOST_TEST_MODULE ODataFilterTest
+#define BOOST_TEST_MAIN
+//Boost.Test goes first, cpprest's U() macro breaks its templates
+#include <boost/test/unit_test.hpp>
+#include <iostream>
+#include <cpprest/asyncrt_utils.h>
+#include <odata_filter.hpp>
+using namespace std;
+using namespace bolt::storage::mysql;
+
+static bool compile(const utility::string_t &expression, utility::string_t &sql, vector<mysql_property> &parameters)
+{
+	ODataFilter filter;
+	utility::string_t error;
+	if (!ODataFilter::parse(expression, filter, error))
+		return false;
+	sql = filter.toSql(parameters);
+	return true;
+}
+
+static bool rejects(const utility::string_t &expression)
+{
+	ODataFilter filter;
+	utility::string_t error;
+	bool parsed = ODataFilter::parse(expression, filter, error);
+	return !parsed && !error.empty() && filter.empty();
+}
+
+BOOST_AUTO_TEST_SUITE(ClassODataFilter)
+
+BOOST_AUTO_TEST_CASE(AND_BINDS_TIGHTER_THAN_OR)
+{
+	utility::string_t sql;
+	vector<mysql_property> parameters;
+	BOOST_REQUIRE(compile(U("a eq 1 or b eq 2 and c eq 3"), sql, parameters));
+	BOOST_CHECK(sql == U("(`a` = ? OR (`b` = ? AND `c` = ?))"));
+	BOOST_REQUIRE(parameters.size() == 3);
+	BOOST_CHECK(parameters[0].int32_value() == 1);
+	BOOST_CHECK(parameters[1].int32_value() == 2);
+	BOOST_CHECK(parameters[2].int32_value() == 3);
+}
+
+BOOST_AUTO_TEST_CASE(PARENTHESES_OVERRIDE_PRECEDENCE)
+{
+	utility::string_t sql;
+	vector<mysql_property> parameters;
+	BOOST_REQUIRE(compile(U("(a eq 1 or b eq 2) and c eq 3"), sql, parameters));
+	BOOST_CHECK(sql == U("((`a` = ? OR `b` = ?) AND `c` = ?)"));
+	BOOST_CHECK(parameters.size() == 3);
+}
+
+BOOST_AUTO_TEST_CASE(NOT_APPLIES_TO_ONE_OPERAND)
+{
+	utility::string_t sql;
+	vector<mysql_property> parameters;
+	BOOST_REQUIRE(compile(U("not a eq 1 and b ne 2"), sql, parameters));
+	BOOST_CHECK(sql == U("(NOT (`a` = ?) AND `b` <> ?)"));
+
+	parameters.clear();
+	BOOST_REQUIRE(compile(U("not (a eq 1 and b ne 2)"), sql, parameters));
+	BOOST_CHECK(sql == U("NOT ((`a` = ? AND `b` <> ?))"));
+}
+
+BOOST_AUTO_TEST_CASE(COMPARISON_OPERATORS)
+{
+	utility::string_t sql;
+	vector<mysql_property> parameters;
+	BOOST_REQUIRE(compile(U("a gt 1 and b ge 2 and c lt 3 and d le 4"), sql, parameters));
+	BOOST_CHECK(sql == U("(((`a` > ? AND `b` >= ?) AND `c` < ?) AND `d` <= ?)"));
+	BOOST_CHECK(parameters.size() == 4);
+}
+
+BOOST_AUTO_TEST_CASE(LITERAL_ON_THE_LEFT_IS_MIRRORED)
+{
+	utility::string_t sql;
+	vector<mysql_property> parameters;
+	BOOST_REQUIRE(compile(U("18 lt Age"), sql, parameters));
+	BOOST_CHECK(sql == U("`Age` > ?"));
+	BOOST_REQUIRE(parameters.size() == 1);
+	BOOST_CHECK(parameters[0].int32_value() == 18);
+}
+
+BOOST_AUTO_TEST_CASE(QUOTE_ESCAPE_IS_UNESCAPED)
+{
+	utility::string_t sql;
+	vector<mysql_property> parameters;
+	BOOST_REQUIRE(compile(U("Name eq 'O''Brien'"), sql, parameters));
+	BOOST_CHECK(sql == U("`Name` = ?"));
+	BOOST_REQUIRE(parameters.size() == 1);
+	BOOST_CHECK(parameters[0].string_value() == U("O'Brien"));
+}
+
+BOOST_AUTO_TEST_CASE(STRING_STAYS_A_PARAMETER)
+{
+	utility::string_t sql;
+	vector<mysql_property> parameters;
+	BOOST_REQUIRE(compile(U("Name eq 'x'' or 1 eq 1 -- `a`'"), sql, parameters));
+	BOOST_CHECK(sql == U("`Name` = ?"));
+	BOOST_REQUIRE(parameters.size() == 1);
+	BOOST_CHECK(parameters[0].string_value() == U("x' or 1 eq 1 -- `a`"));
+}
+
+BOOST_AUTO_TEST_CASE(AZURE_FILTER_ESCAPES_QUOTES)
+{
+	ODataFilter filter;
+	utility::string_t error;
+	BOOST_REQUIRE(ODataFilter::parse(U("Name eq 'O''Brien' or Age gt 30"), filter, error));
+	BOOST_CHECK(filter.toAzure() == U("(Name eq 'O''Brien') or (Age gt 30)"));
+}
+
+BOOST_AUTO_TEST_CASE(LITERAL_TYPES)
+{
+	utility::string_t sql;
+	vector<mysql_property> parameters;
+	BOOST_REQUIRE(compile(U("a eq 10L and b eq 3000000000 and c eq 1.5 and d eq true and e eq datetime'2015-01-31T10:00:00Z'"), sql, parameters));
+	BOOST_REQUIRE(parameters.size() == 5);
+	BOOST_CHECK(parameters[0].property_type() == myedm_type::int64);
+	BOOST_CHECK(parameters[0].int64_value() == 10);
+	BOOST_CHECK(parameters[1].property_type() == myedm_type::int64);
+	BOOST_CHECK(parameters[1].int64_value() == 3000000000LL);
+	BOOST_CHECK(parameters[2].property_type() == myedm_type::double_floating_point);
+	BOOST_CHECK(parameters[2].double_value() == 1.5);
+	BOOST_CHECK(parameters[3].property_type() == myedm_type::boolean);
+	BOOST_CHECK(parameters[3].boolean_value());
+	BOOST_CHECK(parameters[4].string_value() == U("2015-01-31 10:00:00"));
+}
+
+BOOST_AUTO_TEST_CASE(REJECTS_FUNCTIONS)
+{
+	BOOST_CHECK(rejects(U("substringof('a', Name)")));
+	BOOST_CHECK(rejects(U("startswith(Name, 'a') eq true")));
+	BOOST_CHECK(rejects(U("length(Name) gt 3")));
+	BOOST_CHECK(rejects(U("Name eq tolower('A')")));
+}
+
+BOOST_AUTO_TEST_CASE(REJECTS_TRAILING_INPUT)
+{
+	BOOST_CHECK(rejects(U("a eq 1 b")));
+	BOOST_CHECK(rejects(U("a eq 1)")));
+	BOOST_CHECK(rejects(U("a eq 1;")));
+	BOOST_CHECK(rejects(U("a eq 1 and")));
+	BOOST_CHECK(rejects(U("a eq 1 -- comment")));
+}
+
+BOOST_AUTO_TEST_CASE(REJECTS_MALFORMED_INPUT)
+{
+	BOOST_CHECK(rejects(U("")));
+	BOOST_CHECK(rejects(U("(a eq 1")));
+	BOOST_CHECK(rejects(U("a eq 'x")));
+	BOOST_CHECK(rejects(U("a eq null")));
+	BOOST_CHECK(rejects(U("`a` eq 1")));
+	BOOST_CHECK(rejects(U("a like 'x'")));
+	BOOST_CHECK(rejects(U("a eq 12abc")));
+	BOOST_CHECK(rejects(U("a eq binary'00'")));
+	BOOST_CHECK(rejects(U("a eq guid'not-a-guid'")));
+}
+
+BOOST_AUTO_TEST_CASE(REJECTS_OVERSIZED_INPUT)
+{
+	utility::string_t nested = utility::string_t(40, U('(')) + U("a eq 1") + utility::string_t(40, U(')'));
+	BOOST_CHECK(rejects(nested));
+
+	utility::string_t many = U("a eq 0");
+	for (int i = 1; i <= 128; ++i)
+	{
+		many += U(" or a eq 1");
+	}
+	BOOST_CHECK(rejects(many));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -14,27 +14,38 @@
 
 #include <memory>
 #include <mutex>
+#include <mysql_pool.hpp>
 
 
 namespace bolt {
 	namespace auth	{
 
+		/// <summary>
+		/// Connection pool of the auth library. It is separate from the storage pool
+		/// so permission and key lookups never queue behind data queries.
+		/// </summary>
 		class Connection
 		{
 		public:
-			std::shared_ptr<sql::Connection> m_connection;
-
 			virtual ~Connection() {}
-			static Connection& GetInstance();
+			BOLTAUTH_API static Connection& GetInstance();
 		
 
 			/// <summary>
-			/// Return this instance of database connection.
+			/// Checks a connection out of the auth pool.
+			/// </summary>
+			/// <returns></returns>
+			MysqlConnectionLease acquire();
+
+			/// <summary>
+			/// Checkout and wait counters of the auth pool.
 			/// </summary>
 			/// <returns></returns>
-			std::shared_ptr<sql::Connection> getConnection();
+			BOLTAUTH_API MysqlPoolStatistics statistics();
 		private:
 
+			std::unique_ptr<MysqlConnectionPool> m_pool;
+
 			Connection(void);
 
 			Connection(const Connection& src);
@@ -43,14 +54,11 @@ namespace bolt {
 			static std::once_flag m_instance_flag;
 
 			/// <summary>
-			/// Gets the connection.
+			/// Creates the connection pool.
 			/// </summary>
-			/// <param name="host">The host.</param>
-			/// <param name="username">The username.</param>
-			/// <param name="password">The password.</param>
-			/// <param name="db">The database.</param>
+			/// <param name="options">Credentials and sizing of the pool.</param>
 			/// <returns></returns>
-			int setConnectionParams(std::string host, std::string username, std::string password, std::string db);
+			int setConnectionParams(const MysqlPoolOptions& options);
 			
 		};
 	}
@@ -47,85 +47,52 @@ class base64 : public boost::noncopyable {
   static std::string 
   encode_from_array(const boost::uint8_t* s, unsigned int size) 
   {
-    std::ostringstream os;
-    boost::uint8_t c1, c2, c3;
+    const char* table = enctable();
+    std::string dest(((static_cast<std::size_t>(size) + 2) / 3) * 4, '\0');
+    if (!size)
+      return dest;
+
+    char* out = &dest[0];
     unsigned int i = 0;
 
-    while (i < size) {
-      c1 = s[i++] & 0xff;
-      if (i == size) {
-        os << enctable[c1 >> 2];
-        os << enctable[(c1 & 0x3) << 4];
-        os << "==";
-        break;
-      }
-      c2 = s[i++];
-      if (i == size) {
-        os << enctable[c1 >> 2];
-        os << enctable[((c1 & 0x3) << 4)|((c2 & 0xf0) >> 4)];
-        os << enctable[(c2 & 0xf) << 2];
-        os << '=';
-        break;
-      }
-      c3 = s[i++];
-      os << enctable[c1 >> 2];
-      os << enctable[((c1 & 0x3) << 4) | ((c2 & 0xf0) >> 4)];
-      os << enctable[((c2 & 0xf) << 2) | ((c3 & 0xc0) >> 6)];
-      os << enctable[c3 & 0x3f];
+    // Whole groups: three bytes to four characters through one 24 bit word
+    for (; i + 3 <= size; i += 3) {
+      boost::uint32_t v = (static_cast<boost::uint32_t>(s[i]) << 16)
+        | (static_cast<boost::uint32_t>(s[i + 1]) << 8) | s[i + 2];
+      out[0] = table[v >> 18];
+      out[1] = table[(v >> 12) & 0x3f];
+      out[2] = table[(v >> 6) & 0x3f];
+      out[3] = table[v & 0x3f];
+      out += 4;
+    }
+
+    if (i + 1 == size) {
+      boost::uint8_t c1 = s[i];
+      out[0] = table[c1 >> 2];
+      out[1] = table[(c1 & 0x3) << 4];
+      out[2] = '=';
+      out[3] = '=';
+    } else if (i + 2 == size) {
+      boost::uint8_t c1 = s[i];
+      boost::uint8_t c2 = s[i + 1];
+      out[0] = table[c1 >> 2];
+      out[1] = table[((c1 & 0x3) << 4) | ((c2 & 0xf0) >> 4)];
+      out[2] = table[(c2 & 0xf) << 2];
+      out[3] = '=';
     }
-    return os.str();
+    return dest;
   }
 
   static boost::tuple<boost::shared_array<boost::uint8_t>, std::size_t> 
   decode_to_array(const std::string& s)
   {
-    char c1, c2, c3, c4;
-    unsigned int size = static_cast<unsigned int>(s.size());
-    unsigned int i = 0;
-    float dest_guide_size = static_cast<float>(size * 3) / 4;
-
+    float dest_guide_size = static_cast<float>(s.size() * 3) / 4;
     unsigned int reserved = static_cast<unsigned int>(std::ceil(dest_guide_size));
 
     boost::shared_array<boost::uint8_t> dest(new boost::uint8_t[reserved]);
     std::size_t dest_len = 0;
-
-    while (i < size) {
-      do {
-        c1 = dectable[s[i++] & 0xff];
-      } while (i < size && c1 == -1);
-      if (c1 == -1)
-        break;
-
-      do {
-        c2 = dectable[s[i++] & 0xff];
-      } while (i < size && c2 == -1);
-      if (c2 == -1)
-        break;
-
-      dest[dest_len++] = static_cast<boost::uint8_t>(((c1 << 2)|((c2 & 0x30) >> 4) & 0xff));
-
-      do {
-        c3 = s[i++] & 0xff;
-        if (c3 == 61)
-          return boost::make_tuple(dest, dest_len);
-        c3 = dectable[c3];
-      } while (i < size && c3 == -1);
-      if (c3 == -1)
-        break;
-
-      dest[dest_len++] = static_cast<boost::uint8_t>((((c2 & 0xf) << 4)|((c3 & 0x3c) >> 2) & 0xff));
-
-      do {
-        c4 = s[i++] & 0xff;
-        if (c4 == 61)
-          return boost::make_tuple(dest, dest_len);
-        c4 = dectable[c4];
-      } while (i < size && c4 == -1);
-      if (c4 == -1)
-        break;
-
-      dest[dest_len++] = static_cast<boost::uint8_t>((((c3 & 0x03) << 6)| c4) & 0xff);
-    }
+    byte_writer writer = { dest.get(), &dest_len };
+    decode_into(s, writer);
     return boost::make_tuple(dest, dest_len);
   }
 
@@ -133,79 +100,123 @@ class base64 : public boost::noncopyable {
   static void 
   decode(const std::string& s, T& dest)
   {
-    char c1, c2, c3, c4;
-    std::size_t size = s.size();
-    int i= 0;
-    float dest_guide_size = static_cast<float>(size * 3) / 4;
+    float dest_guide_size = static_cast<float>(s.size() * 3) / 4;
 
     dest.clear();
-    /*
-    dest.reserve(size);
-    */
     unsigned int reserved = static_cast<unsigned int>(std::ceil(dest_guide_size));
     dest.reserve(reserved);
-    /*
-    unsigned short mod     = reserved % 4;
-    unsigned short padding = (mod == 0) ? 0 : (4 - mod);
-    dest.reserve(reserved + padding);
-    */
+    container_writer<T> writer = { &dest };
+    decode_into(s, writer);
+  }
+
+ private:
+  struct byte_writer {
+    boost::uint8_t* dest;
+    std::size_t* length;
+    void operator()(boost::uint8_t c) { dest[(*length)++] = c; }
+  };
+
+  template <typename T>
+  struct container_writer {
+    T* dest;
+    void operator()(boost::uint8_t c) { dest->push_back(c); }
+  };
+
+  // Characters outside the alphabet are skipped and '=' ends the data. Runs of four
+  // valid characters, the common case, are decoded without the per character checks.
+  template <typename Writer>
+  static void 
+  decode_into(const std::string& s, Writer& write)
+  {
+    const signed char* table = dectable();
+    const unsigned char* in = reinterpret_cast<const unsigned char*>(s.data());
+    std::size_t size = s.size();
+    std::size_t i = 0;
+    int c1, c2, c3, c4;
 
     while (i < size) {
+      if (i + 4 <= size) {
+        c1 = table[in[i]];
+        c2 = table[in[i + 1]];
+        c3 = table[in[i + 2]];
+        c4 = table[in[i + 3]];
+        if ((c1 | c2 | c3 | c4) >= 0) {
+          boost::uint32_t v = (c1 << 18) | (c2 << 12) | (c3 << 6) | c4;
+          write(static_cast<boost::uint8_t>(v >> 16));
+          write(static_cast<boost::uint8_t>(v >> 8));
+          write(static_cast<boost::uint8_t>(v));
+          i += 4;
+          continue;
+        }
+      }
+
       do {
-        c1 = dectable[s[i++] & 0xff];
+        c1 = table[in[i++]];
       } while (i < size && c1 == -1);
       if (c1 == -1)
         break;
 
       do {
-        c2 = dectable[s[i++] & 0xff];
+        c2 = table[in[i++]];
       } while (i < size && c2 == -1);
       if (c2 == -1)
         break;
 
-      dest.push_back(static_cast<boost::uint8_t>(((c1 << 2)|((c2 & 0x30) >> 4) & 0xff)));
+      write(static_cast<boost::uint8_t>((c1 << 2) | ((c2 & 0x30) >> 4)));
 
       do {
-        c3 = s[i++] & 0xff;
-        if (c3 == 61)
-            return;
-        c3 = dectable[c3];
+        if (in[i] == '=')
+          return;
+        c3 = table[in[i++]];
       } while (i < size && c3 == -1);
       if (c3 == -1)
         break;
 
-      dest.push_back(static_cast<boost::uint8_t>((((c2 & 0xf) << 4)|((c3 & 0x3c) >> 2) & 0xff)));
+      write(static_cast<boost::uint8_t>(((c2 & 0xf) << 4) | ((c3 & 0x3c) >> 2)));
 
       do {
-        c4 = s[i++] & 0xff;
-        if (c4 == 61)
+        if (in[i] == '=')
           return;
-        c4 = dectable[c4];
+        c4 = table[in[i++]];
       } while (i < size && c4 == -1);
       if (c4 == -1)
         break;
 
-      dest.push_back(static_cast<boost::uint8_t>((((c3 & 0x03) << 6)| c4) & 0xff));
+      write(static_cast<boost::uint8_t>(((c3 & 0x03) << 6) | c4));
     }
   }
 
- private:
-  static const char enctable[65];
-  static const char dectable[128];
+  static const char* enctable()
+  {
+    static const char table[65] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    return table;
+  }
 
-}; // end of class
+  // Indexed by the unsigned character, -1 for anything outside the alphabet
+  static const signed char* dectable()
+  {
+    static const signed char table[256] = {
+      -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+      -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+      -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 62, -1, -1, -1, 63,
+      52, 53, 54, 55, 56, 57, 58, 59, 60, 61, -1, -1, -1, -1, -1, -1,
+      -1,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+      15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, -1, -1, -1, -1, -1,
+      -1, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+      41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, -1, -1, -1, -1, -1,
+      -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+      -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+      -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+      -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+      -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+      -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+      -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+      -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+    };
+    return table;
+  }
 
-const char base64::enctable[65] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-const char base64::dectable[128] = {
-  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 62, -1, -1, -1, 63,
-  52, 53, 54, 55, 56, 57, 58, 59, 60, 61, -1, -1, -1, -1, -1, -1,
-  -1,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
-  15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, -1, -1, -1, -1, -1,
-  -1, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
-  41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, -1, -1, -1, -1, -1
-};
+}; // end of class
 
 }  // end of namespace
 
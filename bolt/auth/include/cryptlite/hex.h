@@ -0,0 +1,38 @@
+#pragma once
+#ifndef _CRYPTLITE_HEX_H_
+#define _CRYPTLITE_HEX_H_
+#include <string>
+#include <boost/cstdint.hpp>
+
+namespace cryptlite {
+
+// Lower-case hex encoding of digests, one table lookup per nibble.
+class hex {
+
+ public:
+
+  static std::string
+  encode_from_array(const boost::uint8_t* s, unsigned int size)
+  {
+    std::string dest(static_cast<std::size_t>(size) * 2, '\0');
+    if (size)
+      encode_to(s, size, &dest[0]);
+    return dest;
+  }
+
+  // Writes exactly 2 * size characters, no terminator
+  static void
+  encode_to(const boost::uint8_t* s, unsigned int size, char* dest)
+  {
+    static const char digits[] = "0123456789abcdef";
+    for (unsigned int i = 0; i < size; ++i) {
+      *dest++ = digits[s[i] >> 4];
+      *dest++ = digits[s[i] & 0xf];
+    }
+  }
+
+}; // end of class
+
+}  // end of namespace
+
+#endif
@@ -29,8 +29,11 @@ THE SOFTWARE.
 #include <sstream>
 #include <cstring>
 #include <cassert>
+#include <climits>
+#include <stdexcept>
 #include <iomanip>
 #include <boost/cstdint.hpp>
+#include <cryptlite/hex.h>
 
 namespace cryptlite {
 
@@ -66,33 +69,27 @@ public:
             const std::string& key,
             boost::uint8_t digest[HASH_SIZE]) {
         assert(digest);
-        calc(reinterpret_cast<const char*>(text.c_str()), text.size(),
-             reinterpret_cast<const char*>(key.c_str()), key.size(), digest);
+        calc(reinterpret_cast<const char*>(text.c_str()), checked_length(text.size()),
+             reinterpret_cast<const char*>(key.c_str()), checked_length(key.size()), digest);
     }
 
     inline static std::string calc_hex(
             const std::string& text,
             const std::string& key ) {
-        return calc_hex(reinterpret_cast<const boost::uint8_t*>(text.c_str()), text.size(),
-                reinterpret_cast<const boost::uint8_t*>(key.c_str()), key.size());
+        return calc_hex(reinterpret_cast<const boost::uint8_t*>(text.c_str()), checked_length(text.size()),
+                reinterpret_cast<const boost::uint8_t*>(key.c_str()), checked_length(key.size()));
     }
 
     static std::string calc_hex(
             const boost::uint8_t* text, int text_len,
             const boost::uint8_t* key,  int key_len ) {
-        int i;
         boost::uint8_t digest[HASH_SIZE];
         assert(key);
         assert(text);
-        std::ostringstream oss;
-        oss << std::hex << std::setfill('0');
         hmac<T> ctx(key, key_len);
         ctx.input(text, text_len);
         ctx.result(digest);
-        for (i = 0; i < HASH_SIZE; i++)
-            oss << std::setw(2) << (digest[i] & 0xff);
-        oss << std::dec;
-        return oss.str();
+        return hex::encode_from_array(digest, HASH_SIZE);
     }
 
     hmac(const boost::uint8_t* key, int key_len) : hasher_(T()) {
@@ -101,24 +98,25 @@ public:
     }
 
     hmac(const std::string& key) : hasher_(T()) {
-        reset(reinterpret_cast<const boost::uint8_t*>(key.c_str()), key.size());
+        reset(reinterpret_cast<const boost::uint8_t*>(key.c_str()), checked_length(key.size()));
     }
 
     ~hmac() { }
 
     inline void reset(const std::string& key) {
-        reset(reinterpret_cast<const boost::uint8_t*>(key.c_str()), key.size());
+        reset(reinterpret_cast<const boost::uint8_t*>(key.c_str()), checked_length(key.size()));
     }
 
     void reset(const boost::uint8_t* key, int key_len) {
 
         int i;
         boost::uint8_t k_ipad[BLOCK_SIZE];
+        boost::uint8_t k_opad[BLOCK_SIZE];
         boost::uint8_t tempkey[HASH_SIZE];
 
         assert(key);
 
-        if (key_len > BLOCK_SIZE) {
+        if (key_len > static_cast<int>(BLOCK_SIZE)) {
             T sha;
             sha.input(key, key_len);
             sha.result(tempkey);
@@ -127,21 +125,48 @@ public:
         }
 
         for (i=0; i < key_len; i++) {
-            k_ipad[i]  = key[i] ^ 0x36;
-            k_opad_[i] = key[i] ^ 0x5c;
+            k_ipad[i] = key[i] ^ 0x36;
+            k_opad[i] = key[i] ^ 0x5c;
         }
 
-        for (; i < BLOCK_SIZE; i++) {
-            k_ipad[i]  = 0x36;
-            k_opad_[i] = 0x5c;
+        for (; i < static_cast<int>(BLOCK_SIZE); i++) {
+            k_ipad[i] = 0x36;
+            k_opad[i] = 0x5c;
         }
 
-        hasher_.reset();
-        hasher_.input(k_ipad, BLOCK_SIZE);
+        // Both pads fill exactly one block, so the hashers below hold the
+        // keyed inner and outer states and never see the key again.
+        inner_.reset();
+        inner_.input(k_ipad, BLOCK_SIZE);
+        outer_.reset();
+        outer_.input(k_opad, BLOCK_SIZE);
+        hasher_ = inner_;
+    }
+
+    // Starts a new message under the same key.
+    inline void restart() {
+        hasher_ = inner_;
+    }
+
+    // One-shot HMAC from the precomputed pad states. It leaves the context
+    // untouched, so one keyed context can be shared between threads.
+    void sign(const boost::uint8_t* text, int text_len, boost::uint8_t digest[HASH_SIZE]) const {
+        assert(text || text_len == 0);
+        assert(digest);
+        T inner(inner_);
+        inner.input(text, text_len);
+        inner.result(digest);
+        T outer(outer_);
+        outer.input(digest, HASH_SIZE);
+        outer.result(digest);
+    }
+
+    inline void sign(const std::string& text, boost::uint8_t digest[HASH_SIZE]) const {
+        sign(reinterpret_cast<const boost::uint8_t*>(text.c_str()), checked_length(text.size()), digest);
     }
 
     inline void input(const std::string& text) {
-        input(reinterpret_cast<const boost::uint8_t*>(text.c_str()), text.size());
+        input(reinterpret_cast<const boost::uint8_t*>(text.c_str()), checked_length(text.size()));
     }
 
     void input(const boost::uint8_t* text, int text_len) {
@@ -156,14 +181,21 @@ public:
     void result(boost::uint8_t digest[HASH_SIZE]) {
         assert(digest);
         hasher_.result(digest);
-        hasher_.reset();
-        hasher_.input(k_opad_, BLOCK_SIZE);
+        hasher_ = outer_;
         hasher_.input(digest, HASH_SIZE);
         hasher_.result(digest);
     }
 
 private:
-    boost::uint8_t k_opad_[BLOCK_SIZE];
+    // The lengths below are int, longer strings are rejected instead of truncated.
+    static int checked_length(std::string::size_type length) {
+        if (length > static_cast<std::string::size_type>(INT_MAX))
+            throw std::length_error("cryptlite::hmac input too long");
+        return static_cast<int>(length);
+    }
+
+    T inner_;
+    T outer_;
     T hasher_;
 }; // end of class
 
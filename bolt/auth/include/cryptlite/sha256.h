@@ -28,9 +28,27 @@ THE SOFTWARE.
 #include <cassert>
 #include <sstream>
 #include <iomanip>
+#include <cstring>
 #include <cryptlite/base64.h>
+#include <cryptlite/hex.h>
 #include <boost/cstdint.hpp>
 
+// Blocks are compressed with the x86 SHA extensions when the CPU has them, checked once at run time.
+// Define CRYPTLITE_NO_SHA_NI to always use the portable code.
+#if !defined(CRYPTLITE_NO_SHA_NI) && (defined(__x86_64__) || defined(__i386__)) && \
+    ((defined(__GNUC__) && __GNUC__ >= 5) || defined(__clang__))
+#define CRYPTLITE_SHA_NI
+#define CRYPTLITE_SHA_NI_TARGET __attribute__((target("sha,sse4.1")))
+#include <immintrin.h>
+#include <cpuid.h>
+#elif !defined(CRYPTLITE_NO_SHA_NI) && (defined(_M_X64) || defined(_M_IX86)) && \
+    defined(_MSC_VER) && _MSC_VER >= 1900
+#define CRYPTLITE_SHA_NI
+#define CRYPTLITE_SHA_NI_TARGET
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
 namespace cryptlite {
 
 #define SHA256_SHR(bits,word)      ((word) >> (bits))
@@ -57,6 +75,104 @@ namespace cryptlite {
 #define SHA256_MAJ(x, y, z)     (((x) & ((y) | (z))) | ((y) & (z)))
 #define SHA256_PARITY(x, y, z)  ((x) ^ (y) ^ (z))
 
+namespace detail {
+
+inline const boost::uint32_t* sha256_round_constants()
+{
+  static const boost::uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b,
+    0x59f111f1, 0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01,
+    0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7,
+    0xc19bf174, 0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+    0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da, 0x983e5152,
+    0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+    0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc,
+    0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819,
+    0xd6990624, 0xf40e3585, 0x106aa070, 0x19a4c116, 0x1e376c08,
+    0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f,
+    0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+  };
+  return K;
+}
+
+#ifdef CRYPTLITE_SHA_NI
+
+// SHA extensions need SSE4.1 next to them for the state shuffles
+inline bool sha256_has_sha_ni()
+{
+  static const bool supported = [] {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+      return false;
+    __cpuid(info, 1);
+    bool sse41 = (info[2] & (1 << 19)) != 0;
+    __cpuidex(info, 7, 0);
+    return sse41 && (info[1] & (1 << 29)) != 0;
+#else
+    unsigned int eax, ebx, ecx, edx;
+    if (__get_cpuid_max(0, 0) < 7)
+      return false;
+    __cpuid(1, eax, ebx, ecx, edx);
+    bool sse41 = (ecx & (1u << 19)) != 0;
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    return sse41 && (ebx & (1u << 29)) != 0;
+#endif
+  }();
+  return supported;
+}
+
+// Compresses whole blocks with the SHA-NI round instructions, four rounds per group.
+// The state is kept as ABEF / CDGH, the layout sha256rnds2 works on.
+CRYPTLITE_SHA_NI_TARGET
+inline void sha256_process_blocks_sha_ni(boost::uint32_t state[8], const boost::uint8_t* data, size_t blocks)
+{
+  const __m128i* K = reinterpret_cast<const __m128i*>(sha256_round_constants());
+  const __m128i byte_swap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+  __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[0])), 0xB1);
+  __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[4])), 0x1B);
+  __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);
+  state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+
+  for (; blocks; --blocks, data += 64) {
+    const __m128i abef = state0;
+    const __m128i cdgh = state1;
+    __m128i w[4];
+
+    for (int i = 0; i < 16; ++i) {
+      if (i < 4) {
+        w[i] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * 16)), byte_swap);
+      } else {
+        // w[t..t+3] from w[t-16..t-13], w[t-12..t-9], w[t-7..t-4] and w[t-4..t-1]
+        __m128i next = _mm_sha256msg1_epu32(w[i & 3], w[(i + 1) & 3]);
+        next = _mm_add_epi32(next, _mm_alignr_epi8(w[(i + 3) & 3], w[(i + 2) & 3], 4));
+        w[i & 3] = _mm_sha256msg2_epu32(next, w[(i + 3) & 3]);
+      }
+      __m128i msg = _mm_add_epi32(w[i & 3], _mm_loadu_si128(K + i));
+      state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+      state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(msg, 0x0E));
+    }
+
+    state0 = _mm_add_epi32(state0, abef);
+    state1 = _mm_add_epi32(state1, cdgh);
+  }
+
+  tmp = _mm_shuffle_epi32(state0, 0x1B);
+  state1 = _mm_shuffle_epi32(state1, 0xB1);
+  state0 = _mm_blend_epi16(tmp, state1, 0xF0);
+  state1 = _mm_alignr_epi8(state1, tmp, 8);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(&state[0]), state0);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(&state[4]), state1);
+}
+
+#endif
+
+}  // end of namespace detail
+
 class sha256 {
 
  public:
@@ -74,17 +190,11 @@ class sha256 {
 
   static std::string hash_hex(const std::string& s) 
   {
-    int i;
     boost::uint8_t digest[HASH_SIZE];
-    std::ostringstream oss;
-    oss << std::hex << std::setfill('0');
     sha256 ctx;
     ctx.input(reinterpret_cast<const boost::uint8_t*>(s.c_str()), (unsigned int)s.size());
     ctx.result(digest);
-    for (i = 0; i < HASH_SIZE; ++i)
-      oss << std::setw(2) << (digest[i] & 0xff);
-    oss << std::dec;
-    return oss.str();
+    return hex::encode_from_array(digest, HASH_SIZE);
   }
 
   static std::string hash_base64(const std::string& s) {
@@ -96,11 +206,11 @@ class sha256 {
   }
 
   sha256() 
-    : computed_(false)
-    , corrupted_(false)
-    , length_low_(0)
+    : length_low_(0)
     , length_high_(0)
     , message_block_index_(0)
+    , computed_(false)
+    , corrupted_(false)
   {
     intermediate_hash_[0] = 0x6A09E667; 
     intermediate_hash_[1] = 0xBB67AE85;
@@ -137,12 +247,41 @@ class sha256 {
     assert(message_array);
     if (computed_ || corrupted_ || !length)
         return;
-    boost::uint32_t temp;
-    while (length-- && !corrupted_) {
-      message_block_[message_block_index_++] = (*message_array & 0xFF);
-      if (!SHA256_ADD_LENGTH(this, &temp, 8) && (message_block_index_ == BLOCK_SIZE))
-        process_message_block();
-      ++message_array;
+    // The length is counted once per call, whole blocks are compressed straight from the caller's buffer
+    boost::uint64_t total = (static_cast<boost::uint64_t>(length_high_) << 32) | length_low_;
+    boost::uint64_t bits = static_cast<boost::uint64_t>(length) << 3;
+    if (total + bits < total) {
+      corrupted_ = true;
+      return;
+    }
+    total += bits;
+    length_low_ = static_cast<boost::uint32_t>(total);
+    length_high_ = static_cast<boost::uint32_t>(total >> 32);
+
+    if (message_block_index_ > 0) {
+      unsigned int count = BLOCK_SIZE - message_block_index_;
+      if (count > length)
+        count = length;
+      std::memcpy(message_block_ + message_block_index_, message_array, count);
+      message_block_index_ += count;
+      message_array += count;
+      length -= count;
+      if (message_block_index_ < BLOCK_SIZE)
+        return;
+      process_blocks(message_block_, 1);
+      message_block_index_ = 0;
+    }
+
+    if (length >= BLOCK_SIZE) {
+      unsigned int blocks = length / BLOCK_SIZE;
+      process_blocks(message_array, blocks);
+      message_array += blocks * BLOCK_SIZE;
+      length -= blocks * BLOCK_SIZE;
+    }
+
+    if (length) {
+      std::memcpy(message_block_, message_array, length);
+      message_block_index_ = length;
     }
   }
 
@@ -222,7 +361,8 @@ private:
   boost::uint32_t intermediate_hash_[HASH_SIZE/4];
   boost::uint32_t length_low_;
   boost::uint32_t length_high_;
-  boost::int_least16_t message_block_index_;
+  // Unsigned like BLOCK_SIZE, which it is compared with
+  unsigned int message_block_index_;
   boost::uint8_t message_block_[BLOCK_SIZE];
   bool computed_;
   bool corrupted_;
@@ -233,7 +373,8 @@ private:
       message_block_[message_block_index_++] = pad_byte;
       while (message_block_index_ < BLOCK_SIZE)
         message_block_[message_block_index_++] = 0;
-      process_message_block();
+      process_blocks(message_block_, 1);
+      message_block_index_ = 0;
     } else {
       message_block_[message_block_index_++] = pad_byte;
     }
@@ -250,12 +391,13 @@ private:
     message_block_[62] = static_cast<boost::uint8_t>(length_low_  >>  8);
     message_block_[63] = static_cast<boost::uint8_t>(length_low_       );
 
-    process_message_block();
+    process_blocks(message_block_, 1);
+    message_block_index_ = 0;
   }
 
   void finalize(boost::uint8_t pad_byte)
   {
-    int i;
+    unsigned int i;
     pad_message(pad_byte);
     for (i = 0; i < BLOCK_SIZE; ++i)
         message_block_[i] = 0;
@@ -264,91 +406,90 @@ private:
     computed_ = true;
   }
 
-  void process_message_block()
+  void process_blocks(const boost::uint8_t* data, size_t blocks)
   {
-    static const boost::uint32_t K[64] = {
-      0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b,
-      0x59f111f1, 0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01,
-      0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7,
-      0xc19bf174, 0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
-      0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da, 0x983e5152,
-      0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
-      0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc,
-      0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
-      0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819,
-      0xd6990624, 0xf40e3585, 0x106aa070, 0x19a4c116, 0x1e376c08,
-      0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f,
-      0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
-      0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
-    };
+#ifdef CRYPTLITE_SHA_NI
+    if (detail::sha256_has_sha_ni()) {
+      detail::sha256_process_blocks_sha_ni(intermediate_hash_, data, blocks);
+      return;
+    }
+#endif
+    for (; blocks; --blocks, data += BLOCK_SIZE)
+      process_block(intermediate_hash_, data);
+  }
+
+  // One block with the portable code
+  static void process_block(boost::uint32_t state[HASH_SIZE/4], const boost::uint8_t* block)
+  {
+    const boost::uint32_t* K = detail::sha256_round_constants();
     boost::uint32_t   temp1, temp2;
     boost::uint32_t   W[64];
     boost::uint32_t   A, B, C, D, E, F, G, H;
 
-    W[0] = (((boost::uint32_t)message_block_[0]) << 24) |
-        (((boost::uint32_t)message_block_[0 + 1]) << 16) |
-        (((boost::uint32_t)message_block_[0 + 2]) << 8) |
-        (((boost::uint32_t)message_block_[0 + 3]));
-    W[1] = (((boost::uint32_t)message_block_[4]) << 24) |
-        (((boost::uint32_t)message_block_[4 + 1]) << 16) |
-        (((boost::uint32_t)message_block_[4 + 2]) << 8) |
-        (((boost::uint32_t)message_block_[4 + 3]));
-    W[2] = (((boost::uint32_t)message_block_[8]) << 24) |
-        (((boost::uint32_t)message_block_[8 + 1]) << 16) |
-        (((boost::uint32_t)message_block_[8 + 2]) << 8) |
-        (((boost::uint32_t)message_block_[8 + 3]));
-    W[3] = (((boost::uint32_t)message_block_[12]) << 24) |
-        (((boost::uint32_t)message_block_[12 + 1]) << 16) |
-        (((boost::uint32_t)message_block_[12 + 2]) << 8) |
-        (((boost::uint32_t)message_block_[12 + 3]));
-    W[4] = (((boost::uint32_t)message_block_[16]) << 24) |
-        (((boost::uint32_t)message_block_[16 + 1]) << 16) |
-        (((boost::uint32_t)message_block_[16 + 2]) << 8) |
-        (((boost::uint32_t)message_block_[16 + 3]));
-    W[5] = (((boost::uint32_t)message_block_[20]) << 24) |
-        (((boost::uint32_t)message_block_[20 + 1]) << 16) |
-        (((boost::uint32_t)message_block_[20 + 2]) << 8) |
-        (((boost::uint32_t)message_block_[20 + 3]));
-    W[6] = (((boost::uint32_t)message_block_[24]) << 24) |
-        (((boost::uint32_t)message_block_[24 + 1]) << 16) |
-        (((boost::uint32_t)message_block_[24 + 2]) << 8) |
-        (((boost::uint32_t)message_block_[24 + 3]));
-    W[7] = (((boost::uint32_t)message_block_[28]) << 24) |
-        (((boost::uint32_t)message_block_[28 + 1]) << 16) |
-        (((boost::uint32_t)message_block_[28 + 2]) << 8) |
-        (((boost::uint32_t)message_block_[28 + 3]));
-    W[8] = (((boost::uint32_t)message_block_[32]) << 24) |
-        (((boost::uint32_t)message_block_[32 + 1]) << 16) |
-        (((boost::uint32_t)message_block_[32 + 2]) << 8) |
-        (((boost::uint32_t)message_block_[32 + 3]));
-    W[9] = (((boost::uint32_t)message_block_[36]) << 24) |
-        (((boost::uint32_t)message_block_[36 + 1]) << 16) |
-        (((boost::uint32_t)message_block_[36 + 2]) << 8) |
-        (((boost::uint32_t)message_block_[36 + 3]));
-    W[10] = (((boost::uint32_t)message_block_[40]) << 24) |
-        (((boost::uint32_t)message_block_[40 + 1]) << 16) |
-        (((boost::uint32_t)message_block_[40 + 2]) << 8) |
-        (((boost::uint32_t)message_block_[40 + 3]));
-    W[11] = (((boost::uint32_t)message_block_[44]) << 24) |
-        (((boost::uint32_t)message_block_[44 + 1]) << 16) |
-        (((boost::uint32_t)message_block_[44 + 2]) << 8) |
-        (((boost::uint32_t)message_block_[44 + 3]));
-    W[12] = (((boost::uint32_t)message_block_[48]) << 24) |
-        (((boost::uint32_t)message_block_[48 + 1]) << 16) |
-        (((boost::uint32_t)message_block_[48 + 2]) << 8) |
-        (((boost::uint32_t)message_block_[48 + 3]));
-    W[13] = (((boost::uint32_t)message_block_[52]) << 24) |
-        (((boost::uint32_t)message_block_[52 + 1]) << 16) |
-        (((boost::uint32_t)message_block_[52 + 2]) << 8) |
-        (((boost::uint32_t)message_block_[52 + 3]));
-    W[14] = (((boost::uint32_t)message_block_[56]) << 24) |
-        (((boost::uint32_t)message_block_[56 + 1]) << 16) |
-        (((boost::uint32_t)message_block_[56 + 2]) << 8) |
-        (((boost::uint32_t)message_block_[56 + 3]));
-    W[15] = (((boost::uint32_t)message_block_[60]) << 24) |
-        (((boost::uint32_t)message_block_[60 + 1]) << 16) |
-        (((boost::uint32_t)message_block_[60 + 2]) << 8) |
-        (((boost::uint32_t)message_block_[60 + 3]));
+    W[0] = (((boost::uint32_t)block[0]) << 24) |
+        (((boost::uint32_t)block[0 + 1]) << 16) |
+        (((boost::uint32_t)block[0 + 2]) << 8) |
+        (((boost::uint32_t)block[0 + 3]));
+    W[1] = (((boost::uint32_t)block[4]) << 24) |
+        (((boost::uint32_t)block[4 + 1]) << 16) |
+        (((boost::uint32_t)block[4 + 2]) << 8) |
+        (((boost::uint32_t)block[4 + 3]));
+    W[2] = (((boost::uint32_t)block[8]) << 24) |
+        (((boost::uint32_t)block[8 + 1]) << 16) |
+        (((boost::uint32_t)block[8 + 2]) << 8) |
+        (((boost::uint32_t)block[8 + 3]));
+    W[3] = (((boost::uint32_t)block[12]) << 24) |
+        (((boost::uint32_t)block[12 + 1]) << 16) |
+        (((boost::uint32_t)block[12 + 2]) << 8) |
+        (((boost::uint32_t)block[12 + 3]));
+    W[4] = (((boost::uint32_t)block[16]) << 24) |
+        (((boost::uint32_t)block[16 + 1]) << 16) |
+        (((boost::uint32_t)block[16 + 2]) << 8) |
+        (((boost::uint32_t)block[16 + 3]));
+    W[5] = (((boost::uint32_t)block[20]) << 24) |
+        (((boost::uint32_t)block[20 + 1]) << 16) |
+        (((boost::uint32_t)block[20 + 2]) << 8) |
+        (((boost::uint32_t)block[20 + 3]));
+    W[6] = (((boost::uint32_t)block[24]) << 24) |
+        (((boost::uint32_t)block[24 + 1]) << 16) |
+        (((boost::uint32_t)block[24 + 2]) << 8) |
+        (((boost::uint32_t)block[24 + 3]));
+    W[7] = (((boost::uint32_t)block[28]) << 24) |
+        (((boost::uint32_t)block[28 + 1]) << 16) |
+        (((boost::uint32_t)block[28 + 2]) << 8) |
+        (((boost::uint32_t)block[28 + 3]));
+    W[8] = (((boost::uint32_t)block[32]) << 24) |
+        (((boost::uint32_t)block[32 + 1]) << 16) |
+        (((boost::uint32_t)block[32 + 2]) << 8) |
+        (((boost::uint32_t)block[32 + 3]));
+    W[9] = (((boost::uint32_t)block[36]) << 24) |
+        (((boost::uint32_t)block[36 + 1]) << 16) |
+        (((boost::uint32_t)block[36 + 2]) << 8) |
+        (((boost::uint32_t)block[36 + 3]));
+    W[10] = (((boost::uint32_t)block[40]) << 24) |
+        (((boost::uint32_t)block[40 + 1]) << 16) |
+        (((boost::uint32_t)block[40 + 2]) << 8) |
+        (((boost::uint32_t)block[40 + 3]));
+    W[11] = (((boost::uint32_t)block[44]) << 24) |
+        (((boost::uint32_t)block[44 + 1]) << 16) |
+        (((boost::uint32_t)block[44 + 2]) << 8) |
+        (((boost::uint32_t)block[44 + 3]));
+    W[12] = (((boost::uint32_t)block[48]) << 24) |
+        (((boost::uint32_t)block[48 + 1]) << 16) |
+        (((boost::uint32_t)block[48 + 2]) << 8) |
+        (((boost::uint32_t)block[48 + 3]));
+    W[13] = (((boost::uint32_t)block[52]) << 24) |
+        (((boost::uint32_t)block[52 + 1]) << 16) |
+        (((boost::uint32_t)block[52 + 2]) << 8) |
+        (((boost::uint32_t)block[52 + 3]));
+    W[14] = (((boost::uint32_t)block[56]) << 24) |
+        (((boost::uint32_t)block[56 + 1]) << 16) |
+        (((boost::uint32_t)block[56 + 2]) << 8) |
+        (((boost::uint32_t)block[56 + 3]));
+    W[15] = (((boost::uint32_t)block[60]) << 24) |
+        (((boost::uint32_t)block[60 + 1]) << 16) |
+        (((boost::uint32_t)block[60 + 2]) << 8) |
+        (((boost::uint32_t)block[60 + 3]));
     W[16] = SHA256_sigma1(W[14]) + W[9] + SHA256_sigma0(W[1]) + W[0];
     W[17] = SHA256_sigma1(W[15]) + W[10] + SHA256_sigma0(W[2]) + W[1];
     W[18] = SHA256_sigma1(W[16]) + W[11] + SHA256_sigma0(W[3]) + W[2];
@@ -398,14 +539,14 @@ private:
     W[62] = SHA256_sigma1(W[60]) + W[55] + SHA256_sigma0(W[47]) + W[46];
     W[63] = SHA256_sigma1(W[61]) + W[56] + SHA256_sigma0(W[48]) + W[47];
 
-    A = intermediate_hash_[0];
-    B = intermediate_hash_[1];
-    C = intermediate_hash_[2];
-    D = intermediate_hash_[3];
-    E = intermediate_hash_[4];
-    F = intermediate_hash_[5];
-    G = intermediate_hash_[6];
-    H = intermediate_hash_[7];
+    A = state[0];
+    B = state[1];
+    C = state[2];
+    D = state[3];
+    E = state[4];
+    F = state[5];
+    G = state[6];
+    H = state[7];
 
     temp1 = H + SHA256_SIGMA1(E) + SHA256_CH(E,F,G) + K[0] + W[0];
     temp2 = SHA256_SIGMA0(A) + SHA256_MAJ(A,B,C);
@@ -1048,16 +1189,14 @@ private:
     B = A;
     A = temp1 + temp2;
 
-    intermediate_hash_[0] += A;
-    intermediate_hash_[1] += B;
-    intermediate_hash_[2] += C;
-    intermediate_hash_[3] += D;
-    intermediate_hash_[4] += E;
-    intermediate_hash_[5] += F;
-    intermediate_hash_[6] += G;
-    intermediate_hash_[7] += H;
-
-    message_block_index_ = 0;
+    state[0] += A;
+    state[1] += B;
+    state[2] += C;
+    state[3] += D;
+    state[4] += E;
+    state[5] += F;
+    state[6] += G;
+    state[7] += H;
   }
 }; // end of class
 
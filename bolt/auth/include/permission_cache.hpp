@@ -0,0 +1,110 @@
+#pragma once
+
+#ifdef BOLTAUTH_DLL
+#define BOLTAUTH_API __declspec( dllexport )
+#else
+#define BOLTAUTH_API __declspec( dllimport )
+#endif
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <cpprest/asyncrt_utils.h>
+#include <permissions.hpp>
+
+namespace bolt {
+	namespace auth {
+
+		/// <summary>
+		/// In-memory copy of table_permissions and column_permissions, keyed by folded names.
+		/// Readers work on an immutable snapshot that is swapped atomically, so a lookup
+		/// never takes a lock or touches MySQL. The snapshot is rebuilt in the background
+		/// when the checksum of the grant tables changes, or after invalidate().
+		/// </summary>
+		class PermissionCache
+		{
+		public:
+			virtual ~PermissionCache() {}
+			BOLTAUTH_API static PermissionCache& getInstance();
+
+			/// <summary>
+			/// Looks up a table grant.
+			/// </summary>
+			/// <param name="account">The account name.</param>
+			/// <param name="table_name">The table name.</param>
+			/// <param name="type">The requested permission.</param>
+			/// <param name="granted">Set to the cached grant.</param>
+			/// <returns>false when no snapshot is loaded and the caller has to ask MySQL.</returns>
+			bool hasTablePermission(const utility::string_t& account, const utility::string_t& table_name,
+				Permissions::table_permissions type, bool& granted);
+
+			/// <summary>
+			/// Looks up the grants of a whole column list against the table's column map.
+			/// </summary>
+			/// <param name="account">The account name.</param>
+			/// <param name="table_name">The table name.</param>
+			/// <param name="type">The requested permission.</param>
+			/// <param name="columns">The requested columns.</param>
+			/// <param name="denied">Receives the columns that are not granted.</param>
+			/// <returns>false when no snapshot is loaded and the caller has to ask MySQL.</returns>
+			bool hasColumnPermission(const utility::string_t& account, const utility::string_t& table_name,
+				Permissions::table_permissions type, const std::vector<utility::string_t>& columns, std::vector<utility::string_t>& denied);
+
+			/// <summary>
+			/// Loads both grant tables and swaps in the new snapshot.
+			/// </summary>
+			/// <returns>true when the snapshot was loaded.</returns>
+			BOLTAUTH_API bool reload();
+
+			/// <summary>
+			/// Drops the current grants on the next refresh, whether or not the checksum changed.
+			/// </summary>
+			BOLTAUTH_API void invalidate();
+
+			/// <summary>
+			/// Folds a name to lower case. MySQL compares account, table and column names
+			/// case-insensitively, so the cache does too. Only ASCII letters are folded.
+			/// </summary>
+			static utility::string_t foldName(utility::string_t name)
+			{
+				for (auto& c : name)
+				{
+					if (c >= U('A') && c <= U('Z'))
+						c = static_cast<utility::char_t>(c - U('A') + U('a'));
+				}
+				return name;
+			}
+
+		private:
+			struct Snapshot;
+
+			PermissionCache(void);
+
+			PermissionCache(const PermissionCache& src);
+			PermissionCache &operator=(const PermissionCache& rhs);
+			static std::unique_ptr<PermissionCache> m_instance;
+			static std::once_flag m_instance_flag;
+
+			/// <summary>
+			/// Starts a background refresh when the refresh interval passed.
+			/// Only one refresh runs at a time; readers keep using the old snapshot meanwhile.
+			/// </summary>
+			void refreshIfStale();
+
+			/// <summary>
+			/// Checksum of the grant tables, used as the snapshot version.
+			/// </summary>
+			std::string currentVersion();
+
+			bool load(const std::string& version);
+
+			std::shared_ptr<const Snapshot> m_snapshot;
+
+			std::atomic<long long> m_next_refresh;
+			std::atomic<bool> m_refreshing;
+			std::atomic<bool> m_invalidated;
+			long long m_refresh_interval;
+		};
+	}
+}
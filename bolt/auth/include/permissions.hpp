@@ -32,8 +32,17 @@ public:
 	BOLTAUTH_API bool hasPost(utility::string_t table_name, utility::string_t user, std::vector<utility::string_t> columns);
 	BOLTAUTH_API bool hasDelete(utility::string_t table_name, utility::string_t user, std::vector<utility::string_t> columns);
 	BOLTAUTH_API bool hasMerge(utility::string_t table_name, utility::string_t user, std::vector<utility::string_t> columns);
+
+	/// <summary>
+	/// Checks a whole column list at once and reports the columns that are not granted.
+	/// </summary>
+	/// <returns>true when every column is granted.</returns>
+	BOLTAUTH_API bool hasGet(utility::string_t table_name, utility::string_t user, const std::vector<utility::string_t>& columns, std::vector<utility::string_t>& denied);
+	BOLTAUTH_API bool hasPost(utility::string_t table_name, utility::string_t user, const std::vector<utility::string_t>& columns, std::vector<utility::string_t>& denied);
+	BOLTAUTH_API bool hasDelete(utility::string_t table_name, utility::string_t user, const std::vector<utility::string_t>& columns, std::vector<utility::string_t>& denied);
+	BOLTAUTH_API bool hasMerge(utility::string_t table_name, utility::string_t user, const std::vector<utility::string_t>& columns, std::vector<utility::string_t>& denied);
 private:
 	bool hasTablePermissions(utility::string_t table_name, utility::string_t user, table_permissions type);
-	bool hasTablePermissions(utility::string_t table_name, utility::string_t user, table_permissions type, std::vector<utility::string_t> columns);
+	bool hasTablePermissions(utility::string_t table_name, utility::string_t user, table_permissions type, const std::vector<utility::string_t>& columns, std::vector<utility::string_t>& denied);
 	BoltLog bolt_logger;
 };
\ No newline at end of file
@@ -0,0 +1,86 @@
+#pragma once
+
+#ifdef BOLTAUTH_DLL
+#define BOLTAUTH_API __declspec( dllexport )
+#else
+#define BOLTAUTH_API __declspec( dllimport )
+#endif
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace cryptlite {
+	class sha256;
+	template <typename T> class hmac;
+}
+
+namespace bolt {
+	namespace auth {
+
+		/// <summary>
+		/// Per-account signing keys, held as HMAC-SHA256 contexts with the inner and
+		/// outer pad states already computed. Verifying a signature for a cached
+		/// account does not touch MySQL. Account names come from unauthenticated
+		/// requests, so at most max_cached_keys are kept, least recently used first out.
+		/// </summary>
+		class SigningKeyCache
+		{
+		public:
+			typedef cryptlite::hmac<cryptlite::sha256> signer_type;
+
+			virtual ~SigningKeyCache() {}
+			BOLTAUTH_API static SigningKeyCache& getInstance();
+
+			/// <summary>
+			/// Returns the keyed HMAC context of an account, loading the key on a miss.
+			/// </summary>
+			/// <param name="account">The account name.</param>
+			/// <returns>nullptr when the account has no key.</returns>
+			std::shared_ptr<const signer_type> getSigner(const std::string& account);
+
+			/// <summary>
+			/// Drops the cached key of an account, e.g. after the key was regenerated.
+			/// </summary>
+			/// <param name="account">The account name.</param>
+			BOLTAUTH_API void invalidate(const std::string& account);
+
+			/// <summary>
+			/// Drops all cached keys.
+			/// </summary>
+			BOLTAUTH_API void clear();
+
+		private:
+			static const size_t max_cached_keys = 4096;
+
+			struct Entry
+			{
+				std::shared_ptr<const signer_type> signer;
+				long long expires;
+				// Position in m_recent
+				std::list<std::string>::iterator recent;
+			};
+
+			SigningKeyCache(void);
+
+			/// <summary>
+			/// Stores the entry of an account and marks it most recently used. Expired entries
+			/// and then the least recently used ones are evicted beyond max_cached_keys. m_mutex must be held.
+			/// </summary>
+			void store(const std::string& account, std::shared_ptr<const signer_type> signer, long long expires, long long now);
+
+			SigningKeyCache(const SigningKeyCache& src);
+			SigningKeyCache &operator=(const SigningKeyCache& rhs);
+			static std::unique_ptr<SigningKeyCache> m_instance;
+			static std::once_flag m_instance_flag;
+
+			std::mutex m_mutex;
+			std::unordered_map<std::string, Entry> m_keys;
+			// Cached account names, most recently used first
+			std::list<std::string> m_recent;
+			long long m_ttl;
+		};
+	}
+}
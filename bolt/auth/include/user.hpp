@@ -31,7 +31,18 @@ namespace bolt {
 			std::string getcurrenttime();
 
 			const std::string currentDateTime();
+			/// <summary>
+			/// Reads the signing key of an account.
+			/// </summary>
+			/// <returns>The key, or an empty string when the account is unknown.</returns>
 			BOLTAUTH_API std::string getkey(std::string username);
+
+			/// <summary>
+			/// Reads the signing key of an account, telling an unknown account from a failed lookup.
+			/// </summary>
+			/// <param name="key">Receives the key, empty when the account is unknown.</param>
+			/// <returns>false when MySQL could not be asked.</returns>
+			BOLTAUTH_API bool getkey(std::string username, std::string& key);
 		private:
 			BoltLog bolt_logger;
 		};
@@ -18,25 +18,35 @@ namespace bolt {
 		Connection::Connection()
 		{
 			Config &config = Config::getInstance();
-			std::string host = config.getStdConfigOption(Config::mysql_host);
-			std::string user = config.getStdConfigOption(Config::mysql_user);
-			std::string password = config.getStdConfigOption(Config::mysql_password);
-			std::string database = config.getStdConfigOption(Config::mysql_database);
 
-			setConnectionParams(host, user, password, database);
+			MysqlPoolOptions options;
+			options.host = config.getStdConfigOption(Config::mysql_host);
+			options.port = config.getNumberOption(Config::mysql_port, 1, 65535);
+			options.user = config.getStdConfigOption(Config::mysql_user);
+			options.password = config.getStdConfigOption(Config::mysql_password);
+			options.schema = config.getStdConfigOption(Config::mysql_database);
+
+			options.max_size = config.getNumberOption(Config::auth_pool_max_size, 1, 1024);
+			options.min_size = config.getNumberOption(Config::auth_pool_min_size, 0, options.max_size);
+			options.wait_timeout = std::chrono::milliseconds(config.getNumberOption(Config::auth_pool_wait_timeout, 0, 10 * 60 * 1000));
+			options.idle_timeout = std::chrono::seconds(config.getNumberOption(Config::auth_pool_idle_timeout, 0, 24 * 60 * 60));
+
+			setConnectionParams(options);
 		}
 
-		int Connection::setConnectionParams(std::string host, std::string username, std::string password, std::string db){
-			sql::Driver* m_driver = get_driver_instance();
-			m_connection = std::shared_ptr<sql::Connection>(m_driver->connect(host, username, password));
-			/* Connect to the MySQL test database */
-			m_connection->setSchema(db);
+		int Connection::setConnectionParams(const MysqlPoolOptions& options){
+			m_pool.reset(new MysqlConnectionPool(options));
 			return 0;
 		}
 
-		std::shared_ptr<sql::Connection> Connection::getConnection()
+		MysqlConnectionLease Connection::acquire()
+		{
+			return m_pool->acquire();
+		}
+
+		MysqlPoolStatistics Connection::statistics()
 		{
-			return m_connection;
+			return m_pool->statistics();
 		}
 	}
-}
\ No newline at end of file
+}
@@ -1,14 +1,30 @@
 #include <signature.hpp>
 #include <cryptlite/sha256.h>
-#include <cryptlite/sha256.h>
 #include <cryptlite/hmac.h>
 #include <cryptlite/base64.h>
-#include <user.hpp>
+#include <signing_key_cache.hpp>
 
 using namespace cryptlite;
 
 namespace bolt {
 	namespace auth {
+		/// <summary>
+		/// Compares two strings in time that depends only on their length.
+		/// </summary>
+		static bool constantTimeEquals(const std::string& lhs, const std::string& rhs)
+		{
+			//The length of an encoded HMAC-SHA256 digest is public
+			if (lhs.size() != rhs.size())
+				return false;
+
+			unsigned char diff = 0;
+			for (std::string::size_type i = 0; i < lhs.size(); i++)
+			{
+				diff |= static_cast<unsigned char>(lhs[i] ^ rhs[i]);
+			}
+			return diff == 0;
+		}
+
 		Signature::Signature(utility::string_t  auth_string)
 		{
 			m_auth_string = auth_string;
@@ -40,9 +56,24 @@ namespace bolt {
 			//generate HMAC-SHA256(UTF()) using user key
 			//compare recived hmac and genereated hmac 
 			std::pair<utility::string_t, utility::string_t > userandsignature = splitUserAndPassword();
-			if (userandsignature.second == createSignature(utility::conversions::to_utf8string(userandsignature.first)))
-				return true;
-			return false;
+
+			auto signer = SigningKeyCache::getInstance().getSigner(utility::conversions::to_utf8string(userandsignature.first));
+			if (!signer)
+				return false;
+
+			uint8_t hmacsha256digest[sha256::HASH_SIZE];
+			try
+			{
+				signer->sign(utility::conversions::to_utf8string(m_http_method + U("\n") + m_datetime + U("\n") + m_resource), hmacsha256digest);
+			}
+			catch (const std::length_error&)
+			{
+				//Longer than the HMAC accepts, no valid request carries such a string
+				return false;
+			}
+
+			return constantTimeEquals(base64::encode_from_array(hmacsha256digest, sha256::HASH_SIZE),
+				utility::conversions::to_utf8string(userandsignature.second));
 		}
 
 		std::pair<utility::string_t, utility::string_t > Signature::splitUserAndPassword()
@@ -55,14 +86,21 @@ namespace bolt {
 
 		utility::string_t Signature::createSignature(std::string username)
 		{
+			auto signer = SigningKeyCache::getInstance().getSigner(username);
+			if (!signer)
+				return utility::string_t();
+
 			uint8_t hmacsha256digest[sha256::HASH_SIZE];
-			utility::string_t val_sig = m_http_method + U("\n") + m_datetime + U("\n") + m_resource;
+			try
+			{
+				signer->sign(utility::conversions::to_utf8string(m_http_method + U("\n") + m_datetime + U("\n") + m_resource), hmacsha256digest);
+			}
+			catch (const std::length_error&)
+			{
+				return utility::string_t();
+			}
 
-			User user;
-			std::string usern = user.getkey(username);
-			hmac<sha256>::calc(utility::conversions::to_utf8string(val_sig), usern, hmacsha256digest);
-			utility::string_t signa = utility::conversions::to_string_t(base64::encode_from_array(hmacsha256digest, 32));
-			return signa;
+			return utility::conversions::to_string_t(base64::encode_from_array(hmacsha256digest, sha256::HASH_SIZE));
 		}
 
 		utility::string_t Signature::getUsername() const
@@ -34,19 +34,29 @@ namespace bolt {
 
 		std::string User::getkey(std::string user)
 		{
+			std::string key;
+			getkey(user, key);
+			return key;
+		}
+
+		bool User::getkey(std::string user, std::string& key)
+		{
+			key.clear();
 			try {
 				std::string select_q = "SELECT * FROM auth_users WHERE account_name = ?";
 
-				Connection &con = Connection::GetInstance();
-				std::unique_ptr<sql::PreparedStatement> pre_stmt(con.getConnection()->prepareStatement(select_q));
+				MysqlConnectionLease connection = Connection::GetInstance().acquire();
+				sql::PreparedStatement *pre_stmt = connection.prepareStatement(select_q);
 				pre_stmt->setString(1, user);
 
 				std::unique_ptr<sql::ResultSet> res(pre_stmt->executeQuery());
 
 				if (res->next())
 				{
-					return res->getString("account_key");
+					key = res->getString("account_key");
 				}
+				connection.done();
+				return true;
 			}
 			catch (sql::SQLException &e)
 			{
@@ -56,7 +66,7 @@ namespace bolt {
 					<< ", SQLState: " << e.getSQLState().c_str() << " )";
 			}
 
-			return nullptr;
+			return false;
 		}
 	}
 }
\ No newline at end of file
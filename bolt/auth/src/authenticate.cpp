@@ -7,17 +7,17 @@ namespace bolt {
 		bool Authenticate::getAuthorization(utility::string_t account_name, utility::string_t shared_key)
 		{
 			try {
-				Connection &con = Connection::GetInstance();
-				std::shared_ptr<sql::Connection> connection(con.getConnection());
-				std::unique_ptr<sql::PreparedStatement> prep_stmt(connection->prepareStatement("SELECT user_id FROM auth_users WHERE account_name = ? AND shared_key = ?"));
+				MysqlConnectionLease connection = Connection::GetInstance().acquire();
+				sql::PreparedStatement *prep_stmt = connection.prepareStatement("SELECT user_id FROM auth_users WHERE account_name = ? AND shared_key = ?");
 
 				prep_stmt->setString(1, utility::conversions::to_utf8string(account_name));
 				prep_stmt->setString(2, utility::conversions::to_utf8string(shared_key));
 
 				std::unique_ptr<sql::ResultSet> res(prep_stmt->executeQuery());
 
-				while (res->next())
-					return true;
+				bool authorized = res->next();
+				connection.done();
+				return authorized;
 			}
 			catch (sql::SQLException &e)
 			{
@@ -0,0 +1,243 @@
+#include <permission_cache.hpp>
+#include <connection.hpp>
+#include <configuration.hpp>
+#include <logger.hpp>
+#include <chrono>
+#include <unordered_map>
+#include <pplx/pplxtasks.h>
+
+namespace bolt {
+	namespace auth {
+
+		struct PermissionCache::Snapshot
+		{
+			struct TableGrants
+			{
+				TableGrants() : table_flags(0) {}
+
+				unsigned char table_flags;
+				std::unordered_map<utility::string_t, unsigned char> columns;
+			};
+
+			//Keyed by folded account name and table name, separated by '\0'
+			std::unordered_map<utility::string_t, TableGrants> grants;
+			std::string version;
+
+			static utility::string_t key(const utility::string_t& account, const utility::string_t& table_name)
+			{
+				utility::string_t key;
+				key.reserve(account.size() + table_name.size() + 1);
+				key += account;
+				key.push_back(U('\0'));
+				key += table_name;
+				return PermissionCache::foldName(std::move(key));
+			}
+
+			static unsigned char flag(Permissions::table_permissions type)
+			{
+				return static_cast<unsigned char>(1 << type);
+			}
+		};
+
+		static long long steadyNow()
+		{
+			return std::chrono::duration_cast<std::chrono::milliseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+
+		std::unique_ptr<PermissionCache> PermissionCache::m_instance;
+		std::once_flag PermissionCache::m_instance_flag;
+
+		PermissionCache& PermissionCache::getInstance()
+		{
+			std::call_once(m_instance_flag,
+				[] {
+				m_instance.reset(new PermissionCache);
+			});
+			return *m_instance.get();
+		}
+
+		PermissionCache::PermissionCache() : m_next_refresh(0), m_refreshing(false), m_invalidated(false)
+		{
+			Config &config = Config::getInstance();
+			m_refresh_interval = static_cast<long long>(config.getNumberOption(Config::permission_cache_refresh, 0, 60 * 60)) * 1000;
+			m_next_refresh = steadyNow() + m_refresh_interval;
+		}
+
+		bool PermissionCache::hasTablePermission(const utility::string_t& account, const utility::string_t& table_name,
+			Permissions::table_permissions type, bool& granted)
+		{
+			refreshIfStale();
+
+			std::shared_ptr<const Snapshot> snapshot = std::atomic_load(&m_snapshot);
+			if (!snapshot)
+				return false;
+
+			auto iter = snapshot->grants.find(Snapshot::key(account, table_name));
+			granted = iter != snapshot->grants.end() && (iter->second.table_flags & Snapshot::flag(type)) != 0;
+			return true;
+		}
+
+		bool PermissionCache::hasColumnPermission(const utility::string_t& account, const utility::string_t& table_name,
+			Permissions::table_permissions type, const std::vector<utility::string_t>& columns, std::vector<utility::string_t>& denied)
+		{
+			refreshIfStale();
+
+			std::shared_ptr<const Snapshot> snapshot = std::atomic_load(&m_snapshot);
+			if (!snapshot)
+				return false;
+
+			denied.clear();
+			auto iter = snapshot->grants.find(Snapshot::key(account, table_name));
+			if (iter == snapshot->grants.end())
+			{
+				denied = columns;
+				return true;
+			}
+
+			const unsigned char requested = Snapshot::flag(type);
+			for (const auto& column : columns)
+			{
+				auto column_iter = iter->second.columns.find(PermissionCache::foldName(column));
+				if (column_iter == iter->second.columns.end() || (column_iter->second & requested) == 0)
+					denied.push_back(column);
+			}
+			return true;
+		}
+
+		void PermissionCache::invalidate()
+		{
+			m_invalidated = true;
+			m_next_refresh = 0;
+		}
+
+		void PermissionCache::refreshIfStale()
+		{
+			long long now = steadyNow();
+			if (now < m_next_refresh.load(std::memory_order_relaxed))
+				return;
+
+			bool expected = false;
+			if (!m_refreshing.compare_exchange_strong(expected, true))
+				return;
+
+			m_next_refresh = now + m_refresh_interval;
+
+			pplx::create_task([this]()
+			{
+				try
+				{
+					std::string version = currentVersion();
+					std::shared_ptr<const Snapshot> snapshot = std::atomic_load(&m_snapshot);
+
+					if (m_invalidated.exchange(false) || !snapshot || snapshot->version != version)
+					{
+						load(version);
+					}
+				}
+				catch (sql::SQLException &e)
+				{
+					BoltLog logger;
+					logger << BoltLog::LOG_ERROR << "SQLException in PermissionCache "
+						<< "(refreshIfStale) #ERR: " << e.what() << " (MySQL error code: "
+						<< std::to_string(e.getErrorCode()).c_str()
+						<< ", SQLState: " << e.getSQLState().c_str() << " )";
+				}
+				catch (std::exception &e)
+				{
+					BoltLog logger;
+					logger << BoltLog::LOG_ERROR << "Exception in PermissionCache (refreshIfStale) #ERR: " << e.what();
+				}
+				m_refreshing = false;
+			});
+		}
+
+		bool PermissionCache::reload()
+		{
+			try
+			{
+				m_invalidated = false;
+				return load(currentVersion());
+			}
+			catch (sql::SQLException &e)
+			{
+				BoltLog logger;
+				logger << BoltLog::LOG_ERROR << "SQLException in PermissionCache "
+					<< "(reload) #ERR: " << e.what() << " (MySQL error code: "
+					<< std::to_string(e.getErrorCode()).c_str()
+					<< ", SQLState: " << e.getSQLState().c_str() << " )";
+			}
+			return false;
+		}
+
+		std::string PermissionCache::currentVersion()
+		{
+			//Grants also depend on the account tables, account names are resolved through them
+			MysqlConnectionLease connection = Connection::GetInstance().acquire();
+			std::unique_ptr<sql::Statement> stmt(connection->createStatement());
+			std::unique_ptr<sql::ResultSet> res(stmt->executeQuery("CHECKSUM TABLE table_permissions, column_permissions, account, auth_users"));
+
+			std::string version;
+			while (res->next())
+			{
+				version += res->getString(2);
+				version += ";";
+			}
+			connection.done();
+			return version;
+		}
+
+		bool PermissionCache::load(const std::string& version)
+		{
+			std::shared_ptr<Snapshot> snapshot = std::make_shared<Snapshot>();
+			snapshot->version = version;
+
+			MysqlConnectionLease connection = Connection::GetInstance().acquire();
+			std::unique_ptr<sql::Statement> stmt(connection->createStatement());
+
+			{
+				std::unique_ptr<sql::ResultSet> res(stmt->executeQuery(
+					"SELECT au.account_name, tp.table_name, tp.select_p, tp.insert_p, tp.update_p, tp.delete_p "
+					"FROM table_permissions AS tp, account AS au WHERE tp.account_id = au.id"));
+
+				while (res->next())
+				{
+					unsigned char flags = 0;
+					if (res->getString(3) == "Y") flags |= Snapshot::flag(Permissions::select);
+					if (res->getString(4) == "Y") flags |= Snapshot::flag(Permissions::insert);
+					if (res->getString(5) == "Y") flags |= Snapshot::flag(Permissions::update);
+					if (res->getString(6) == "Y") flags |= Snapshot::flag(Permissions::del);
+
+					auto key = Snapshot::key(utility::conversions::to_string_t(res->getString(1)),
+						utility::conversions::to_string_t(res->getString(2)));
+					//Names differing only in case are the same table to MySQL, any of their grants applies
+					snapshot->grants[key].table_flags |= flags;
+				}
+			}
+
+			{
+				std::unique_ptr<sql::ResultSet> res(stmt->executeQuery(
+					"SELECT au.account_name, tp.table_name, tp.column_name, tp.select_p, tp.insert_p, tp.update_p "
+					"FROM column_permissions AS tp, auth_users AS au WHERE tp.account_id = au.user_id"));
+
+				while (res->next())
+				{
+					unsigned char flags = 0;
+					if (res->getString(4) == "Y") flags |= Snapshot::flag(Permissions::select);
+					if (res->getString(5) == "Y") flags |= Snapshot::flag(Permissions::insert);
+					if (res->getString(6) == "Y") flags |= Snapshot::flag(Permissions::update);
+
+					auto key = Snapshot::key(utility::conversions::to_string_t(res->getString(1)),
+						utility::conversions::to_string_t(res->getString(2)));
+					snapshot->grants[key].columns[PermissionCache::foldName(utility::conversions::to_string_t(res->getString(3)))] |= flags;
+				}
+			}
+
+			connection.done();
+
+			std::shared_ptr<const Snapshot> published(snapshot);
+			std::atomic_store(&m_snapshot, published);
+			return true;
+		}
+	}
+}
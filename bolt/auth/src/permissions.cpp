@@ -1,5 +1,7 @@
 #include <permissions.hpp>
 #include <connection.hpp>
+#include <permission_cache.hpp>
+#include <algorithm>
 using namespace bolt::auth;
 
 bool Permissions::hasGet(utility::string_t table_name, utility::string_t user)
@@ -24,27 +26,56 @@ bool Permissions::hasMerge(utility::string_t table_name, utility::string_t user)
 
 bool Permissions::hasGet(utility::string_t table_name, utility::string_t user, std::vector<utility::string_t> columns)
 {
-	return hasTablePermissions(table_name, user, select, columns);
+	std::vector<utility::string_t> denied;
+	return hasTablePermissions(table_name, user, select, columns, denied);
 }
 
 bool Permissions::hasPost(utility::string_t table_name, utility::string_t user, std::vector<utility::string_t> columns)
 {
-	return hasTablePermissions(table_name, user, insert, columns);
+	std::vector<utility::string_t> denied;
+	return hasTablePermissions(table_name, user, insert, columns, denied);
 }
 
 bool Permissions::hasDelete(utility::string_t table_name, utility::string_t user, std::vector<utility::string_t> columns)
 {
-	return hasTablePermissions(table_name, user, del, columns);
+	std::vector<utility::string_t> denied;
+	return hasTablePermissions(table_name, user, del, columns, denied);
 }
 
 bool Permissions::hasMerge(utility::string_t table_name, utility::string_t user, std::vector<utility::string_t> columns)
 {
-	return hasTablePermissions(table_name, user, update, columns);
+	std::vector<utility::string_t> denied;
+	return hasTablePermissions(table_name, user, update, columns, denied);
+}
+
+bool Permissions::hasGet(utility::string_t table_name, utility::string_t user, const std::vector<utility::string_t>& columns, std::vector<utility::string_t>& denied)
+{
+	return hasTablePermissions(table_name, user, select, columns, denied);
+}
+
+bool Permissions::hasPost(utility::string_t table_name, utility::string_t user, const std::vector<utility::string_t>& columns, std::vector<utility::string_t>& denied)
+{
+	return hasTablePermissions(table_name, user, insert, columns, denied);
+}
+
+bool Permissions::hasDelete(utility::string_t table_name, utility::string_t user, const std::vector<utility::string_t>& columns, std::vector<utility::string_t>& denied)
+{
+	return hasTablePermissions(table_name, user, del, columns, denied);
+}
+
+bool Permissions::hasMerge(utility::string_t table_name, utility::string_t user, const std::vector<utility::string_t>& columns, std::vector<utility::string_t>& denied)
+{
+	return hasTablePermissions(table_name, user, update, columns, denied);
 }
 
 bool Permissions::hasTablePermissions(utility::string_t table_name, utility::string_t user, table_permissions type)
 {
 	bool has_perm = false;
+	if (PermissionCache::getInstance().hasTablePermission(user, table_name, type, has_perm))
+	{
+		return has_perm;
+	}
+
 	try {
 		std::string query = "SELECT ";
 
@@ -62,8 +93,8 @@ bool Permissions::hasTablePermissions(utility::string_t table_name, utility::str
 		}
 
 		query += " FROM table_permissions AS tp, account AS au WHERE tp.table_name = ? AND tp.account_id = au.id AND au.account_name = ?";
-		Connection &con = Connection::GetInstance();
-		std::unique_ptr<sql::PreparedStatement> pre_stmt(con.getConnection()->prepareStatement(query));
+		MysqlConnectionLease connection = Connection::GetInstance().acquire();
+		sql::PreparedStatement *pre_stmt = connection.prepareStatement(query);
 		pre_stmt->setString(1, utility::conversions::to_utf8string(table_name));
 		pre_stmt->setString(2, utility::conversions::to_utf8string(user));
 
@@ -77,6 +108,7 @@ bool Permissions::hasTablePermissions(utility::string_t table_name, utility::str
 			}
 
 		}
+		connection.done();
 
 	}
 	catch (sql::SQLException &e)
@@ -90,54 +122,74 @@ bool Permissions::hasTablePermissions(utility::string_t table_name, utility::str
 	return has_perm;
 }
 
-bool Permissions::hasTablePermissions(utility::string_t table_name, utility::string_t user, table_permissions type, std::vector<utility::string_t> columns)
+bool Permissions::hasTablePermissions(utility::string_t table_name, utility::string_t user, table_permissions type, const std::vector<utility::string_t>& columns, std::vector<utility::string_t>& denied)
 {
-	bool has_perm = false;
+	if (columns.empty())
+	{
+		denied.clear();
+		return false;
+	}
 
-	for (int i = 0; i < columns.size(); i++)
+	if (PermissionCache::getInstance().hasColumnPermission(user, table_name, type, columns, denied))
 	{
-		try {
-			std::string query = "SELECT ";
+		return denied.empty();
+	}
 
-			switch (type)
-			{
-			case select:
-				query += "tp.select_p"; break;
-			case insert:
-				query += "tp.insert_p"; break;
-			case update:
-				query += "tp.update_p"; break;
-			default: break;
-			}
+	//Cache not loaded, every column is denied unless the single query below grants it
+	denied = columns;
 
-			query += " FROM column_permissions AS tp, auth_users AS au WHERE tp.table_name = ? AND tp.column_name = ?  AND tp.account_id = au.user_id AND au.account_name = ?";
-			
-			Connection &con = Connection::GetInstance();
-			std::unique_ptr<sql::PreparedStatement> pre_stmt(con.getConnection()->prepareStatement(query));
-			
-			pre_stmt->setString(1, utility::conversions::to_utf8string(table_name));
-			pre_stmt->setString(2, utility::conversions::to_utf8string(columns[i]));
-			pre_stmt->setString(3, utility::conversions::to_utf8string(user));
+	std::string query = "SELECT tp.column_name, ";
+	switch (type)
+	{
+	case select:
+		query += "tp.select_p"; break;
+	case insert:
+		query += "tp.insert_p"; break;
+	case update:
+		query += "tp.update_p"; break;
+	default:
+		//column_permissions has no delete grant
+		return false;
+	}
 
-			std::unique_ptr<sql::ResultSet> res(pre_stmt->executeQuery());
+	query += " FROM column_permissions AS tp, auth_users AS au WHERE tp.table_name = ? AND tp.account_id = au.user_id AND au.account_name = ? AND tp.column_name IN (";
+	for (size_t i = 0; i < columns.size(); i++)
+	{
+		query += (i == 0) ? "?" : ",?";
+	}
+	query += ")";
 
-			if (res->next())
-			{
-				if (res->getString(1) == "N")
-				{
-					has_perm = false;
-					continue;
-				}
-				has_perm = true;
-			}
+	try {
+		MysqlConnectionLease connection = Connection::GetInstance().acquire();
+		sql::PreparedStatement *pre_stmt = connection.prepareStatement(query);
+
+		pre_stmt->setString(1, utility::conversions::to_utf8string(table_name));
+		pre_stmt->setString(2, utility::conversions::to_utf8string(user));
+		for (size_t i = 0; i < columns.size(); i++)
+		{
+			pre_stmt->setString(static_cast<unsigned int>(i + 3), utility::conversions::to_utf8string(columns[i]));
 		}
-		catch (sql::SQLException &e)
+
+		std::unique_ptr<sql::ResultSet> res(pre_stmt->executeQuery());
+
+		while (res->next())
 		{
-			bolt_logger << BoltLog::LOG_ERROR << "SQLException in User "
-				<< "(getkey) #ERR: " << e.what() << " (MySQL error code: "
-				<< std::to_string(e.getErrorCode()).c_str()
-				<< ", SQLState: " << e.getSQLState().c_str() << " )";
+			if (res->getString(2) == "Y")
+			{
+				auto column = PermissionCache::foldName(utility::conversions::to_string_t(res->getString(1)));
+				denied.erase(std::remove_if(denied.begin(), denied.end(),
+					[&column](const utility::string_t& name) { return PermissionCache::foldName(name) == column; }), denied.end());
+			}
 		}
+		connection.done();
 	}
-	return has_perm;
-}
\ No newline at end of file
+	catch (sql::SQLException &e)
+	{
+		denied = columns;
+		bolt_logger << BoltLog::LOG_ERROR << "SQLException in Permissions "
+			<< "(hasTablePermissions) #ERR: " << e.what() << " (MySQL error code: "
+			<< std::to_string(e.getErrorCode()).c_str()
+			<< ", SQLState: " << e.getSQLState().c_str() << " )";
+	}
+	return denied.empty();
+}
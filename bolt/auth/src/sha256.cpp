@@ -124,10 +124,12 @@ std::string sha256(std::string input)
 	ctx.update( (unsigned char*)input.c_str(), input.length());
 	ctx.final(digest);
 
-	char buf[2*SHA256::DIGEST_SIZE+1];
-	buf[2*SHA256::DIGEST_SIZE] = 0;
-	for (int i = 0; i < SHA256::DIGEST_SIZE; i++)
-		sprintf(buf+i*2, "%02x", digest[i]);
-	return std::string(buf);
+	static const char hex_digits[] = "0123456789abcdef";
+	char buf[2*SHA256::DIGEST_SIZE];
+	for (int i = 0; i < SHA256::DIGEST_SIZE; i++) {
+		buf[i*2] = hex_digits[digest[i] >> 4];
+		buf[i*2+1] = hex_digits[digest[i] & 0xf];
+	}
+	return std::string(buf, sizeof(buf));
 }
 #pragma warning(pop)
\ No newline at end of file
@@ -0,0 +1,129 @@
+#include <signing_key_cache.hpp>
+#include <cryptlite/sha256.h>
+#include <cryptlite/hmac.h>
+#include <configuration.hpp>
+#include <user.hpp>
+#include <chrono>
+
+namespace bolt {
+	namespace auth {
+
+		//Unknown accounts are remembered briefly so new accounts can sign in soon after they are created
+		static const long long negative_ttl = 10000;
+
+		static long long steadyNow()
+		{
+			return std::chrono::duration_cast<std::chrono::milliseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+
+		std::unique_ptr<SigningKeyCache> SigningKeyCache::m_instance;
+		std::once_flag SigningKeyCache::m_instance_flag;
+
+		SigningKeyCache& SigningKeyCache::getInstance()
+		{
+			std::call_once(m_instance_flag,
+				[] {
+				m_instance.reset(new SigningKeyCache);
+			});
+			return *m_instance.get();
+		}
+
+		SigningKeyCache::SigningKeyCache()
+		{
+			Config &config = Config::getInstance();
+			m_ttl = static_cast<long long>(config.getNumberOption(Config::signing_key_cache_ttl, 0, 24 * 60 * 60)) * 1000;
+		}
+
+		std::shared_ptr<const SigningKeyCache::signer_type> SigningKeyCache::getSigner(const std::string& account)
+		{
+			long long now = steadyNow();
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				auto iter = m_keys.find(account);
+				if (iter != m_keys.end() && now < iter->second.expires)
+				{
+					m_recent.splice(m_recent.begin(), m_recent, iter->second.recent);
+					return iter->second.signer;
+				}
+			}
+
+			//Load outside the lock, a concurrent miss for the same account only costs a second lookup
+			std::string key;
+			if (!User().getkey(account, key))
+			{
+				//A failed lookup is not cached, the account is asked for again on the next request
+				return nullptr;
+			}
+
+			std::shared_ptr<const signer_type> signer;
+			long long expires = now + negative_ttl;
+			if (!key.empty())
+			{
+				signer = std::make_shared<signer_type>(key);
+				expires = now + m_ttl;
+			}
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+			store(account, signer, expires, now);
+			return signer;
+		}
+
+		void SigningKeyCache::store(const std::string& account, std::shared_ptr<const signer_type> signer, long long expires, long long now)
+		{
+			auto iter = m_keys.find(account);
+			if (iter == m_keys.end())
+			{
+				if (m_keys.size() >= max_cached_keys)
+				{
+					//Expired entries go first, unknown accounts are mostly among them
+					for (auto recent = m_recent.begin(); recent != m_recent.end();)
+					{
+						auto expired = m_keys.find(*recent);
+						if (now < expired->second.expires)
+						{
+							++recent;
+							continue;
+						}
+						m_keys.erase(expired);
+						recent = m_recent.erase(recent);
+					}
+				}
+				while (m_keys.size() >= max_cached_keys)
+				{
+					m_keys.erase(m_recent.back());
+					m_recent.pop_back();
+				}
+
+				m_recent.push_front(account);
+				iter = m_keys.insert(std::make_pair(account, Entry())).first;
+				iter->second.recent = m_recent.begin();
+			}
+			else
+			{
+				m_recent.splice(m_recent.begin(), m_recent, iter->second.recent);
+			}
+
+			iter->second.signer = signer;
+			iter->second.expires = expires;
+		}
+
+		void SigningKeyCache::invalidate(const std::string& account)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			auto iter = m_keys.find(account);
+			if (iter != m_keys.end())
+			{
+				m_recent.erase(iter->second.recent);
+				m_keys.erase(iter);
+			}
+		}
+
+		void SigningKeyCache::clear()
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_keys.clear();
+			m_recent.clear();
+		}
+	}
+}
@@ -4,6 +4,7 @@
 #include <cpprest/http_msg.h>
 #include <cpprest/json.h>
 #include <permissions.hpp>
+#include <url_utils.hpp>
 
 using namespace web;
 using namespace bolt::storage;
@@ -11,14 +12,17 @@ using namespace bolt::storage;
 class AzureHandler 
 {
 public:
-	AzureHandler(const http::http_request &request, http::method method);
+	AzureHandler(const http::http_request &request, http::method method, const Route &route);
 	void InitializeHandlers();
 	void HandleGet();
 	void HandlePost();
 	void HandleDelete();
 	void HandlePatch();
+	void HandleBatch(const utility::string_t &table_name);
 private:
+	void replyWhenReady(http::status_code status, pplx::task<json::value> body);
 	void insetKeyValuePropery(boltazure::AzureEntity &entity, utility::string_t key, json::value value);
 	const http::http_request &m_http_request;
+	const Route &m_route;
 	http::method m_method;
 };
\ No newline at end of file
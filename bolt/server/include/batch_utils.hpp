@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cpprest/http_msg.h>
+#include <cpprest/json.h>
+
+using namespace std;
+using namespace web;
+using namespace web::http;
+
+/// <summary>
+/// Helpers shared by the $batch endpoints of the storage handlers.
+/// </summary>
+class BatchUtils
+{
+public:
+	BatchUtils() { }
+	~BatchUtils() { }
+
+	/// <summary>
+	/// Reads the entities of a batch request. The body is either a JSON array
+	/// or newline-delimited JSON with one entity per line.
+	/// </summary>
+	/// <param name="message">The request.</param>
+	/// <param name="entities">Receives the entities.</param>
+	/// <returns>false when the body could not be parsed.</returns>
+	static bool extractEntities(const http_request& message, vector<json::value>& entities);
+
+	/// <summary>
+	/// Gets PartitionKey and RowKey of an entity.
+	/// </summary>
+	/// <returns>false when the entity is not an object or lacks one of the keys.</returns>
+	static bool getKeys(const json::value& entity, utility::string_t& partition_key, utility::string_t& row_key);
+
+	/// <summary>
+	/// Builds the result entry of one entity.
+	/// </summary>
+	static json::value entityResult(size_t index, const json::value& entity, status_code status, const utility::string_t& error);
+
+	/// <summary>
+	/// Builds the response body from the entity results.
+	/// </summary>
+	static json::value response(const vector<json::value>& results);
+};
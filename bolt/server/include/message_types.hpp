@@ -1,5 +1,8 @@
 #define FILTER U("$filter")
 #define SELECT U("$select")
+#define TOP U("$top")
+#define NEXT_PARTITION_KEY U("NextPartitionKey")
+#define NEXT_ROW_KEY U("NextRowKey")
 #define ROWKEY U("RowKey")
 #define PARTITIONKEY U("PartitionKey")
 
@@ -1,7 +1,10 @@
 #include<deque>
 #include <cpprest/json.h>
+#include <cpprest/http_msg.h>
 #include <mysql_incognito_entity.h>
 #include <mysql_entity.h>
+#include <mysql_query.h>
+#include <url_utils.hpp>
 #include <map>
 
 using namespace web;
@@ -16,19 +19,53 @@ public:
 	static json::value getAzureTables();
 	static json::value getAzureTable(string_t table_name);
 	static json::value getMysqlTable(string_t table_name);
-	static json::value getAzureEntity(string_t table_name, string_t rowkey, string_t partitionkey);
+	/// <summary>
+	/// Gets an entity without blocking the calling thread.
+	/// </summary>
+	static pplx::task<json::value> getAzureEntity(string_t table_name, string_t rowkey, string_t partitionkey);
 	static json::value getMysqlEntity(string_t table_name, string_t rowkey, string_t partitionkey);
-	static json::value getMysqlEntities(string_t table_name, const std::map<utility::string_t, utility::string_t> query);
+
+	/// <summary>
+	/// Replies with one page of the entities of route.table with chunked transfer encoding. The page is read
+	/// from MySQL row by row into serialized chunks, and written once the connection is back in the pool.
+	/// When more entities follow, the body ends with the NextPartitionKey and NextRowKey of the next page.
+	/// </summary>
+	/// <param name="message">The request to reply to.</param>
+	/// <param name="route">The route, $select, $filter, $top and the continuation are applied.</param>
+	static void replyMysqlEntities(const web::http::http_request &message, const Route &route);
 	static bool getMysqlQueryResults(const json::object &query_obj, json::value &result);
 	static bool getAdministration(const std::vector<utility::string_t> paths, json::value &result);
+	/// <summary>
+	/// Drops server caches, the caller must already be checked as an administrator.
+	/// </summary>
+	static bool deleteAdministration(const std::vector<utility::string_t> paths, json::value &result);
 
-	static json::value getAzureEntities(string_t table_name, const std::map<utility::string_t, utility::string_t> query);
+	/// <summary>
+	/// Gets one page of the entities of route.table, with NextPartitionKey and NextRowKey when more follow.
+	/// The query is sent before returning, the page is read without blocking the calling thread.
+	/// </summary>
+	/// <param name="route">The route, $select, $filter, $top and the continuation are applied.</param>
+	static pplx::task<json::value> getAzureEntities(const Route &route);
 	
 private:
 	template <class container>
 	static json::value generateEntityMeta(container entity_vector);
 	template <class container>
 	static json::value generateAzureEntityMeta(container entity_vector);
-	static utility::string_t getCondition(string_t condition);
+	template <class entity_type>
+	static json::value generateAzureEntity(const entity_type &entity);
+	static json::value generateAzureEntity(const bolt::storage::mysql::mysql_table_entity &entity);
+	/// <summary>
+	/// Builds the reply of a MySQL query straight from its columns, without an entity per row.
+	/// </summary>
+	static json::value generateAzureEntityMeta(const bolt::storage::mysql::mysql_result_set &result);
+	static json::value generateAzureEntity(const bolt::storage::mysql::mysql_result_set::row &row);
+	/// <summary>
+	/// Builds the query of a GET on a collection.
+	/// With a limit the rows are ordered by PartitionKey and RowKey, and start at the given keys.
+	/// </summary>
+	static bolt::storage::mysql::MysqlQuery buildMysqlEntitiesQuery(string_t table_name, const std::map<utility::string_t, utility::string_t> query, const ODataFilter &filter,
+		const string_t &next_partition_key = string_t(), const string_t &next_row_key = string_t(), size_t limit = 0);
+	static json::value getPoolStatistics();
 
 };
\ No newline at end of file
@@ -1,12 +1,10 @@
 #include <cpprest/json.h>
-#include <map>
+#include <odata_filter.hpp>
 using namespace  web;
 
 class MHttpDelete
 {
 public:
 	MHttpDelete() {};
-	static bool deleteEntities(utility::string_t tablename, std::map<utility::string_t, utility::string_t> const query);
-private:
-	static utility::string_t getCondition(utility::string_t condition);
+	static bool deleteEntities(utility::string_t tablename, const ODataFilter &filter);
 };
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include <cpprest/json.h>
 #include <permissions.hpp>
 #include <mysql_entity.h>
+#include <url_utils.hpp>
 
 using namespace std;
 using namespace web;
@@ -13,14 +14,16 @@ using namespace bolt::storage::mysql;
 class MysqlHandler 
 {
 public:
-	MysqlHandler(const http_request &request, method method);
+	MysqlHandler(const http_request &request, method method, const Route &route);
 	void InitializeHandlers();
 	void HandleGet();
 	void HandlePost();
 	void HandleDelete();
 	void HandlePatch();
+	void HandleBatch(const utility::string_t &table_name);
 	void insetKeyValuePropery(MysqlEntity &entity, utility::string_t key, json::value value);
 private:
 	const http_request &m_http_request;
+	const Route &m_route;
 	method m_method;
 };
\ No newline at end of file
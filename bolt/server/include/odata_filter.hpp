@@ -0,0 +1,99 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cpprest/asyncrt_utils.h>
+#include <mysql_property.h>
+
+/// <summary>
+/// A parsed OData $filter expression.
+/// Supports comparisons (eq, ne, gt, ge, lt, le) between a property and a typed literal,
+/// combined with and, or, not and parentheses. Literals are strings ('a''b'), integers (1, 1L),
+/// doubles (1.5, 1e3), true/false, datetime'...' and guid'...'.
+/// A bare word on the value side is read as a string, as the old two clause filter did.
+/// </summary>
+class ODataFilter
+{
+public:
+	enum class node_type
+	{
+		and_node,
+		or_node,
+		not_node,
+		comparison
+	};
+
+	enum class literal_type
+	{
+		string,
+		boolean,
+		int32,
+		int64,
+		double_floating_point,
+		datetime,
+		guid
+	};
+
+	struct Literal
+	{
+		Literal() : type(literal_type::string), boolean_value(false), int_value(0), double_value(0) {}
+
+		literal_type type;
+		//Text of the literal, unquoted and unescaped
+		utility::string_t text;
+		bool boolean_value;
+		int64_t int_value;
+		double double_value;
+	};
+
+	struct Node
+	{
+		Node() : type(node_type::comparison) {}
+
+		node_type type;
+		//Operands of and/or, not only uses left
+		std::shared_ptr<const Node> left;
+		std::shared_ptr<const Node> right;
+
+		//Comparison: property comparison value
+		utility::string_t property;
+		utility::string_t comparison;
+		Literal value;
+	};
+
+	ODataFilter() : m_comparisons(0) {}
+
+	/// <summary>
+	/// Parses a $filter expression.
+	/// </summary>
+	/// <param name="expression">The expression.</param>
+	/// <param name="filter">Receives the parsed filter.</param>
+	/// <param name="error">Receives the reason when the expression is invalid.</param>
+	/// <returns>true when the expression was parsed.</returns>
+	static bool parse(const utility::string_t &expression, ODataFilter &filter, utility::string_t &error);
+
+	bool empty() const { return !m_root; }
+	const std::shared_ptr<const Node> &root() const { return m_root; }
+
+	/// <summary>
+	/// Number of comparisons in the expression.
+	/// </summary>
+	size_t comparisons() const { return m_comparisons; }
+
+	/// <summary>
+	/// Compiles the filter into a MySQL condition with ? placeholders.
+	/// </summary>
+	/// <param name="parameters">Receives the values of the placeholders, in order.</param>
+	/// <returns>The condition, empty when there is no filter.</returns>
+	utility::string_t toSql(std::vector<bolt::storage::mysql::mysql_property> &parameters) const;
+
+	/// <summary>
+	/// Compiles the filter into an Azure table filter string.
+	/// </summary>
+	/// <returns>The filter string, empty when there is no filter.</returns>
+	utility::string_t toAzure() const;
+
+private:
+	std::shared_ptr<const Node> m_root;
+	size_t m_comparisons;
+};
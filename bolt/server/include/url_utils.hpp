@@ -1,17 +1,63 @@
 #pragma once
 
 #include <cpprest/http_msg.h>
+#include <odata_filter.hpp>
 
 using namespace std;
 using namespace web::http;
 using namespace utility;
 
+/// <summary>
+/// Request path and query string, parsed once per request by UrlUtils::parseRoute
+/// and handed to the handlers.
+/// </summary>
+struct Route
+{
+	enum class route_type
+	{
+		none,
+		tables,			// Tables
+		table,			// Tables('name')
+		collection,		// name or name()
+		entity,			// name(PartitionKey='pk',RowKey='rk')
+		query,			// Query
+		administration	// Administration/...
+	};
+
+	Route() : type(route_type::none), batch(false), top(0) {}
+
+	route_type type;
+	string_t table;
+	string_t partition_key;
+	string_t row_key;
+	//Second segment is $batch
+	bool batch;
+
+	vector<string_t> paths;
+	map<string_t, string_t> query;
+
+	//Parsed $filter, empty without one
+	ODataFilter filter;
+	//$top, 0 without one
+	size_t top;
+	//Continuation of a paged GET, the keys of the first entity to return
+	string_t next_partition_key;
+	string_t next_row_key;
+	//Why $filter or $top could not be parsed, empty when they are valid
+	string_t query_error;
+};
+
 class UrlUtils
 {
 public:
 	UrlUtils() {}
 	~UrlUtils() {}
 
+	/// <summary>
+	/// Parses the request path and query string in one pass, without regular expressions.
+	/// </summary>
+	static Route parseRoute(const http_request& message);
+
 	static vector<string_t> splitUri(const http_request& message);
 	static map<string_t, string_t> splitQueryString(const http_request& message);
 
@@ -24,6 +70,7 @@ public:
 	static bool hasQuery(const vector<string_t> paths);
 
 	static bool hasAdministration(const vector<string_t> paths);
+	static bool hasBatch(const vector<string_t> paths);
 
 	static bool getTableNameWithKeys(const vector<string_t> paths, string_t &table, string_t &rowkey, string_t &paritionkey);
 	static bool getTableNameWithoutKeys(const vector<string_t> paths, string_t &table);
@@ -40,8 +87,20 @@ public:
 	static bool hasStatus(const vector<string_t> paths);
 	static bool hasPlugins(const vector<string_t> paths);
 	static bool hasOpenTables(const vector<string_t> paths);
+	static bool hasPools(const vector<string_t> paths);
+	static bool hasGrants(const vector<string_t> paths);
+	static bool getSigningKeys(const vector<string_t> paths, string_t& account);
 
-	static bool getFilter(const map<string_t, string_t> query, map<string_t, string_t> &filter);
+	/// <summary>
+	/// Parses $filter.
+	/// </summary>
+	/// <returns>false when there is no $filter, or error is set when it is invalid.</returns>
+	static bool getFilter(const map<string_t, string_t> &query, ODataFilter &filter, string_t &error);
+	/// <summary>
+	/// Parses $top.
+	/// </summary>
+	/// <returns>false when $top is not a positive number.</returns>
+	static bool getTop(const map<string_t, string_t> &query, size_t &top);
 	static bool getSelect(const map < string_t, string_t> query, vector<string_t> &select);
 	static vector<string_t> getColumnNames(string_t str);
 
@@ -5,6 +5,8 @@
 #include <cpprest/http_msg.h>
 #include <cpprest/json.h>
 #include <permissions.hpp>
+#include <url_utils.hpp>
+#include <blocking_executor.hpp>
 
 using namespace web;
 using namespace bolt::storage;
@@ -12,7 +14,7 @@ using namespace bolt::storage;
 class WholeHandler 
 {
 public:
-	WholeHandler(const http::http_request &request, http::method method);
+	WholeHandler(const http::http_request &request, http::method method, const Route &route, BlockingExecutor &executor);
 	void InitializeHandlers();
 	void HandleGet();
 	void HandlePost();
@@ -20,7 +22,10 @@ public:
 private:
 	void insetKeyValuePropery(boltazure::AzureEntity &entity, utility::string_t key, json::value value);
 	void insetKeyValuePropery(mysql::MysqlEntity &entity, utility::string_t key, json::value value);
+	bool writeEntity(boltazure::AzureEntity azure_entity, mysql::MysqlEntity mysql_entity);
 	const http::http_request &m_http_request;
+	const Route &m_route;
 	http::method m_method;
+	BlockingExecutor &m_executor;
 	std::unique_ptr<Permissions> permissions;
 };
\ No newline at end of file
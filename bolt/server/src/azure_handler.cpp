@@ -4,6 +4,8 @@
 #include <header_utils.hpp>
 #include "azure_query.h"
 #include "azure_table.h"
+#include "azure_batch.h"
+#include <batch_utils.hpp>
 #include <signature.hpp>
 #include "was/table.h"
 #include <metadata.hpp>
@@ -14,11 +16,40 @@ using namespace storage;
 using namespace bolt::storage;
 using namespace bolt::auth;
 
-AzureHandler::AzureHandler(const http_request &request, const method method) : m_http_request(request)
+AzureHandler::AzureHandler(const http_request &request, const method method, const Route &route) : m_http_request(request), m_route(route)
 {
 	m_method = method;
 }
 
+/// <summary>
+/// Replies once an asynchronous storage call completes, the calling thread does not wait for it.
+/// </summary>
+void AzureHandler::replyWhenReady(status_code status, pplx::task<json::value> body)
+{
+	//The handler is gone by the time the body is ready, the continuation holds its own copy of the request
+	http_request message = m_http_request;
+	body.then([message, status](pplx::task<json::value> result)
+	{
+		//Nothing may escape, the continuation is not observed and an unobserved failure terminates
+		try
+		{
+			message.reply(status, result.get());
+			return;
+		}
+		catch (const std::exception &e)
+		{
+			BoltLog logger;
+			logger << BoltLog::LOG_ERROR << "Azure request failed: " << e.what();
+		}
+		catch (...)
+		{
+			BoltLog logger;
+			logger << BoltLog::LOG_ERROR << "Azure request failed";
+		}
+		message.reply(status_codes::InternalError);
+	});
+}
+
 void AzureHandler::InitializeHandlers()
 {
 	if (m_method == methods::GET)
@@ -44,41 +75,28 @@ void AzureHandler::InitializeHandlers()
 /// </summary>
 void AzureHandler::HandleGet()
 {
-	auto paths = UrlUtils::splitUri(m_http_request);
-	auto query = UrlUtils::splitQueryString(m_http_request);
-
-
-	//Requested table name
-	string_t table_name;
-	string_t rowkey;
-	string_t partitionkey;
-
-
-	if (paths.empty())
+	if (m_route.paths.empty())
 	{
 		m_http_request.reply(status_codes::BadRequest);
 		return;
 	}
 
-	if (UrlUtils::hasTables(paths))
+	if (m_route.type == Route::route_type::tables)
 	{
 		m_http_request.reply(status_codes::OK, Metadata::getAzureTables());
 		return;
 	}
 
-	if (UrlUtils::getTableNameWithKeys(paths, table_name, rowkey, partitionkey))
+	//if partition key and row key found we are good to go
+	if (m_route.type == Route::route_type::entity)
 	{
-		//if partition key and row key found we are good to go
-		if (!(rowkey.empty() && partitionkey.empty()))
-		{
-			m_http_request.reply(status_codes::OK, Metadata::getAzureEntity(table_name, rowkey, partitionkey));
-			return;
-		}
+		replyWhenReady(status_codes::OK, Metadata::getAzureEntity(m_route.table, m_route.row_key, m_route.partition_key));
+		return;
 	}
 
-	if (UrlUtils::getTableNameWithoutKeys(paths, table_name))
+	if (m_route.type == Route::route_type::collection)
 	{
-		m_http_request.reply(status_codes::OK, Metadata::getAzureEntities(table_name, query));
+		replyWhenReady(status_codes::OK, Metadata::getAzureEntities(m_route));
 		return;
 	}
 
@@ -91,19 +109,16 @@ void AzureHandler::HandleGet()
 void AzureHandler::HandlePost()
 {
 	http_headers headers = m_http_request.headers();
-	auto paths = UrlUtils::splitUri(m_http_request);
 
-	if (paths.empty())
+	if (m_route.paths.empty())
 	{
 		m_http_request.reply(status_codes::BadRequest);
 		return;
 	}
 
-	//Requested table name
-	string_t table_name;
 	string_t table_namespace;
 
-	if (!UrlUtils::getTableNamespace(paths, table_namespace))
+	if (!UrlUtils::getTableNamespace(m_route.paths, table_namespace))
 	{
 		m_http_request.reply(status_codes::Unauthorized);
 		return;
@@ -111,7 +126,7 @@ void AzureHandler::HandlePost()
 
 	// continue when the response is available
 	// and continue when the JSON value is available
-	if (UrlUtils::hasTables(paths))
+	if (m_route.type == Route::route_type::tables)
 	{
 		json::value obj;
 		try
@@ -134,11 +149,20 @@ void AzureHandler::HandlePost()
 	}
 	// get the JSON value from the task and display content from it
 
-	if (!UrlUtils::getTableNameWithoutKeys(paths, table_name))
+	if (m_route.type != Route::route_type::collection)
 	{
 		m_http_request.reply(status_codes::BadRequest);
 		return;
 	}
+
+	const string_t &table_name = m_route.table;
+
+	if (m_route.batch)
+	{
+		HandleBatch(table_name);
+		return;
+	}
+
 	json::value obj;
 	try
 	{
@@ -209,18 +233,11 @@ void AzureHandler::HandlePost()
 
 void AzureHandler::HandleDelete()
 {
-	auto paths = UrlUtils::splitUri(m_http_request);
-	auto query = UrlUtils::splitQueryString(m_http_request);
-
-	//Requested table name
-	string_t table_name;
-
-	//Table name checks for "Table('table_name')" 
-	//and assings the table name to the given variable
-	if (UrlUtils::getTableName(paths, table_name))
+	//Table('table_name') deletes the table itself
+	if (m_route.type == Route::route_type::table)
 	{
 		boltazure::AzureTable table = boltazure::AzureTable();
-		if (table.deleteTable(table_name))
+		if (table.deleteTable(m_route.table))
 		{
 			m_http_request.reply(status_codes::NoContent);
 			return;
@@ -229,9 +246,9 @@ void AzureHandler::HandleDelete()
 		return;
 	}
 
-	if (UrlUtils::getTableNameWithoutKeys(paths, table_name))
+	if (m_route.type == Route::route_type::collection)
 	{
-		if (AHttpDelete::deleteEntities(table_name, query))
+		if (AHttpDelete::deleteEntities(m_route.table, m_route.filter))
 		{
 			m_http_request.reply(status_codes::NoContent);
 			return;
@@ -246,24 +263,16 @@ void AzureHandler::HandleDelete()
 void AzureHandler::HandlePatch()
 {
 	http_headers headers = m_http_request.headers();
-	auto paths = UrlUtils::splitUri(m_http_request);
-
-	//Requested table name
-	string_t table_name;
-	string_t partition_key;
-	string_t row_key;
 
-	if (paths.empty())
+	if (m_route.type != Route::route_type::entity)
 	{
 		m_http_request.reply(status_codes::BadRequest);
 		return;
 	}
 
-	if (!UrlUtils::getTableNameWithKeys(paths, table_name, row_key, partition_key))
-	{
-		m_http_request.reply(status_codes::BadRequest);
-		return;
-	}
+	const string_t &table_name = m_route.table;
+	const string_t &partition_key = m_route.partition_key;
+	const string_t &row_key = m_route.row_key;
 
 	// get the JSON value from the task and display content from it
 
@@ -296,7 +305,7 @@ void AzureHandler::HandlePatch()
 
 			if (entity.patchEntity())
 			{
-				m_http_request.reply(status_codes::Created, Metadata::getAzureEntity(table_name, row_key, partition_key));
+				replyWhenReady(status_codes::Created, Metadata::getAzureEntity(table_name, row_key, partition_key));
 				return;
 			}
 			else
@@ -310,6 +319,56 @@ void AzureHandler::HandlePatch()
 	m_http_request.reply(status_codes::BadRequest);
 }
 
+/// <summary>
+/// Handles a batch of entities posted to table/$batch.
+/// Entities are sent in entity group transactions of up to 100 per PartitionKey.
+/// </summary>
+void AzureHandler::HandleBatch(const utility::string_t &table_name)
+{
+	vector<json::value> entities;
+	if (!BatchUtils::extractEntities(m_http_request, entities))
+	{
+		m_http_request.reply(status_codes::BadRequest);
+		return;
+	}
+
+	vector<json::value> results(entities.size());
+	vector<size_t> queued;
+	boltazure::AzureTable azure_table = boltazure::AzureTable(table_name);
+	boltazure::AzureBatch batch(azure_table.getTable());
+
+	for (size_t i = 0; i < entities.size(); ++i)
+	{
+		string_t partition_key;
+		string_t row_key;
+		if (!BatchUtils::getKeys(entities[i], partition_key, row_key))
+		{
+			results[i] = BatchUtils::entityResult(i, entities[i], status_codes::BadRequest, U("PartitionKey and RowKey are required"));
+			continue;
+		}
+
+		boltazure::AzureEntity entity(azure_table.getTable(), partition_key, row_key, entities[i].as_object().size());
+		for (auto& pair : entities[i].as_object())
+		{
+			if (pair.first == PARTITIONKEY || pair.first == ROWKEY)
+				continue;
+			insetKeyValuePropery(entity, pair.first, pair.second);
+		}
+		batch.add(entity.tableEntity());
+		queued.push_back(i);
+	}
+
+	auto batch_results = batch.execute();
+	for (size_t i = 0; i < queued.size(); ++i)
+	{
+		const auto& result = batch_results[i];
+		results[queued[i]] = BatchUtils::entityResult(queued[i], entities[queued[i]],
+			result.succeeded ? status_codes::Created : status_codes::InternalError, result.error);
+	}
+
+	m_http_request.reply(status_codes::OK, BatchUtils::response(results));
+}
+
 void AzureHandler::insetKeyValuePropery(boltazure::AzureEntity &entity, string_t key, json::value value)
 {
 	if (value.is_string())
@@ -0,0 +1,108 @@
+#include <batch_utils.hpp>
+#include <message_types.hpp>
+
+bool BatchUtils::extractEntities(const http_request& message, vector<json::value>& entities)
+{
+	http_request request = message;
+	utility::string_t body;
+	try
+	{
+		body = request.extract_string(true).get();
+	}
+	catch (const http_exception&)
+	{
+		return false;
+	}
+
+	auto first = body.find_first_not_of(U(" \t\r\n"));
+	if (first == utility::string_t::npos)
+		return false;
+
+	try
+	{
+		if (body[first] == U('['))
+		{
+			json::value array = json::value::parse(body);
+			for (const auto& entity : array.as_array())
+			{
+				entities.push_back(entity);
+			}
+			return true;
+		}
+
+		size_t begin = first;
+		while (begin < body.size())
+		{
+			size_t end = body.find(U('\n'), begin);
+			if (end == utility::string_t::npos)
+				end = body.size();
+
+			utility::string_t line = body.substr(begin, end - begin);
+			if (line.find_first_not_of(U(" \t\r")) != utility::string_t::npos)
+			{
+				entities.push_back(json::value::parse(line));
+			}
+			begin = end + 1;
+		}
+		return true;
+	}
+	catch (const json::json_exception&)
+	{
+		return false;
+	}
+}
+
+bool BatchUtils::getKeys(const json::value& entity, utility::string_t& partition_key, utility::string_t& row_key)
+{
+	if (!entity.is_object())
+		return false;
+
+	auto &property_map = entity.as_object();
+	auto partitionkey_find = property_map.find(PARTITIONKEY);
+	auto rowkey_find = property_map.find(ROWKEY);
+
+	if (partitionkey_find == property_map.end() || rowkey_find == property_map.end()
+		|| !partitionkey_find->second.is_string() || !rowkey_find->second.is_string())
+	{
+		return false;
+	}
+
+	partition_key = partitionkey_find->second.as_string();
+	row_key = rowkey_find->second.as_string();
+	return true;
+}
+
+json::value BatchUtils::entityResult(size_t index, const json::value& entity, status_code status, const utility::string_t& error)
+{
+	json::value result = json::value::object();
+	result[U("Index")] = json::value::number(static_cast<double>(index));
+
+	utility::string_t partition_key;
+	utility::string_t row_key;
+	if (getKeys(entity, partition_key, row_key))
+	{
+		result[PARTITIONKEY] = json::value::string(partition_key);
+		result[ROWKEY] = json::value::string(row_key);
+	}
+
+	result[U("Status")] = json::value::number(static_cast<int32_t>(status));
+	if (!error.empty())
+		result[U("Message")] = json::value::string(error);
+	return result;
+}
+
+json::value BatchUtils::response(const vector<json::value>& results)
+{
+	int32_t succeeded = 0;
+	for (const auto& result : results)
+	{
+		if (result.at(U("Status")).as_integer() < 300)
+			++succeeded;
+	}
+
+	json::value response = json::value::object();
+	response[U("Succeeded")] = json::value::number(succeeded);
+	response[U("Failed")] = json::value::number(static_cast<int32_t>(results.size()) - succeeded);
+	response[U("Results")] = json::value::array(results);
+	return response;
+}
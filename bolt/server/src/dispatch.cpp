@@ -7,7 +7,11 @@
 #include <permissions.hpp>
 #include <message_types.hpp>
 #include <whole_handler.hpp>
-#include <permissions.hpp>
+#include <configuration.hpp>
+#include <blocking_executor.hpp>
+#if !defined(_WIN32)
+#include <pplx/threadpool.h>
+#endif
 
 using namespace bolt::auth;
 using namespace http;
@@ -15,48 +19,117 @@ using namespace http;
 class Dispatch::DispatchImpl
 {
 public:
+	typedef void (DispatchImpl::*handler_type)(http_request);
+
 	Permissions permissions;
 	BoltLog bolt_logger;
+	//Declared last so queued requests finish before the members they use are destroyed
+	BlockingExecutor executor;
 
-	void handle_get(const http_request message)
+	DispatchImpl() : executor(
+		Config::getInstance().getNumberOption(Config::blocking_threads, 1, 4096),
+		Config::getInstance().getNumberOption(Config::blocking_queue_size, 1))
+	{
+	}
+
+	/// <summary>
+	/// Runs a handler on the blocking executor once the request body has arrived.
+	/// The listener thread only waits for the network, permission checks and storage calls
+	/// run on the executor. When the executor is full the request is answered with 503.
+	/// </summary>
+	static void schedule(const std::shared_ptr<DispatchImpl> &impl, handler_type handler, http_request message)
+	{
+		message.content_ready().then([impl, handler](pplx::task<http_request> ready)
+		{
+			http_request message;
+			try
+			{
+				message = ready.get();
+			}
+			catch (const http_exception &e)
+			{
+				//The client went away while sending the body, there is no one to reply to
+				impl->bolt_logger << BoltLog::LOG_ERROR << "Reading request body failed: " << e.what();
+				return;
+			}
+
+			bool queued = impl->executor.tryPost([impl, handler, message]()
+			{
+				try
+				{
+					((*impl).*handler)(message);
+				}
+				catch (const std::exception &e)
+				{
+					impl->bolt_logger << BoltLog::LOG_ERROR << "Request failed: " << e.what();
+					message.reply(status_codes::InternalError);
+				}
+			});
+
+			if (!queued)
+			{
+				http_response response(status_codes::ServiceUnavailable);
+				response.headers().add(U("Retry-After"), U("1"));
+				response.set_body(json::value::string(U("Server busy")));
+				message.reply(response);
+			}
+		});
+	}
+
+	/// <summary>
+	/// Administration changes need a valid signature of an account with delete permission on Administration.
+	/// </summary>
+	bool isAdministrator(const http_request& message)
 	{
+		http_headers headers = message.headers();
+		Signature signature(HeaderUtils::getAuthorizationString(headers));
+		if (!signature.isValied(HeaderUtils::getDateTimeString(headers), message.relative_uri().path(), message.method()))
+			return false;
+		return permissions.hasDelete(U("Administration"), signature.getUsername());
+	}
 
-		auto paths = UrlUtils::splitUri(message);
+	void handle_get(const http_request message)
+	{
+		Route route = UrlUtils::parseRoute(message);
 
 		http_headers headers = message.headers();
 
-		auto query = UrlUtils::splitQueryString(message);
-		auto select = query.find(SELECT);
+		auto select = route.query.find(SELECT);
 
-		if (paths.empty())
+		if (route.paths.empty())
 		{
 			message.reply(status_codes::OK, json::value::string(U("Table not selected")));
 			return;
 		}
 
-		string_t table_name; //paths 0 is name of the table
-		string_t rowkey;
-		string_t partitionkey;
+		if (!route.query_error.empty())
+		{
+			message.reply(status_codes::BadRequest, json::value::string(route.query_error));
+			return;
+		}
 
-		if (UrlUtils::hasTables(paths) || UrlUtils::hasAdministration(paths))
+		if (route.type == Route::route_type::tables || route.type == Route::route_type::administration)
 		{
-			switchDatabase(methods::GET, message);
+			switchDatabase(methods::GET, message, route);
 			return;
 		}
-		if (UrlUtils::getTableName(paths, table_name)
-			|| UrlUtils::getTableNameWithKeys(paths, table_name, rowkey, partitionkey)
-			|| UrlUtils::getTableNameWithoutKeys(paths, table_name))
+		if (route.type == Route::route_type::table || route.type == Route::route_type::entity || route.type == Route::route_type::collection)
 		{
 			Signature signature(HeaderUtils::getAuthorizationString(headers));
 
-			if (!permissions.hasGet(table_name, signature.getUsername()))
+			if (!permissions.hasGet(route.table, signature.getUsername()))
 			{
-				if (select != query.end())
+				//Table access is required, the column check only reports which selected columns are denied
+				if (select != route.query.end())
 				{
 					vector<string_t> clmns = UrlUtils::getColumnNames(select->second);
-					if (!permissions.hasGet(table_name, signature.getUsername(), clmns))
+					vector<string_t> denied;
+					if (!permissions.hasGet(route.table, signature.getUsername(), clmns, denied))
 					{
-						message.reply(status_codes::Unauthorized, json::value::string(U("Column access not permitted")));
+						json::value error = json::value::object();
+						error[U("message")] = json::value::string(U("Column access not permitted"));
+						error[U("DeniedColumns")] = json::value::array(vector<json::value>(denied.begin(), denied.end()));
+						message.reply(status_codes::Unauthorized, error);
 						return;
 					}
 				}
@@ -65,81 +138,92 @@ public:
 			}
 
 		}
-		switchDatabase(methods::GET, message); //Switch database according to request header x-bolt-database
+		switchDatabase(methods::GET, message, route); //Switch database according to request header x-bolt-database
 	}
 
 	void handle_post(http_request message)
 	{
-		auto paths = UrlUtils::splitUri(message);
+		Route route = UrlUtils::parseRoute(message);
 
 		http_headers headers = message.headers();
 
-		auto query = UrlUtils::splitQueryString(message);
-		auto field = query.find(FIELD);
-
-
-		if (paths.empty())
+		if (route.paths.empty())
 		{
 			message.reply(status_codes::OK, json::value::string(U("Table not selected")));
 			return;
 		}
 
-		string_t table_name; //paths 0 is name of the table
-
-		if (UrlUtils::hasTables(paths) || UrlUtils::hasQuery(paths))
+		if (route.type == Route::route_type::tables || route.type == Route::route_type::query)
 		{
-			switchDatabase(methods::POST, message);
+			switchDatabase(methods::POST, message, route);
 			return;
 		}
 
-		if (UrlUtils::getTableNameWithoutKeys(paths, table_name))
+		if (route.type == Route::route_type::collection)
 		{
 			Signature signature(HeaderUtils::getAuthorizationString(headers));
-			if (!permissions.hasPost(table_name, signature.getUsername()))
+			if (!permissions.hasPost(route.table, signature.getUsername()))
 			{
 				message.reply(status_codes::Unauthorized, json::value::string(U("table access not permitted 2")));
 				return;
 			}
-			switchDatabase(methods::POST, message);
+			switchDatabase(methods::POST, message, route);
 		}
 	}
 
 	void handle_put(http_request message)
 	{
-		switchDatabase(methods::PUT, message); //Switch database according to request header x-bolt-database
+		switchDatabase(methods::PUT, message, UrlUtils::parseRoute(message)); //Switch database according to request header x-bolt-database
 	}
 
 	void handle_delete(http_request message)
 	{
 		http_headers headers = message.headers();
 
-		auto paths = UrlUtils::splitUri(message);
-		string_t table_name;
+		Route route = UrlUtils::parseRoute(message);
 
+		if (!route.query_error.empty())
+		{
+			message.reply(status_codes::BadRequest, json::value::string(route.query_error));
+			return;
+		}
 
-		if (UrlUtils::getTableName(paths, table_name))
+		if (route.type == Route::route_type::administration)
+		{
+			if (!isAdministrator(message))
+			{
+				message.reply(status_codes::Unauthorized, json::value::string(U("Administration access not permitted")));
+				return;
+			}
+			switchDatabase(methods::DEL, message, route);
+			return;
+		}
+
+		if (route.type == Route::route_type::table)
 		{
 			Signature signature(HeaderUtils::getAuthorizationString(headers));
 
 
-			if (!permissions.hasDelete(table_name, signature.getUsername()))
+			if (!permissions.hasDelete(route.table, signature.getUsername()))
 			{
 				message.reply(status_codes::Unauthorized, json::value::string(U("Table access not permited")));
 				return;
 			}
 
-			switchDatabase(methods::DEL, message); //Switch database according to request header x-bolt-database
+			switchDatabase(methods::DEL, message, route); //Switch database according to request header x-bolt-database
+			return;
 		}
 
-		if (UrlUtils::getTableNameWithoutKeys(paths, table_name))
+		if (route.type == Route::route_type::collection)
 		{
 			Signature signature(HeaderUtils::getAuthorizationString(headers));
-			if (!permissions.hasPost(table_name, signature.getUsername()))
+			if (!permissions.hasPost(route.table, signature.getUsername()))
 			{
 				message.reply(status_codes::Unauthorized, json::value::string(U("table access not permitted 2")));
 				return;
 			}
-			switchDatabase(methods::DEL, message);
+			switchDatabase(methods::DEL, message, route);
+			return;
 		}
 
 		message.reply(status_codes::BadRequest);
@@ -147,17 +231,17 @@ public:
 
 	void handle_patch(http_request const message)
 	{
-		auto paths = UrlUtils::splitUri(message);
+		Route route = UrlUtils::parseRoute(message);
 
-		if (paths.empty())
+		if (route.paths.empty())
 		{
 			message.reply(status_codes::BadRequest);
 			return;
 		}
-		switchDatabase(methods::PATCH, message); //Switch database according to request header x-bolt-database
+		switchDatabase(methods::PATCH, message, route); //Switch database according to request header x-bolt-database
 	}
 
-	void switchDatabase(method method, const http_request& message)
+	void switchDatabase(method method, const http_request& message, const Route& route)
 	{
 		http_headers headers = message.headers(); //Get headers from http request
 
@@ -167,15 +251,15 @@ public:
 		{
 			if (database_type == U("mysql"))
 			{
-				MysqlHandler(message, method).InitializeHandlers();
+				MysqlHandler(message, method, route).InitializeHandlers();
 			}
 			else if (database_type == U("azure"))
 			{
-				AzureHandler(message, method).InitializeHandlers();
+				AzureHandler(message, method, route).InitializeHandlers();
 			}
 			else if (database_type == U("whole"))
 			{
-				WholeHandler(message, method).InitializeHandlers();
+				WholeHandler(message, method, route, executor).InitializeHandlers();
 			}
 			else
 			{
@@ -197,12 +281,52 @@ Dispatch::~Dispatch()
 {
 }
 
-Dispatch::Dispatch(string_t url) : m_impl{ new DispatchImpl }, m_listener(url)
+/// <summary>
+/// Sizes the listener I/O and continuation thread pools from the configuration.
+/// Only the boost::asio build has these pools, the Windows listener runs on http.sys.
+/// </summary>
+static void sizeThreadPools()
+{
+#if !defined(_WIN32)
+	Config &config = Config::getInstance();
+	size_t io_threads = config.getNumberOption(Config::io_threads, 0, 1024);
+	size_t continuation_threads = config.getNumberOption(Config::continuation_threads, 0, 1024);
+	bool pin_threads = config.getStdConfigOption(Config::pin_threads) == "true";
+
+	if (!crossplat::threadpool::initialize_with_threads(io_threads, continuation_threads, pin_threads))
+	{
+		BoltLog logger;
+		logger << BoltLog::LOG_WARNING << "Thread pools were started before the configuration was read, io-threads and continuation-threads are ignored";
+	}
+#endif
+}
+
+/// <summary>
+/// Listener options from the configuration.
+/// </summary>
+static http::experimental::listener::http_listener_config listenerConfig()
+{
+	Config &config = Config::getInstance();
+	http::experimental::listener::http_listener_config listener_config;
+	listener_config.set_acceptors(config.getNumberOption(Config::listener_acceptors, 1, 256));
+	listener_config.set_pin_acceptors(config.getStdConfigOption(Config::pin_threads) == "true");
+	listener_config.set_body_chunk_size(config.getNumberOption(Config::body_chunk_size, 512, 16 * 1024 * 1024));
+	//Up to a day, 0 waits until the client closes the connection
+	listener_config.set_keep_alive_timeout(utility::seconds(config.getNumberOption(Config::keep_alive_timeout, 0, 24 * 60 * 60)));
+	listener_config.set_max_requests_per_connection(config.getNumberOption(Config::max_requests_per_connection));
+	listener_config.set_max_pipelined_requests(config.getNumberOption(Config::max_pipelined_requests, 1, 1024));
+	return listener_config;
+}
+
+Dispatch::Dispatch(string_t url) : m_impl{ new DispatchImpl }, m_listener(url, listenerConfig())
 {
-	//Bind http functions to http listener
-	m_listener.support(methods::GET, bind(&DispatchImpl::handle_get, m_impl, placeholders::_1));
-	m_listener.support(methods::PUT, bind(&DispatchImpl::handle_put, m_impl, placeholders::_1));
-	m_listener.support(methods::POST, bind(&DispatchImpl::handle_post, m_impl, placeholders::_1));
-	m_listener.support(methods::DEL, bind(&DispatchImpl::handle_delete, m_impl, placeholders::_1));
-	m_listener.support(methods::PATCH, bind(&DispatchImpl::handle_patch, m_impl, placeholders::_1));
+	//The listener only starts using the pools when it is opened
+	sizeThreadPools();
+
+	//Bind http functions to http listener, every handler runs on the blocking executor
+	m_listener.support(methods::GET, bind(&DispatchImpl::schedule, m_impl, &DispatchImpl::handle_get, placeholders::_1));
+	m_listener.support(methods::PUT, bind(&DispatchImpl::schedule, m_impl, &DispatchImpl::handle_put, placeholders::_1));
+	m_listener.support(methods::POST, bind(&DispatchImpl::schedule, m_impl, &DispatchImpl::handle_post, placeholders::_1));
+	m_listener.support(methods::DEL, bind(&DispatchImpl::schedule, m_impl, &DispatchImpl::handle_delete, placeholders::_1));
+	m_listener.support(methods::PATCH, bind(&DispatchImpl::schedule, m_impl, &DispatchImpl::handle_patch, placeholders::_1));
 }
\ No newline at end of file
@@ -5,20 +5,21 @@
 #include <azure_table.h>
 #include <azure_query.h>
 #include <mysql_query.h>
+#include <mysql_connection.h>
+#include <connection.hpp>
+#include <permission_cache.hpp>
+#include <signing_key_cache.hpp>
 #include <configuration.hpp>
 #include <url_utils.hpp>
+#include <message_types.hpp>
+#include <cpprest/producerconsumerstream.h>
+#include <cpprest/http_listener.h>
+#include <algorithm>
 
 using namespace std;
 using namespace bolt::storage::boltazure;
 using namespace bolt::storage::mysql;
 
-struct AzureFilter
-{
-	string_t property_name;
-	string_t condition;
-	string_t value;
-};
-
 json::value Metadata::getMysqlTables()
 {
 	auto mysqltable = MysqlTable();
@@ -59,15 +60,17 @@ json::value Metadata::getMysqlTable(string_t table_name)
 	return metadata;
 }
 
-json::value Metadata::getAzureEntity(string_t table_name, string_t rowkey, string_t partitionkey)
+pplx::task<json::value> Metadata::getAzureEntity(string_t table_name, string_t rowkey, string_t partitionkey)
 {
-	unique_ptr<AzureQuery> azurequery(new AzureQuery(table_name)); //AzureQuery Object
-	vector<table_entity> result;
-	if (!(rowkey.empty() && partitionkey.empty()))
+	if (rowkey.empty() && partitionkey.empty())
 	{
-		result = azurequery->filterByKey(partitionkey, rowkey);
+		return pplx::task_from_result(generateAzureEntityMeta(vector<table_entity>()));
 	}
-	return generateAzureEntityMeta(result);
+
+	return AzureQuery(table_name).filterByKeyAsync(partitionkey, rowkey).then([](const vector<table_entity> &result)
+	{
+		return generateAzureEntityMeta(result);
+	});
 }
 
 json::value Metadata::getMysqlEntity(string_t table_name, string_t rowkey, string_t partitionkey)
@@ -75,16 +78,110 @@ json::value Metadata::getMysqlEntity(string_t table_name, string_t rowkey, strin
 	auto mysqlquery = MysqlQuery(); //MysqlQuery 
 	mysqlquery.from(table_name);
 
-	deque<mysql_table_entity> result;
-	if (!(rowkey.empty() && partitionkey.empty()))
+	if (rowkey.empty() && partitionkey.empty())
+	{
+		return generateAzureEntityMeta(mysql_result_set());
+	}
+
+	return generateAzureEntityMeta(mysqlquery.filterByKey(partitionkey, rowkey));
+}
+
+/// <summary>
+/// Entities in one page, $top when it is given and below max-page-size.
+/// </summary>
+static size_t pageSize(size_t top)
+{
+	static const size_t max_page_size = (std::max)(static_cast<size_t>(1),
+		static_cast<size_t>(Config::getInstance().getNumberOption(Config::max_page_size)));
+	return top != 0 && top < max_page_size ? top : max_page_size;
+}
+
+//Serialized rows are handed to the response in chunks of about this size
+static const size_t stream_chunk_size = 64 * 1024;
+
+void Metadata::replyMysqlEntities(const http_request &message, const Route &route)
+{
+	const size_t page_size = pageSize(route.top);
+
+	//The page is serialized before anything is written to the client, a slow reader must not hold a pooled connection
+	vector<std::string> chunks;
+	std::string chunk = "{\"value\":[";
+	bool first = true;
+
+	size_t rows = 0;
+	string_t next_partition_key;
+	string_t next_row_key;
+
+	//One row more than the page tells whether another page follows, and where it starts
+	auto mysqlquery = buildMysqlEntitiesQuery(route.table, route.query, route.filter, route.next_partition_key, route.next_row_key, page_size + 1);
+
+	//Keys read only to continue the page are replied empty, as they were before $select was paged
+	vector<string_t> select;
+	bool hide_partition_key = false;
+	bool hide_row_key = false;
+	if (UrlUtils::getSelect(route.query, select))
+	{
+		hide_partition_key = find(select.cbegin(), select.cend(), PARTITIONKEY) == select.cend();
+		hide_row_key = find(select.cbegin(), select.cend(), ROWKEY) == select.cend();
+	}
+
+	bool succeeded = mysqlquery.queryEach([&](const mysql_table_entity &entity)
+	{
+		if (++rows > page_size)
+		{
+			next_partition_key = entity.partition_key();
+			next_row_key = entity.row_key();
+			return false;
+		}
+
+		if (!first)
+			chunk += ",";
+		first = false;
+		json::value reply_entity = generateAzureEntity(entity);
+		if (hide_partition_key)
+			reply_entity[U("PartitionKey")] = json::value::string(string_t());
+		if (hide_row_key)
+			reply_entity[U("RowKey")] = json::value::string(string_t());
+		chunk += conversions::to_utf8string(reply_entity.serialize());
+
+		if (chunk.size() >= stream_chunk_size)
+		{
+			chunks.push_back(std::move(chunk));
+			chunk.clear();
+		}
+		return true;
+	});
+
+	if (!succeeded)
+	{
+		message.reply(status_codes::InternalError);
+		return;
+	}
+
+	chunk += "]";
+	if (rows > page_size)
 	{
-		result = mysqlquery.filterByKey(partitionkey, rowkey);
+		chunk += ",\"NextPartitionKey\":" + conversions::to_utf8string(json::value::string(next_partition_key).serialize());
+		chunk += ",\"NextRowKey\":" + conversions::to_utf8string(json::value::string(next_row_key).serialize());
 	}
+	chunk += "}";
+	chunks.push_back(std::move(chunk));
 
-	return generateAzureEntityMeta(result);
+	//The connection is back in the pool, the buffer takes the page and the client reads it at its own pace
+	concurrency::streams::producer_consumer_buffer<uint8_t> buffer;
+	http_response response(status_codes::OK);
+	response.set_body(concurrency::streams::istream(buffer), U("application/json"));
+	message.reply(response);
+
+	for (const auto &part : chunks)
+	{
+		buffer.putn(reinterpret_cast<const uint8_t*>(part.data()), part.size()).wait();
+	}
+	buffer.close(std::ios_base::out).wait();
 }
 
-json::value Metadata::getMysqlEntities(string_t table_name, map<string_t, string_t> const query)
+MysqlQuery Metadata::buildMysqlEntitiesQuery(string_t table_name, map<string_t, string_t> const query, const ODataFilter &filter,
+	const string_t &next_partition_key, const string_t &next_row_key, size_t limit)
 {
 
 	auto mysqlquery = MysqlQuery(); //MysqlQuery Object
@@ -93,6 +190,12 @@ json::value Metadata::getMysqlEntities(string_t table_name, map<string_t, string
 
 	if (UrlUtils::getSelect(query, select))
 	{
+		//A page continues from the keys of an entity, they are always read
+		if (limit != 0 && find(select.cbegin(), select.cend(), PARTITIONKEY) == select.cend())
+			select.push_back(PARTITIONKEY);
+		if (limit != 0 && find(select.cbegin(), select.cend(), ROWKEY) == select.cend())
+			select.push_back(ROWKEY);
+
 		string_t columns;
 		auto last_iteration = --select.cend();
 		for (auto iter = select.cbegin(); iter != select.cend(); ++iter)
@@ -107,57 +210,31 @@ json::value Metadata::getMysqlEntities(string_t table_name, map<string_t, string
 		mysqlquery.select(columns);
 	}
 
-	map<string_t, string_t> filter_conditions;
-	if (UrlUtils::getFilter(query, filter_conditions))
-	{
-		string_t firstwhere;
-		string_t secondwhere;
-
-
-		if (filter_conditions.find(U("first_attr")) != filter_conditions.cend()
-			&& filter_conditions.find(U("first_con")) != filter_conditions.cend()
-			&& filter_conditions.find(U("first_val")) != filter_conditions.cend())
-		{
-			firstwhere = filter_conditions.find(U("first_attr"))->second;
-
-			string_t first_con = filter_conditions.find(U("first_con"))->second;
+	vector<mysql_property> parameters;
+	string_t where = filter.toSql(parameters);
 
-			firstwhere += getCondition(first_con);
-
-			firstwhere += filter_conditions.find(U("first_val"))->second;
-		}
-
-		if (filter_conditions.find(U("second_attr")) != filter_conditions.cend()
-			&& filter_conditions.find(U("second_con")) != filter_conditions.cend()
-			&& filter_conditions.find(U("second_val")) != filter_conditions.cend())
+	if (limit != 0)
+	{
+		//Keyset pagination, seeks to the first entity at or after the keys instead of skipping rows with OFFSET
+		if (!next_partition_key.empty())
 		{
-			secondwhere = filter_conditions.find(U("second_attr"))->second;
-
-			string_t second_con = filter_conditions.find(U("second_con"))->second;
-			secondwhere += getCondition(second_con);
-
-			secondwhere += filter_conditions.find(U("second_val"))->second;
+			string_t keyset = U("(PartitionKey > ? OR (PartitionKey = ? AND RowKey >= ?))");
+			where = where.empty() ? keyset : where + U(" AND ") + keyset;
+			parameters.push_back(mysql_property(next_partition_key));
+			parameters.push_back(mysql_property(next_partition_key));
+			parameters.push_back(mysql_property(next_row_key));
 		}
+		mysqlquery.order(U("PartitionKey, RowKey"));
+		mysqlquery.limit(conversions::to_string_t(std::to_string(limit)));
+	}
 
-		mysqlquery.where(firstwhere);
-
-		if (filter_conditions.find(U("join")) != filter_conditions.cend())
-		{
-			string_t join = filter_conditions.find(U("join"))->second;
-
-			if (join == U("or"))
-			{
-				mysqlquery.orWhere(secondwhere);
-			}
-
-			if (join == U("and"))
-			{
-				mysqlquery.andWhere(secondwhere);
-			}
-		}
+	if (!where.empty())
+	{
+		mysqlquery.where(where);
+		mysqlquery.bind(parameters);
 	}
 
-	return generateAzureEntityMeta(mysqlquery.queryAll());
+	return mysqlquery;
 }
 
 bool Metadata::getMysqlQueryResults(const json::object &query_obj, json::value& result)
@@ -492,8 +569,7 @@ bool Metadata::getMysqlQueryResults(const json::object &query_obj, json::value&
 
 	//Query part
 	string_t host = Config::getInstance().getServerHostWithPort();
-	deque<mysql_table_entity> query_result = query.queryAll();
-	result = generateAzureEntityMeta(query_result);
+	result = generateAzureEntityMeta(query.queryAll());
 
 	return true;
 }
@@ -551,78 +627,119 @@ bool Metadata::getAdministration(const vector<string_t> paths, json::value& resu
 		result = generateEntityMeta(MySqlDB::showOpenTables());
 		return true;
 	}
+	if (UrlUtils::hasPools(paths))
+	{
+		result = getPoolStatistics();
+		return true;
+	}
 	return false;
 }
 
-json::value Metadata::getAzureEntities(string_t table_name, map<string_t, string_t> const query)
+bool Metadata::deleteAdministration(const vector<string_t> paths, json::value& result)
 {
-	auto azurequery = AzureQuery(table_name); //MysqlQuery Object
+	if (UrlUtils::hasGrants(paths))
+	{
+		//After grants were changed in MySQL, reloads the permission cache without waiting for the next checksum poll
+		bolt::auth::PermissionCache::getInstance().invalidate();
+		result = json::value::object();
+		result[U("Grants")] = json::value::string(U("Invalidated"));
+		return true;
+	}
+	string_t account;
+	if (UrlUtils::getSigningKeys(paths, account))
+	{
+		//After an account key was regenerated, drops the cached key instead of waiting for it to expire
+		if (account.empty())
+			bolt::auth::SigningKeyCache::getInstance().clear();
+		else
+			bolt::auth::SigningKeyCache::getInstance().invalidate(utility::conversions::to_utf8string(account));
+		result = json::value::object();
+		result[U("SigningKeys")] = json::value::string(U("Invalidated"));
+		return true;
+	}
+	return false;
+}
+
+json::value Metadata::getPoolStatistics()
+{
+	auto to_json = [](const MysqlPoolStatistics& stats) -> json::value
+	{
+		json::value pool = json::value::object();
+		pool[U("Checkouts")] = json::value::number(static_cast<double>(stats.checkouts));
+		pool[U("Waits")] = json::value::number(static_cast<double>(stats.waits));
+		//Wait times are in microseconds
+		pool[U("WaitTimeTotal")] = json::value::number(static_cast<double>(stats.wait_time_total));
+		pool[U("WaitTimeMax")] = json::value::number(static_cast<double>(stats.wait_time_max));
+		pool[U("Timeouts")] = json::value::number(static_cast<double>(stats.timeouts));
+		pool[U("ConnectionsOpened")] = json::value::number(static_cast<double>(stats.connections_opened));
+		pool[U("ConnectionsClosed")] = json::value::number(static_cast<double>(stats.connections_closed));
+		pool[U("InUse")] = json::value::number(static_cast<double>(stats.in_use));
+		pool[U("Idle")] = json::value::number(static_cast<double>(stats.idle));
+		pool[U("MaxSize")] = json::value::number(static_cast<double>(stats.max_size));
+		pool[U("StatementHits")] = json::value::number(static_cast<double>(stats.statement_hits));
+		pool[U("StatementMisses")] = json::value::number(static_cast<double>(stats.statement_misses));
+		pool[U("StatementEvictions")] = json::value::number(static_cast<double>(stats.statement_evictions));
+		pool[U("StatementCacheSize")] = json::value::number(static_cast<double>(stats.statement_cache_size));
+		return pool;
+	};
+
+	json::value metadata = json::value::object();
+	metadata[U("Data")] = to_json(MysqlConnection::get_instance().statistics());
+	metadata[U("Auth")] = to_json(bolt::auth::Connection::GetInstance().statistics());
+
+	auto connections = http::experimental::listener::http_listener::statistics();
+	json::value listener = json::value::object();
+	listener[U("OpenConnections")] = json::value::number(static_cast<double>(connections.open_connections));
+	listener[U("InFlightRequests")] = json::value::number(static_cast<double>(connections.in_flight_requests));
+	listener[U("Requests")] = json::value::number(static_cast<double>(connections.requests));
+	listener[U("PipelinedRequests")] = json::value::number(static_cast<double>(connections.pipelined_requests));
+	listener[U("IdleTimeouts")] = json::value::number(static_cast<double>(connections.idle_timeouts));
+	metadata[U("Listener")] = listener;
+	return metadata;
+}
+
+pplx::task<json::value> Metadata::getAzureEntities(const Route &route)
+{
+	auto azurequery = AzureQuery(route.table); //MysqlQuery Object
 	//azurequery.from(table_name);
 	vector<string_t> select;
 
-	if (UrlUtils::getSelect(query, select))
+	if (UrlUtils::getSelect(route.query, select))
 	{
 		azurequery.select(select);
 	}
 
-	map<string_t, string_t> filter_conditions;
-	if (UrlUtils::getFilter(query, filter_conditions))
+	if (!route.filter.empty())
 	{
-		AzureFilter first_filter;
-		AzureFilter second_filter;
-
-		if (filter_conditions.find(U("first_attr")) != filter_conditions.cend()
-			&& filter_conditions.find(U("first_con")) != filter_conditions.cend()
-			&& filter_conditions.find(U("first_val")) != filter_conditions.cend())
-		{
-			first_filter.property_name = filter_conditions.find(U("first_attr"))->second;
-			first_filter.condition = filter_conditions.find(U("first_con"))->second;
-			first_filter.value = filter_conditions.find(U("first_val"))->second;
-		}
+		azurequery.setFilterString(route.filter.toAzure());
+	}
 
-		if (filter_conditions.find(U("second_attr")) != filter_conditions.cend()
-			&& filter_conditions.find(U("second_con")) != filter_conditions.cend()
-			&& filter_conditions.find(U("second_val")) != filter_conditions.cend())
-		{
-			second_filter.property_name = filter_conditions.find(U("second_attr"))->second;
-			second_filter.condition = filter_conditions.find(U("second_con"))->second;
-			second_filter.value = filter_conditions.find(U("second_val"))->second;
-		}
+	//The storage client keeps the continuation as the query string of the next request
+	continuation_token token;
+	if (!route.next_partition_key.empty())
+	{
+		string_t marker = NEXT_PARTITION_KEY + string_t(U("=")) + uri::encode_data_string(route.next_partition_key);
+		if (!route.next_row_key.empty())
+			marker += U("&") + string_t(NEXT_ROW_KEY) + U("=") + uri::encode_data_string(route.next_row_key);
+		token.set_next_marker(marker);
+	}
 
-		azurequery.setFilterCondition(first_filter.property_name, first_filter.condition, first_filter.value);
+	//Azure returns at most 1000 entities per segment, a smaller page is still continued
+	return azurequery.querySegmentAsync(static_cast<int>(pageSize(route.top)), token).then([](const table_query_segment &segment)
+	{
+		json::value result = generateAzureEntityMeta(segment.results());
 
-		if (filter_conditions.find(U("join")) != filter_conditions.cend())
+		if (!segment.continuation_token().empty())
 		{
-			string_t join = filter_conditions.find(U("join"))->second;
-
-			if (join == U("or"))
+			auto next = uri::split_query(segment.continuation_token().next_marker());
+			for (const auto &pair : next)
 			{
-				azurequery.setOrFilterCondition(second_filter.property_name, second_filter.condition, second_filter.value);
-			}
-
-			if (join == U("and"))
-			{
-				azurequery.setAndFilterCondition(second_filter.property_name, second_filter.condition, second_filter.value);
+				if (pair.first == NEXT_PARTITION_KEY || pair.first == NEXT_ROW_KEY)
+					result[pair.first] = json::value::string(uri::decode(pair.second));
 			}
 		}
-	}
-
-	return generateAzureEntityMeta(azurequery.queryAll());
-}
-
-string_t Metadata::getCondition(string_t condition)
-{
-	if (condition == U("le"))
-		return U(" <= ");
-	if (condition == U(" lt "))
-		return U(" < ");
-	if (condition == U("ge"))
-		return U(" >= ");
-	if (condition == U("gt"))
-		return U(" > ");
-	if (condition == U("ne"))
-		return U(" != ");
-	return U(" = "); //eq
+		return result;
+	});
 }
 
 template<typename container>
@@ -670,50 +787,137 @@ json::value Metadata::generateAzureEntityMeta(container entity_vector)
 	size_t i = 0; //Entity json array index
 	for (auto ait = entity_vector.cbegin(); ait != entity_vector.cend(); ++ait, ++i)
 	{
-		json::value entity = json::value::object(); //Entity property set
-		for (auto pit = ait->properties().cbegin(); pit != ait->properties().cend(); ++pit)
-		{
-			auto propery = pit->second;
-			string_t property_key = pit->first;
+		entities[i] = generateAzureEntity(*ait);
+	}
+	//Entity enclosing object
+	json::value replyObj = json::value::object();
+	replyObj[U("value")] = entities;
 
-			switch (propery.property_type())
-			{
-			case edm_type::string:
-				entity[property_key] = json::value::string(propery.string_value());
-				break;
-			case edm_type::double_floating_point:
-				entity[property_key] = json::value::number(propery.double_value());
-				break;
-			case edm_type::datetime:
-				entity[property_key] = json::value::string(propery.datetime_value().to_string());
-				break;
-			case edm_type::boolean:
-				entity[property_key] = json::value::boolean(propery.boolean_value());
-				break;
-			case edm_type::int64:
-				entity[property_key] = json::value(propery.int64_value());
-				break;
-			case edm_type::binary:
-				entity[property_key] = json::value::string(propery.string_value());
-				break;
-			case edm_type::guid:
-				entity[property_key] = json::value::string(propery.string_value());
-				break;
-			case edm_type::int32:
-				entity[property_key] = json::value::number(propery.int32_value());
-				break;
-			default:
-				entity[property_key] = json::value::string(propery.string_value());
-			}
-		}
-		entity[U("Timestamp")] = json::value::string(ait->timestamp().to_string(datetime::date_format::ISO_8601));
-		entity[U("PartitionKey")] = json::value::string(ait->partition_key());
-		entity[U("RowKey")] = json::value::string(ait->row_key());
-		entities[i] = entity;
+	return replyObj;
+}
+
+template <class entity_type>
+json::value Metadata::generateAzureEntity(const entity_type &table_entity)
+{
+	json::value entity = json::value::object(); //Entity property set
+	for (auto pit = table_entity.properties().cbegin(); pit != table_entity.properties().cend(); ++pit)
+	{
+		auto propery = pit->second;
+		string_t property_key = pit->first;
+
+		switch (propery.property_type())
+		{
+		case edm_type::string:
+			entity[property_key] = json::value::string(propery.string_value());
+			break;
+		case edm_type::double_floating_point:
+			entity[property_key] = json::value::number(propery.double_value());
+			break;
+		case edm_type::datetime:
+			entity[property_key] = json::value::string(propery.datetime_value().to_string());
+			break;
+		case edm_type::boolean:
+			entity[property_key] = json::value::boolean(propery.boolean_value());
+			break;
+		case edm_type::int64:
+			entity[property_key] = json::value(propery.int64_value());
+			break;
+		case edm_type::binary:
+			entity[property_key] = json::value::string(propery.string_value());
+			break;
+		case edm_type::guid:
+			entity[property_key] = json::value::string(propery.string_value());
+			break;
+		case edm_type::int32:
+			entity[property_key] = json::value::number(propery.int32_value());
+			break;
+		default:
+			entity[property_key] = json::value::string(propery.string_value());
+		}
+	}
+	entity[U("Timestamp")] = json::value::string(table_entity.timestamp().to_string(datetime::date_format::ISO_8601));
+	entity[U("PartitionKey")] = json::value::string(table_entity.partition_key());
+	entity[U("RowKey")] = json::value::string(table_entity.row_key());
+	return entity;
+}
+
+json::value Metadata::generateAzureEntityMeta(const mysql_result_set &result)
+{
+	//Entity json array
+	json::value entities = json::value::array(result.size());
+	size_t i = 0; //Entity json array index
+	for (auto row = result.cbegin(); row != result.cend(); ++row, ++i)
+	{
+		entities[i] = generateAzureEntity(*row);
 	}
 	//Entity enclosing object
 	json::value replyObj = json::value::object();
 	replyObj[U("value")] = entities;
 
 	return replyObj;
-}
\ No newline at end of file
+}
+
+json::value Metadata::generateAzureEntity(const mysql_result_set::row &row)
+{
+	json::value entity = json::value::object(); //Entity property set
+	for (size_t i = 0; i < row.size(); ++i)
+	{
+		const string_t &property_key = row.name(i);
+
+		//The values are read as stored, the column names are shared by all rows
+		switch (row.type(i))
+		{
+		case myedm_type::double_floating_point:
+			entity[property_key] = json::value::number(row.double_value(i));
+			break;
+		case myedm_type::int64:
+			entity[property_key] = json::value(row.int64_value(i));
+			break;
+		case myedm_type::int32:
+			entity[property_key] = json::value::number(row.int32_value(i));
+			break;
+		default:
+			entity[property_key] = json::value::string(row.string_value(i));
+		}
+	}
+	entity[U("Timestamp")] = json::value::string(row.timestamp().to_string(datetime::date_format::ISO_8601));
+	entity[U("PartitionKey")] = json::value::string(row.partition_key());
+	entity[U("RowKey")] = json::value::string(row.row_key());
+	return entity;
+}
+
+json::value Metadata::generateAzureEntity(const mysql_table_entity &table_entity)
+{
+	json::value entity = json::value::object(); //Entity property set
+	for (auto pit = table_entity.properties().cbegin(); pit != table_entity.properties().cend(); ++pit)
+	{
+		const mysql_property &propery = pit->second;
+		const string_t &property_key = pit->first;
+
+		switch (propery.property_type())
+		{
+		case myedm_type::double_floating_point:
+			entity[property_key] = json::value::number(propery.double_value());
+			break;
+		case myedm_type::boolean:
+			entity[property_key] = json::value::boolean(propery.boolean_value());
+			break;
+		case myedm_type::int64:
+			entity[property_key] = json::value(propery.int64_value());
+			break;
+		case myedm_type::int32:
+			entity[property_key] = json::value::number(propery.int32_value());
+			break;
+		case myedm_type::datetime:
+			entity[property_key] = json::value::string(propery.datetime_value().to_string(datetime::date_format::ISO_8601));
+			break;
+		default:
+			//Strings, and binary as base64
+			entity[property_key] = json::value::string(propery.str());
+		}
+	}
+	entity[U("Timestamp")] = json::value::string(table_entity.timestamp().to_string(datetime::date_format::ISO_8601));
+	entity[U("PartitionKey")] = json::value::string(table_entity.partition_key());
+	entity[U("RowKey")] = json::value::string(table_entity.row_key());
+	return entity;
+}
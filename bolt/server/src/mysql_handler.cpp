@@ -9,10 +9,12 @@
 #include <metadata.hpp>
 #include <mhttppost.hpp>
 #include <mhttpdelete.hpp>
+#include <mysql_batch.h>
+#include <batch_utils.hpp>
 
 using namespace bolt::auth;
 
-MysqlHandler::MysqlHandler(const http_request &request, method method) : m_http_request(request)
+MysqlHandler::MysqlHandler(const http_request &request, method method, const Route &route) : m_http_request(request), m_route(route)
 {
 	m_method = method;
 }
@@ -42,30 +44,22 @@ void MysqlHandler::InitializeHandlers()
 /// </summary>
 void MysqlHandler::HandleGet()
 {
-	auto paths = UrlUtils::splitUri(m_http_request);
-	auto query = UrlUtils::splitQueryString(m_http_request);
-
-	//Requested table name
-	string_t table_name;
-	string_t rowkey;
-	string_t partitionkey;
-
-	if (paths.empty())
+	if (m_route.paths.empty())
 	{
 		m_http_request.reply(status_codes::BadRequest);
 		return;
 	}
 
-	if (UrlUtils::hasTables(paths))
+	if (m_route.type == Route::route_type::tables)
 	{
 		m_http_request.reply(status_codes::OK, Metadata::getMysqlTables());
 		return;
 	}
 
-	if (UrlUtils::hasAdministration(paths))
+	if (m_route.type == Route::route_type::administration)
 	{
 		json::value result;
-		if (Metadata::getAdministration(paths, result))
+		if (Metadata::getAdministration(m_route.paths, result))
 		{
 			m_http_request.reply(status_codes::OK, result);
 			return;
@@ -74,19 +68,16 @@ void MysqlHandler::HandleGet()
 		return;
 	}
 
-	if (UrlUtils::getTableNameWithKeys(paths, table_name, rowkey, partitionkey))
+	//if partition key and row key found we are good to go
+	if (m_route.type == Route::route_type::entity)
 	{
-		//if partition key and row key found we are good to go
-		if (!(rowkey.empty() && partitionkey.empty()))
-		{
-			m_http_request.reply(status_codes::OK, Metadata::getMysqlEntity(table_name, rowkey, partitionkey));
-			return;
-		}
+		m_http_request.reply(status_codes::OK, Metadata::getMysqlEntity(m_route.table, m_route.row_key, m_route.partition_key));
+		return;
 	}
 
-	if (UrlUtils::getTableNameWithoutKeys(paths, table_name))
+	if (m_route.type == Route::route_type::collection)
 	{
-		m_http_request.reply(status_codes::OK, Metadata::getMysqlEntities(table_name, query));
+		Metadata::replyMysqlEntities(m_http_request, m_route);
 		return;
 	}
 
@@ -100,18 +91,14 @@ void MysqlHandler::HandlePost()
 {
 
 	http_headers headers = m_http_request.headers();
-	auto paths = UrlUtils::splitUri(m_http_request);
 
-	if (paths.empty())
+	if (m_route.paths.empty())
 	{
 		m_http_request.reply(status_codes::BadRequest);
 		return;
 	}
 
-	//Requested table name
-	string_t table_name;
-
-	if (UrlUtils::hasQuery(paths))
+	if (m_route.type == Route::route_type::query)
 	{
 		json::value obj;
 		try
@@ -140,7 +127,7 @@ void MysqlHandler::HandlePost()
 	}
 	// continue when the response is available
 	// and continue when the JSON value is available
-	if (UrlUtils::hasTables(paths))
+	if (m_route.type == Route::route_type::tables)
 	{
 		json::value obj;
 		try
@@ -163,12 +150,20 @@ void MysqlHandler::HandlePost()
 	}
 
 	// get the JSON value from the task and display content from it
-	if (!UrlUtils::getTableNameWithoutKeys(paths, table_name))
+	if (m_route.type != Route::route_type::collection)
 	{
 		m_http_request.reply(status_codes::BadRequest);
 		return;
 	}
 
+	const string_t &table_name = m_route.table;
+
+	if (m_route.batch)
+	{
+		HandleBatch(table_name);
+		return;
+	}
+
 	json::value obj;
 	try
 	{
@@ -227,6 +222,55 @@ void MysqlHandler::HandlePost()
 	m_http_request.reply(status_codes::BadRequest);
 }
 
+/// <summary>
+/// Handles a batch of entities posted to table/$batch.
+/// Rows with the same properties are written with multi-row statements in one transaction.
+/// </summary>
+void MysqlHandler::HandleBatch(const utility::string_t &table_name)
+{
+	vector<json::value> entities;
+	if (!BatchUtils::extractEntities(m_http_request, entities))
+	{
+		m_http_request.reply(status_codes::BadRequest);
+		return;
+	}
+
+	vector<json::value> results(entities.size());
+	vector<size_t> queued;
+	MysqlBatch batch(table_name);
+
+	for (size_t i = 0; i < entities.size(); ++i)
+	{
+		string_t partition_key;
+		string_t row_key;
+		if (!BatchUtils::getKeys(entities[i], partition_key, row_key))
+		{
+			results[i] = BatchUtils::entityResult(i, entities[i], status_codes::BadRequest, U("PartitionKey and RowKey are required"));
+			continue;
+		}
+
+		MysqlEntity entity(table_name, partition_key, row_key, entities[i].as_object().size());
+		for (auto& pair : entities[i].as_object())
+		{
+			if (pair.first == PARTITIONKEY || pair.first == ROWKEY)
+				continue;
+			insetKeyValuePropery(entity, pair.first, pair.second);
+		}
+		batch.add(entity.tableEntity());
+		queued.push_back(i);
+	}
+
+	auto batch_results = batch.execute();
+	for (size_t i = 0; i < queued.size(); ++i)
+	{
+		const auto& result = batch_results[i];
+		results[queued[i]] = BatchUtils::entityResult(queued[i], entities[queued[i]],
+			result.succeeded ? status_codes::Created : status_codes::InternalError, result.error);
+	}
+
+	m_http_request.reply(status_codes::OK, BatchUtils::response(results));
+}
+
 void MysqlHandler::insetKeyValuePropery(MysqlEntity &entity, string_t key, json::value value)
 {
 	if (value.is_string()) //If value a string
@@ -243,24 +287,17 @@ void MysqlHandler::insetKeyValuePropery(MysqlEntity &entity, string_t key, json:
 
 void MysqlHandler::HandleDelete()
 {
-	auto paths = UrlUtils::splitUri(m_http_request);
-	auto query = UrlUtils::splitQueryString(m_http_request);
-
-	if (paths.empty())
+	if (m_route.paths.empty())
 	{
 		m_http_request.reply(status_codes::BadRequest);
 		return;
 	}
 
-	//Requested table name
-	string_t table_name;
-
-	//Table name checks for "Table('table_name')" 
-	//and assings the table name to the given variable
-	if (UrlUtils::getTableName(paths, table_name))
+	//Table('table_name') deletes the table itself
+	if (m_route.type == Route::route_type::table)
 	{
 		unique_ptr<MysqlTable> table(new MysqlTable);
-		if (table->deleteTable(table_name))
+		if (table->deleteTable(m_route.table))
 		{
 			m_http_request.reply(status_codes::NoContent);
 			return;
@@ -270,9 +307,21 @@ void MysqlHandler::HandleDelete()
 		return;
 	}
 
-	if (UrlUtils::getTableNameWithoutKeys(paths, table_name))
+	if (m_route.type == Route::route_type::administration)
 	{
-		if (MHttpDelete::deleteEntities(table_name, query))
+		json::value result;
+		if (Metadata::deleteAdministration(m_route.paths, result))
+		{
+			m_http_request.reply(status_codes::OK, result);
+			return;
+		}
+		m_http_request.reply(status_codes::BadRequest);
+		return;
+	}
+
+	if (m_route.type == Route::route_type::collection)
+	{
+		if (MHttpDelete::deleteEntities(m_route.table, m_route.filter))
 		{
 			m_http_request.reply(status_codes::NoContent);
 			return;
@@ -287,24 +336,15 @@ void MysqlHandler::HandlePatch()
 {
 	http_headers headers = m_http_request.headers();
 
-	auto paths = UrlUtils::splitUri(m_http_request);
-
-	if (paths.empty())
+	if (m_route.type != Route::route_type::entity)
 	{
 		m_http_request.reply(status_codes::BadRequest);
 		return;
 	}
 
-	//Requested table name
-	string_t table_name;
-	string_t paritition_key;
-	string_t row_key;
-
-	if (!UrlUtils::getTableNameWithKeys(paths, table_name, row_key, paritition_key))
-	{
-		m_http_request.reply(status_codes::BadRequest);
-		return;
-	}
+	const string_t &table_name = m_route.table;
+	const string_t &paritition_key = m_route.partition_key;
+	const string_t &row_key = m_route.row_key;
 
 	// get the JSON value from the task and display content from it
 
@@ -338,7 +378,7 @@ void MysqlHandler::HandlePatch()
 
 		if (entity.patchEntity())
 		{
-			m_http_request.reply(status_codes::NoContent, Metadata::getMysqlEntity(table_name, paritition_key, row_key));
+			m_http_request.reply(status_codes::NoContent, Metadata::getMysqlEntity(table_name, row_key, paritition_key));
 			return;
 		}
 		else
@@ -0,0 +1,630 @@
+#include <odata_filter.hpp>
+#include <was/table.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+
+using namespace utility;
+using namespace bolt::storage::mysql;
+
+//Bounds the recursion of the parser and the size of the generated statements
+static const size_t max_depth = 32;
+static const size_t max_comparisons = 128;
+
+struct FilterToken
+{
+	enum token_type
+	{
+		end,
+		open,
+		close,
+		word,
+		string,
+		number,
+		typed
+	};
+
+	FilterToken() : type(end), position(0) {}
+
+	token_type type;
+	string_t text;
+	//datetime or guid for typed literals
+	string_t prefix;
+	size_t position;
+};
+
+static bool isWordStart(char_t c)
+{
+	return (c >= U('A') && c <= U('Z')) || (c >= U('a') && c <= U('z')) || c == U('_');
+}
+
+static bool isDigit(char_t c)
+{
+	return c >= U('0') && c <= U('9');
+}
+
+static bool isWordChar(char_t c)
+{
+	return isWordStart(c) || isDigit(c);
+}
+
+static bool isHex(char_t c)
+{
+	return isDigit(c) || (c >= U('a') && c <= U('f')) || (c >= U('A') && c <= U('F'));
+}
+
+static bool isComparison(const string_t &word)
+{
+	return word == U("eq") || word == U("ne") || word == U("gt") || word == U("ge") || word == U("lt") || word == U("le");
+}
+
+static bool isReserved(const string_t &word)
+{
+	return isComparison(word) || word == U("and") || word == U("or") || word == U("not")
+		|| word == U("true") || word == U("false") || word == U("null");
+}
+
+/// <summary>
+/// Operator with its operands swapped, a lt b is b gt a.
+/// </summary>
+static string_t mirrorComparison(const string_t &comparison)
+{
+	if (comparison == U("gt"))
+		return U("lt");
+	if (comparison == U("ge"))
+		return U("le");
+	if (comparison == U("lt"))
+		return U("gt");
+	if (comparison == U("le"))
+		return U("ge");
+	return comparison;
+}
+
+static string_t sqlComparison(const string_t &comparison)
+{
+	if (comparison == U("ne"))
+		return U(" <> ?");
+	if (comparison == U("gt"))
+		return U(" > ?");
+	if (comparison == U("ge"))
+		return U(" >= ?");
+	if (comparison == U("lt"))
+		return U(" < ?");
+	if (comparison == U("le"))
+		return U(" <= ?");
+	return U(" = ?");
+}
+
+static string_t positionError(const string_t &message, size_t position)
+{
+	return message + U(" at position ") + conversions::to_string_t(std::to_string(position));
+}
+
+class FilterParser
+{
+public:
+	FilterParser(const string_t &expression) : m_text(expression), m_index(0), m_depth(0), m_comparisons(0) {}
+
+	std::shared_ptr<const ODataFilter::Node> parse(string_t &error)
+	{
+		if (!tokenize(error))
+			return nullptr;
+
+		auto root = parseOr(error);
+		if (root && m_tokens[m_index].type != FilterToken::end)
+		{
+			error = positionError(U("Unexpected '") + m_tokens[m_index].text + U("'"), m_tokens[m_index].position);
+			return nullptr;
+		}
+		return root;
+	}
+
+	size_t comparisons() const { return m_comparisons; }
+
+private:
+	typedef ODataFilter::Node Node;
+	typedef std::shared_ptr<const Node> node_ptr;
+
+	bool tokenize(string_t &error)
+	{
+		size_t pos = 0;
+		while (pos < m_text.size())
+		{
+			char_t c = m_text[pos];
+			if (c == U(' ') || c == U('\t'))
+			{
+				++pos;
+				continue;
+			}
+
+			FilterToken token;
+			token.position = pos;
+
+			if (c == U('(') || c == U(')'))
+			{
+				token.type = c == U('(') ? FilterToken::open : FilterToken::close;
+				token.text = string_t(1, c);
+				++pos;
+			}
+			else if (c == U('\''))
+			{
+				token.type = FilterToken::string;
+				if (!readQuoted(pos, token.text))
+				{
+					error = positionError(U("Unterminated string"), token.position);
+					return false;
+				}
+			}
+			else if (isWordStart(c))
+			{
+				size_t begin = pos;
+				while (pos < m_text.size() && isWordChar(m_text[pos]))
+					++pos;
+				token.type = FilterToken::word;
+				token.text = m_text.substr(begin, pos - begin);
+
+				//datetime'...' and guid'...'
+				if (pos < m_text.size() && m_text[pos] == U('\''))
+				{
+					if (token.text != U("datetime") && token.text != U("guid"))
+					{
+						error = positionError(U("Unsupported literal ") + token.text, token.position);
+						return false;
+					}
+					token.type = FilterToken::typed;
+					token.prefix = token.text;
+					if (!readQuoted(pos, token.text))
+					{
+						error = positionError(U("Unterminated string"), token.position);
+						return false;
+					}
+				}
+			}
+			else if (isDigit(c) || ((c == U('-') || c == U('.')) && pos + 1 < m_text.size() && (isDigit(m_text[pos + 1]) || m_text[pos + 1] == U('.'))))
+			{
+				size_t begin = pos;
+				if (m_text[pos] == U('-'))
+					++pos;
+				while (pos < m_text.size() && (isDigit(m_text[pos]) || m_text[pos] == U('.')))
+					++pos;
+				if (pos < m_text.size() && (m_text[pos] == U('e') || m_text[pos] == U('E')))
+				{
+					++pos;
+					if (pos < m_text.size() && (m_text[pos] == U('+') || m_text[pos] == U('-')))
+						++pos;
+					while (pos < m_text.size() && isDigit(m_text[pos]))
+						++pos;
+				}
+				//Type suffix, L for 64-bit integers, d, f or m for floating point
+				if (pos < m_text.size() && (m_text[pos] == U('L') || m_text[pos] == U('l') || m_text[pos] == U('d') || m_text[pos] == U('D')
+					|| m_text[pos] == U('f') || m_text[pos] == U('F') || m_text[pos] == U('m') || m_text[pos] == U('M')))
+				{
+					++pos;
+				}
+				if (pos < m_text.size() && isWordChar(m_text[pos]))
+				{
+					error = positionError(U("Invalid number"), begin);
+					return false;
+				}
+				token.type = FilterToken::number;
+				token.text = m_text.substr(begin, pos - begin);
+			}
+			else
+			{
+				error = positionError(U("Unexpected character '") + string_t(1, c) + U("'"), pos);
+				return false;
+			}
+			m_tokens.push_back(token);
+		}
+
+		FilterToken end;
+		end.position = m_text.size();
+		m_tokens.push_back(end);
+		return true;
+	}
+
+	/// <summary>
+	/// Reads a quoted string starting at pos, '' stands for a single quote.
+	/// </summary>
+	bool readQuoted(size_t &pos, string_t &value)
+	{
+		value.clear();
+		++pos;
+		while (pos < m_text.size())
+		{
+			if (m_text[pos] == U('\''))
+			{
+				if (pos + 1 < m_text.size() && m_text[pos + 1] == U('\''))
+				{
+					value.push_back(U('\''));
+					pos += 2;
+					continue;
+				}
+				++pos;
+				return true;
+			}
+			value.push_back(m_text[pos++]);
+		}
+		return false;
+	}
+
+	bool acceptWord(const char_t *word)
+	{
+		const FilterToken &token = m_tokens[m_index];
+		if (token.type == FilterToken::word && token.text == word)
+		{
+			++m_index;
+			return true;
+		}
+		return false;
+	}
+
+	node_ptr combine(ODataFilter::node_type type, node_ptr left, node_ptr right)
+	{
+		auto node = std::make_shared<Node>();
+		node->type = type;
+		node->left = left;
+		node->right = right;
+		return node;
+	}
+
+	node_ptr parseOr(string_t &error)
+	{
+		node_ptr left = parseAnd(error);
+		while (left && acceptWord(U("or")))
+		{
+			node_ptr right = parseAnd(error);
+			if (!right)
+				return nullptr;
+			left = combine(ODataFilter::node_type::or_node, left, right);
+		}
+		return left;
+	}
+
+	node_ptr parseAnd(string_t &error)
+	{
+		node_ptr left = parseUnary(error);
+		while (left && acceptWord(U("and")))
+		{
+			node_ptr right = parseUnary(error);
+			if (!right)
+				return nullptr;
+			left = combine(ODataFilter::node_type::and_node, left, right);
+		}
+		return left;
+	}
+
+	node_ptr parseUnary(string_t &error)
+	{
+		if (++m_depth > max_depth)
+		{
+			error = positionError(U("Filter is nested too deeply"), m_tokens[m_index].position);
+			return nullptr;
+		}
+
+		node_ptr node;
+		if (acceptWord(U("not")))
+		{
+			node_ptr operand = parseUnary(error);
+			if (operand)
+				node = combine(ODataFilter::node_type::not_node, operand, nullptr);
+		}
+		else if (m_tokens[m_index].type == FilterToken::open)
+		{
+			++m_index;
+			node = parseOr(error);
+			if (node && m_tokens[m_index].type != FilterToken::close)
+			{
+				error = positionError(U("Expected ')'"), m_tokens[m_index].position);
+				node = nullptr;
+			}
+			else if (node)
+			{
+				++m_index;
+			}
+		}
+		else
+		{
+			node = parseComparison(error);
+		}
+
+		--m_depth;
+		return node;
+	}
+
+	static bool isOperand(const FilterToken &token)
+	{
+		return token.type == FilterToken::word || token.type == FilterToken::string
+			|| token.type == FilterToken::number || token.type == FilterToken::typed;
+	}
+
+	static bool isProperty(const FilterToken &token)
+	{
+		return token.type == FilterToken::word && !isReserved(token.text);
+	}
+
+	node_ptr parseComparison(string_t &error)
+	{
+		const FilterToken &first = m_tokens[m_index];
+		if (!isOperand(first))
+		{
+			error = positionError(U("Expected a comparison"), first.position);
+			return nullptr;
+		}
+		++m_index;
+
+		const FilterToken &comparison = m_tokens[m_index];
+		if (comparison.type != FilterToken::word || !isComparison(comparison.text))
+		{
+			error = positionError(U("Expected eq, ne, gt, ge, lt or le"), comparison.position);
+			return nullptr;
+		}
+		++m_index;
+
+		const FilterToken &second = m_tokens[m_index];
+		if (!isOperand(second))
+		{
+			error = positionError(U("Expected a value"), second.position);
+			return nullptr;
+		}
+		++m_index;
+
+		if (++m_comparisons > max_comparisons)
+		{
+			error = positionError(U("Filter has too many comparisons"), comparison.position);
+			return nullptr;
+		}
+
+		auto node = std::make_shared<Node>();
+		node->type = ODataFilter::node_type::comparison;
+
+		if (isProperty(first))
+		{
+			node->property = first.text;
+			node->comparison = comparison.text;
+			if (!readLiteral(second, node->value, error))
+				return nullptr;
+		}
+		else if (isProperty(second) && first.type != FilterToken::word)
+		{
+			node->property = second.text;
+			node->comparison = mirrorComparison(comparison.text);
+			if (!readLiteral(first, node->value, error))
+				return nullptr;
+		}
+		else
+		{
+			error = positionError(U("A comparison needs a property name"), first.position);
+			return nullptr;
+		}
+		return node;
+	}
+
+	static bool readLiteral(const FilterToken &token, ODataFilter::Literal &literal, string_t &error)
+	{
+		typedef ODataFilter::literal_type literal_type;
+
+		literal.text = token.text;
+		switch (token.type)
+		{
+		case FilterToken::string:
+			literal.type = literal_type::string;
+			return true;
+		case FilterToken::word:
+			if (token.text == U("true") || token.text == U("false"))
+			{
+				literal.type = literal_type::boolean;
+				literal.boolean_value = token.text == U("true");
+				return true;
+			}
+			if (token.text == U("null"))
+			{
+				error = positionError(U("null is not supported"), token.position);
+				return false;
+			}
+			//Unquoted words are strings, as accepted by the old filter syntax
+			literal.type = literal_type::string;
+			return true;
+		case FilterToken::number:
+			return readNumber(token, literal, error);
+		case FilterToken::typed:
+			if (token.prefix == U("datetime"))
+			{
+				datetime value = datetime::from_string(token.text, datetime::ISO_8601);
+				if (!value.is_initialized())
+				{
+					error = positionError(U("Invalid datetime"), token.position);
+					return false;
+				}
+				literal.type = literal_type::datetime;
+				//Normalized to UTC, both storages compare the same instant
+				literal.text = value.to_string(datetime::ISO_8601);
+				return true;
+			}
+			if (!isGuid(token.text))
+			{
+				error = positionError(U("Invalid guid"), token.position);
+				return false;
+			}
+			literal.type = literal_type::guid;
+			return true;
+		default:
+			error = positionError(U("Expected a value"), token.position);
+			return false;
+		}
+	}
+
+	static bool readNumber(const FilterToken &token, ODataFilter::Literal &literal, string_t &error)
+	{
+		std::string text = conversions::to_utf8string(token.text);
+		char suffix = text.back();
+		bool floating = text.find_first_of(".eE") != std::string::npos;
+
+		if (suffix == 'L' || suffix == 'l' || suffix == 'd' || suffix == 'D' || suffix == 'f' || suffix == 'F' || suffix == 'm' || suffix == 'M')
+		{
+			text.pop_back();
+			floating = floating || (suffix != 'L' && suffix != 'l');
+		}
+		else
+		{
+			suffix = 0;
+		}
+
+		const char *begin = text.c_str();
+		char *end = nullptr;
+		errno = 0;
+		if (floating)
+		{
+			if (suffix == 'L' || suffix == 'l')
+			{
+				error = positionError(U("Invalid number"), token.position);
+				return false;
+			}
+			literal.type = ODataFilter::literal_type::double_floating_point;
+			literal.double_value = std::strtod(begin, &end);
+		}
+		else
+		{
+			literal.int_value = std::strtoll(begin, &end, 10);
+			literal.type = (suffix == 'L' || suffix == 'l' || literal.int_value < INT32_MIN || literal.int_value > INT32_MAX)
+				? ODataFilter::literal_type::int64 : ODataFilter::literal_type::int32;
+		}
+
+		if (errno == ERANGE || end == begin || *end != '\0')
+		{
+			error = positionError(U("Invalid number"), token.position);
+			return false;
+		}
+		return true;
+	}
+
+	static bool isGuid(const string_t &text)
+	{
+		if (text.size() != 36)
+			return false;
+		for (size_t i = 0; i < text.size(); ++i)
+		{
+			bool dash = i == 8 || i == 13 || i == 18 || i == 23;
+			if (dash ? text[i] != U('-') : !isHex(text[i]))
+				return false;
+		}
+		return true;
+	}
+
+	const string_t &m_text;
+	std::vector<FilterToken> m_tokens;
+	size_t m_index;
+	size_t m_depth;
+	size_t m_comparisons;
+};
+
+bool ODataFilter::parse(const string_t &expression, ODataFilter &filter, string_t &error)
+{
+	FilterParser parser(expression);
+	auto root = parser.parse(error);
+	if (!root)
+		return false;
+
+	filter.m_root = root;
+	filter.m_comparisons = parser.comparisons();
+	return true;
+}
+
+static mysql_property toMysqlProperty(const ODataFilter::Literal &literal)
+{
+	switch (literal.type)
+	{
+	case ODataFilter::literal_type::boolean:
+		return mysql_property(literal.boolean_value);
+	case ODataFilter::literal_type::int32:
+		return mysql_property(static_cast<int32_t>(literal.int_value));
+	case ODataFilter::literal_type::int64:
+		return mysql_property(static_cast<int64_t>(literal.int_value));
+	case ODataFilter::literal_type::double_floating_point:
+		return mysql_property(literal.double_value);
+	case ODataFilter::literal_type::datetime:
+	{
+		//MySQL DATETIME text, 2015-01-31 10:00:00
+		string_t text = literal.text;
+		if (!text.empty() && text.back() == U('Z'))
+			text.pop_back();
+		size_t separator = text.find(U('T'));
+		if (separator != string_t::npos)
+			text[separator] = U(' ');
+		return mysql_property(text);
+	}
+	default:
+		return mysql_property(literal.text);
+	}
+}
+
+static string_t compileSql(const ODataFilter::Node &node, std::vector<mysql_property> &parameters)
+{
+	//The operands of + are evaluated in no set order, the left side is compiled first so the
+	//parameters follow the placeholders
+	string_t left;
+	switch (node.type)
+	{
+	case ODataFilter::node_type::and_node:
+		left = compileSql(*node.left, parameters);
+		return U("(") + left + U(" AND ") + compileSql(*node.right, parameters) + U(")");
+	case ODataFilter::node_type::or_node:
+		left = compileSql(*node.left, parameters);
+		return U("(") + left + U(" OR ") + compileSql(*node.right, parameters) + U(")");
+	case ODataFilter::node_type::not_node:
+		return U("NOT (") + compileSql(*node.left, parameters) + U(")");
+	default:
+		parameters.push_back(toMysqlProperty(node.value));
+		return U("`") + node.property + U("`") + sqlComparison(node.comparison);
+	}
+}
+
+static string_t compileAzure(const ODataFilter::Node &node)
+{
+	using azure::storage::table_query;
+
+	switch (node.type)
+	{
+	case ODataFilter::node_type::and_node:
+		return table_query::combine_filter_conditions(compileAzure(*node.left), U("and"), compileAzure(*node.right));
+	case ODataFilter::node_type::or_node:
+		return table_query::combine_filter_conditions(compileAzure(*node.left), U("or"), compileAzure(*node.right));
+	case ODataFilter::node_type::not_node:
+		return U("not (") + compileAzure(*node.left) + U(")");
+	default:
+		break;
+	}
+
+	const ODataFilter::Literal &value = node.value;
+	switch (value.type)
+	{
+	case ODataFilter::literal_type::boolean:
+		return table_query::generate_filter_condition(node.property, node.comparison, value.boolean_value);
+	case ODataFilter::literal_type::int32:
+		return table_query::generate_filter_condition(node.property, node.comparison, static_cast<int32_t>(value.int_value));
+	case ODataFilter::literal_type::int64:
+		return table_query::generate_filter_condition(node.property, node.comparison, static_cast<int64_t>(value.int_value));
+	case ODataFilter::literal_type::double_floating_point:
+		return table_query::generate_filter_condition(node.property, node.comparison, value.double_value);
+	case ODataFilter::literal_type::datetime:
+		return table_query::generate_filter_condition(node.property, node.comparison, datetime::from_string(value.text, datetime::ISO_8601));
+	case ODataFilter::literal_type::guid:
+		return table_query::generate_filter_condition(node.property, node.comparison, utility::string_to_uuid(value.text));
+	default:
+		return table_query::generate_filter_condition(node.property, node.comparison, value.text);
+	}
+}
+
+string_t ODataFilter::toSql(std::vector<mysql_property> &parameters) const
+{
+	if (!m_root)
+		return string_t();
+	return compileSql(*m_root, parameters);
+}
+
+string_t ODataFilter::toAzure() const
+{
+	if (!m_root)
+		return string_t();
+	return compileAzure(*m_root);
+}
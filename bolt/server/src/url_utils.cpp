@@ -1,7 +1,6 @@
 #include <url_utils.hpp>
 #include <boost/algorithm/string/split.hpp>
 #include <boost/algorithm/string/classification.hpp>
-#include <regex>
 #include <message_types.hpp>
 
 vector<string_t> UrlUtils::splitUri(const http_request& message)
@@ -9,9 +8,176 @@ vector<string_t> UrlUtils::splitUri(const http_request& message)
 	return uri::split_path(uri::decode(message.relative_uri().path()));
 }
 
+static bool isAsciiLetter(char_t c)
+{
+	return (c >= U('A') && c <= U('Z')) || (c >= U('a') && c <= U('z'));
+}
+
+static bool isAsciiDigit(char_t c)
+{
+	return c >= U('0') && c <= U('9');
+}
+
+/// <summary>
+/// Table names start with a letter, continue with letters or digits and are 3 to 63 characters long.
+/// </summary>
+static bool isTableName(const string_t& str, size_t begin, size_t end)
+{
+	if (end - begin < 3 || end - begin > 63 || !isAsciiLetter(str[begin]))
+		return false;
+
+	for (size_t i = begin + 1; i < end; ++i)
+	{
+		if (!isAsciiLetter(str[i]) && !isAsciiDigit(str[i]))
+			return false;
+	}
+	return true;
+}
+
+/// <summary>
+/// Key values are one or more letters, digits or underscores.
+/// </summary>
+static bool isKeyValue(const string_t& str, size_t begin, size_t end)
+{
+	if (begin >= end)
+		return false;
+
+	for (size_t i = begin; i < end; ++i)
+	{
+		if (!isAsciiLetter(str[i]) && !isAsciiDigit(str[i]) && str[i] != U('_'))
+			return false;
+	}
+	return true;
+}
+
+static bool matchAt(const string_t& str, size_t pos, const char_t* literal, size_t length)
+{
+	return str.compare(pos, length, literal) == 0;
+}
+
+/// <summary>
+/// Parses Tables('name').
+/// </summary>
+static bool parseTablesSegment(const string_t& segment, string_t& table)
+{
+	static const char_t prefix[] = U("Tables('");
+	static const size_t prefix_length = sizeof(prefix) / sizeof(char_t) - 1;
+
+	if (segment.size() < prefix_length + 2 || !matchAt(segment, 0, prefix, prefix_length)
+		|| segment[segment.size() - 2] != U('\'') || segment[segment.size() - 1] != U(')'))
+	{
+		return false;
+	}
+
+	if (!isTableName(segment, prefix_length, segment.size() - 2))
+		return false;
+
+	table = segment.substr(prefix_length, segment.size() - 2 - prefix_length);
+	return true;
+}
+
+/// <summary>
+/// Parses name, name() and name(PartitionKey='pk',RowKey='rk').
+/// </summary>
+/// <returns>false when the segment is none of these.</returns>
+static bool parseEntitySegment(const string_t& segment, string_t& table, string_t& partition_key, string_t& row_key)
+{
+	static const char_t partition_prefix[] = U("PartitionKey='");
+	static const size_t partition_prefix_length = sizeof(partition_prefix) / sizeof(char_t) - 1;
+	static const char_t row_separator[] = U("',RowKey='");
+	static const size_t row_separator_length = sizeof(row_separator) / sizeof(char_t) - 1;
+
+	size_t open = segment.find(U('('));
+	if (open == string_t::npos)
+	{
+		if (!isTableName(segment, 0, segment.size()))
+			return false;
+		table = segment;
+		partition_key.clear();
+		row_key.clear();
+		return true;
+	}
+
+	if (!isTableName(segment, 0, open) || segment.back() != U(')'))
+		return false;
+
+	size_t close = segment.size() - 1;
+	if (close == open + 1)
+	{
+		table = segment.substr(0, open);
+		partition_key.clear();
+		row_key.clear();
+		return true;
+	}
+
+	size_t partition_begin = open + 1 + partition_prefix_length;
+	if (close < partition_begin || !matchAt(segment, open + 1, partition_prefix, partition_prefix_length))
+		return false;
+
+	size_t partition_end = segment.find(row_separator, partition_begin);
+	if (partition_end == string_t::npos || segment[close - 1] != U('\''))
+		return false;
+
+	size_t row_begin = partition_end + row_separator_length;
+	size_t row_end = close - 1;
+	if (row_begin > row_end || !isKeyValue(segment, partition_begin, partition_end) || !isKeyValue(segment, row_begin, row_end))
+		return false;
+
+	table = segment.substr(0, open);
+	partition_key = segment.substr(partition_begin, partition_end - partition_begin);
+	row_key = segment.substr(row_begin, row_end - row_begin);
+	return true;
+}
+
+Route UrlUtils::parseRoute(const http_request& message)
+{
+	Route route;
+	route.paths = splitUri(message);
+	route.query = splitQueryString(message);
+
+	if (route.paths.empty())
+		return route;
+
+	const string_t& first = route.paths[0];
+	if (first == U("Tables"))
+	{
+		route.type = Route::route_type::tables;
+	}
+	else if (first == U("Query"))
+	{
+		route.type = Route::route_type::query;
+	}
+	else if (first == U("Administration"))
+	{
+		route.type = Route::route_type::administration;
+	}
+	else if (parseTablesSegment(first, route.table))
+	{
+		route.type = Route::route_type::table;
+	}
+	else if (parseEntitySegment(first, route.table, route.partition_key, route.row_key))
+	{
+		route.type = route.partition_key.empty() ? Route::route_type::collection : Route::route_type::entity;
+	}
+
+	route.batch = hasBatch(route.paths);
+	getFilter(route.query, route.filter, route.query_error);
+	if (!getTop(route.query, route.top))
+		route.query_error = U("$top must be a positive number");
+
+	auto next_partition_key = route.query.find(NEXT_PARTITION_KEY);
+	if (next_partition_key != route.query.end())
+		route.next_partition_key = next_partition_key->second;
+	auto next_row_key = route.query.find(NEXT_ROW_KEY);
+	if (next_row_key != route.query.end())
+		route.next_row_key = next_row_key->second;
+
+	return route;
+}
+
 /// <summary>
 /// Gets the name of the table.
-/// Validates the table name using regular expression
+/// Validates the table name
 /// Returns true if maches otherwise returns false
 /// </summary>
 /// <param name="paths">vector of paths.</param>
@@ -19,17 +185,8 @@ vector<string_t> UrlUtils::splitUri(const http_request& message)
 /// <returns></returns>
 bool UrlUtils::getTableName(const vector<string_t> paths, string_t &table)
 {
-	//Expression will check for Table('name')
-	//Table name must be 2 to 62 long and  can have alphanumaric characters
-	const wregex expression(U("^(?:Tables\\(')([A-Za-z][A-Za-z0-9]{2,62})(?:'\\))$"));
-	wsmatch what;
-	//Path[1] is the Table('name')
-	if (regex_match(paths[0], what, expression))
-	{
-		table = what[1]; //There are three sets in the expression, 2nd is the table name
-		return true;
-	}
-	return false;
+	//Checks for Tables('name')
+	return !paths.empty() && parseTablesSegment(paths[0], table);
 }
 
 
@@ -46,7 +203,13 @@ bool UrlUtils::getTableNamespace(const vector<string_t> paths, string_t &tablena
 
 map<string_t, string_t> UrlUtils::splitQueryString(const http_request& message)
 {
-	return uri::split_query(uri::decode(message.relative_uri().query()));
+	//Decoded after splitting, so an encoded & or = stays inside its value
+	map<string_t, string_t> query;
+	for (const auto& pair : uri::split_query(message.relative_uri().query()))
+	{
+		query[uri::decode(pair.first)] = uri::decode(pair.second);
+	}
+	return query;
 }
 
 vector<string_t> UrlUtils::getColumnNames(string_t str)
@@ -83,36 +246,33 @@ bool UrlUtils::hasAdministration(vector<string_t> const paths)
 	return false;
 }
 
-bool UrlUtils::getTableNameWithKeys(vector<string_t> const paths, string_t& table, string_t& rowkey, string_t& paritionkey)
+bool UrlUtils::hasBatch(vector<string_t> const paths)
 {
-	//Expression will check for tablename(RowKey='<rowkey>',PartitionKey='<partitionkey>')
-	//Table name must be 2 to 62 long and  can have alphanumaric characters
-	const wregex expression(U("^([A-Za-z][A-Za-z0-9]{2,62})(?:\\()(?:(?:PartitionKey=')(\\w+)(?:',RowKey=')(\\w+)(?:'))?(?:\\))$"));
-	wsmatch what;
-	//Path[1] is the Table('name')
-	if (regex_match(paths[0], what, expression))
+	if (paths.size() >= 2 && paths[1] == U("$batch"))
 	{
-		table = what[1]; //There are three sets in the expression, 2nd is the table name
-		paritionkey = what[2];
-		rowkey = what[3];
 		return true;
 	}
 	return false;
 }
 
+bool UrlUtils::getTableNameWithKeys(vector<string_t> const paths, string_t& table, string_t& rowkey, string_t& paritionkey)
+{
+	//Checks for tablename(PartitionKey='<partitionkey>',RowKey='<rowkey>') or tablename()
+	return !paths.empty() && paths[0].find(U('(')) != string_t::npos
+		&& parseEntitySegment(paths[0], table, paritionkey, rowkey);
+}
+
 bool UrlUtils::getTableNameWithoutKeys(vector<string_t> const paths, string_t& table)
 {
-	//Expression will check for tablename(RowKey='<rowkey>',PartitionKey='<partitionkey>')
-	//Table name must be 2 to 62 long and  can have alphanumaric characters
-	const wregex expression(U("^([A-Za-z][A-Za-z0-9]{2,62})(?:\\()?(?:\\))?$"));
-	wsmatch what;
-	//Path[1] is the Table('name')
-	if (regex_match(paths[0], what, expression))
-	{
-		table = what[1]; //There are three sets in the expression, 2nd is the table name
-		return true;
-	}
-	return false;
+	//Checks for tablename or tablename()
+	string_t partition_key;
+	string_t row_key;
+	string_t name;
+	if (paths.empty() || !parseEntitySegment(paths[0], name, partition_key, row_key) || !partition_key.empty())
+		return false;
+
+	table = name;
+	return true;
 }
 
 bool UrlUtils::getAnalyze(vector<string_t> const paths, string_t& tablename)
@@ -211,42 +371,68 @@ bool UrlUtils::hasOpenTables(vector<string_t> const paths)
 	return false;
 }
 
-bool UrlUtils::getFilter(map<string_t, string_t> const query, map<string_t, string_t> &filter)
+bool UrlUtils::hasPools(vector<string_t> const paths)
 {
-	map<string_t, string_t> parsed_query;
+	if (paths.size() >= 2 && paths[1] == U("Pools"))
+	{
+		return true;
+	}
+	return false;
+}
 
-	//Expression will check for tablename(RowKey='<rowkey>',PartitionKey='<partitionkey>')
-	//Table name must be 2 to 62 long and  can have alphanumaric characters
-	string_t expression_string = U("^(?:(?:\\()(\\w+)(?:\\s)(le|lt|ge|gt|ne|eq)(?:\\s)(\\w+)(?:\\)))(?:(?:\\s)(and|or)(?:\\s)(?:(?:\\()(\\w+)(?:\\s)(le|lt|ge|gt|ne|eq)(?:\\s)(\\w+)(?:\\))))?$");
-	auto lfilter = query.find(FILTER);
-	if (lfilter != query.end())
+bool UrlUtils::hasGrants(vector<string_t> const paths)
+{
+	if (paths.size() >= 2 && paths[1] == U("Grants"))
 	{
-		const wregex expression(expression_string);
-		wsmatch what;
-		//Path[1] is the Table('name')
-		string_t filter_value = lfilter->second;
-		if (regex_match(filter_value, what, expression))
-		{
-			if (what.size() >= 3)
-			{
-				parsed_query.insert(make_pair(U("first_attr"), what[1]));
-				parsed_query.insert(make_pair(U("first_con"), what[2]));
-				parsed_query.insert(make_pair(U("first_val"), what[3]));
-				if (what.size() == 8)
-				{
-					parsed_query.insert(make_pair(U("join"), what[4]));
-					parsed_query.insert(make_pair(U("second_attr"), what[5]));
-					parsed_query.insert(make_pair(U("second_con"), what[6]));
-					parsed_query.insert(make_pair(U("second_val"), what[7]));
-				}
-				filter = parsed_query;
-				return true;
-			}
-		}
+		return true;
+	}
+	return false;
+}
+
+bool UrlUtils::getSigningKeys(vector<string_t> const paths, string_t& account)
+{
+	//SigningKeys, or SigningKeys/<account>
+	if (paths.size() >= 2 && paths[1] == U("SigningKeys"))
+	{
+		account = paths.size() >= 3 ? paths[2] : string_t();
+		return true;
 	}
 	return false;
 }
 
+bool UrlUtils::getFilter(const map<string_t, string_t> &query, ODataFilter &filter, string_t &error)
+{
+	auto lfilter = query.find(FILTER);
+	if (lfilter == query.end())
+		return false;
+
+	return ODataFilter::parse(lfilter->second, filter, error);
+}
+
+bool UrlUtils::getTop(const map<string_t, string_t> &query, size_t &top)
+{
+	auto ltop = query.find(TOP);
+	if (ltop == query.end())
+		return true;
+
+	const string_t &value = ltop->second;
+	if (value.empty() || value.size() > 9)
+		return false;
+
+	size_t parsed = 0;
+	for (char_t c : value)
+	{
+		if (c < U('0') || c > U('9'))
+			return false;
+		parsed = parsed * 10 + static_cast<size_t>(c - U('0'));
+	}
+	if (parsed == 0)
+		return false;
+
+	top = parsed;
+	return true;
+}
+
 bool UrlUtils::getSelect(map<string_t, string_t> const query, vector<string_t>& select)
 {
 	if (query.find(SELECT) != query.cend())
@@ -8,11 +8,105 @@
 #include "was/table.h"
 #include <metadata.hpp>
 #include <ahttppost.hpp>
+#include <configuration.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 using namespace azure;
 using namespace storage;
 using namespace bolt::auth;
 
-WholeHandler::WholeHandler(const http_request &request, const method method) : m_http_request(request)
+namespace
+{
+	/// <summary>
+	/// A write posted to the blocking executor. It runs once, either on an executor thread
+	/// or on the thread waiting for it when no executor thread has picked it up yet,
+	/// so handlers waiting on the executor's own threads cannot starve it.
+	/// Failures, exceptions included, are logged and reported as not written.
+	/// </summary>
+	class PostedWrite
+	{
+	public:
+		PostedWrite(std::function<bool()> write, const char *side) : m_write(write), m_side(side), m_claimed(false), m_done(false), m_written(false)
+		{
+		}
+
+		void run()
+		{
+			if (m_claimed.exchange(true))
+				return;
+
+			bool written = false;
+			try
+			{
+				written = m_write();
+			}
+			catch (const std::exception &e)
+			{
+				BoltLog logger;
+				logger << BoltLog::LOG_ERROR << "WholeHandler: write to " << m_side << " failed #ERR: " << e.what();
+			}
+			catch (...)
+			{
+				BoltLog logger;
+				logger << BoltLog::LOG_ERROR << "WholeHandler: write to " << m_side << " failed";
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_written = written;
+				m_done = true;
+			}
+			m_finished.notify_all();
+		}
+
+		bool wait()
+		{
+			run();
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_finished.wait(lock, [this] { return m_done; });
+			return m_written;
+		}
+
+	private:
+		std::function<bool()> m_write;
+		const char *m_side;
+		std::atomic<bool> m_claimed;
+		std::mutex m_mutex;
+		std::condition_variable m_finished;
+		bool m_done;
+		bool m_written;
+	};
+
+	/// <summary>
+	/// Rolls back a side that committed while the other side failed. A row the request did not create
+	/// keeps the new values, deleting it would lose the data it held before the request.
+	/// </summary>
+	void compensate(bool written, bool created, std::function<bool()> abort, const char *side)
+	{
+		if (!written)
+			return;
+
+		BoltLog logger;
+		if (!created)
+			logger << BoltLog::LOG_ERROR << "WholeHandler: the existing row in " << side << " keeps the new values, the other side failed";
+		else if (!abort())
+			logger << BoltLog::LOG_ERROR << "WholeHandler: removing the row created in " << side << " failed";
+	}
+
+	/// <summary>
+	/// Queues the write on the executor, a full executor runs it on the calling thread instead of dropping it.
+	/// </summary>
+	std::shared_ptr<PostedWrite> post(BlockingExecutor &executor, std::function<bool()> write, const char *side)
+	{
+		auto posted = std::make_shared<PostedWrite>(write, side);
+		if (!executor.tryPost([posted]() { posted->run(); }))
+			posted->run();
+		return posted;
+	}
+}
+
+WholeHandler::WholeHandler(const http_request &request, const method method, const Route &route, BlockingExecutor &executor) : m_http_request(request), m_route(route), m_executor(executor)
 {
 	m_method = method;
 
@@ -50,25 +144,17 @@ void WholeHandler::HandleGet()
 void WholeHandler::HandlePost()
 {
 	http_headers headers = m_http_request.headers();
-	auto paths = UrlUtils::splitUri(m_http_request);
-
-	if (paths.empty())
-	{
-		m_http_request.reply(status_codes::BadRequest);
-		return;
-	}
-
-	//Requested table name
-	string_t table_name;
 
 	// get the JSON value from the task and display content from it
 
-	if (!UrlUtils::getTableNameWithoutKeys(paths, table_name))
+	if (m_route.type != Route::route_type::collection)
 	{
 		m_http_request.reply(status_codes::BadRequest);
 		return;
 	}
 
+	const string_t &table_name = m_route.table;
+
 	json::value obj;
 	try
 	{
@@ -124,31 +210,77 @@ void WholeHandler::HandlePost()
 					insetKeyValuePropery(mentity, pair.first, pair.second);
 				}
 
-				if (entity.executeEntity())
-				{
-					if (mentity.executeEntity())
-					{
-						m_http_request.reply(status_codes::Created);
-						return;
-					}
-					else
-					{
-						entity.abort();
-						m_http_request.reply(status_codes::NotModified);
-						return;
-					}
-				}
-				else
-				{
-					m_http_request.reply(status_codes::NotModified);
-					return;
-				}
+				bool written = writeEntity(entity, mentity);
+				m_http_request.reply(written ? status_codes::Created : status_codes::NotModified);
+				return;
 			}
 		}
 	}
 	m_http_request.reply(status_codes::BadRequest);
 }
 
+/// <summary>
+/// Writes an entity to both databases as configured by whole-consistency.
+/// both: the writes run concurrently and a side that committed is rolled back with abort() when the other fails,
+/// as long as the request created its row there. A row that existed keeps the new values, the mismatch is logged.
+/// azure or mysql: only the primary write decides the result, the other side is written in the background.
+/// The second write runs on the blocking executor, storage calls never block the continuation pool.
+/// </summary>
+/// <returns>true when the write is committed according to the mode.</returns>
+bool WholeHandler::writeEntity(boltazure::AzureEntity azure_entity, mysql::MysqlEntity mysql_entity)
+{
+	static const string consistency = Config::getInstance().getStdConfigOption(Config::whole_consistency);
+
+	//Entities share their state between copies, the writes need const callables
+	auto azure_write = [azure_entity]() { boltazure::AzureEntity entity = azure_entity; return entity.executeEntity(); };
+	auto mysql_write = [mysql_entity]() { mysql::MysqlEntity entity = mysql_entity; return entity.executeEntity(); };
+
+	if (consistency == "azure" || consistency == "mysql")
+	{
+		bool azure_primary = consistency == "azure";
+		if (!(azure_primary ? azure_write() : mysql_write()))
+			return false;
+
+		//Replication failures cannot reach the client any more, they are logged
+		auto replicate = azure_primary ? std::function<bool()>(mysql_write) : std::function<bool()>(azure_write);
+		const char *replica = azure_primary ? "MySQL" : "Azure";
+		post(m_executor, [replicate, replica]()
+		{
+			bool written = replicate();
+			if (!written)
+			{
+				BoltLog logger;
+				logger << BoltLog::LOG_ERROR << "WholeHandler: replication to " << replica << " failed";
+			}
+			return written;
+		}, replica);
+		return true;
+	}
+
+	//abort() deletes the row, so only a row this request created is compensated. MySQL reports an insert
+	//exactly, Azure is looked up before its write.
+	auto azure_created = std::make_shared<bool>(false);
+	auto both_azure_write = [azure_entity, azure_created]()
+	{
+		boltazure::AzureEntity entity = azure_entity;
+		*azure_created = !entity.entityExists();
+		return entity.executeEntity();
+	};
+
+	//MySQL is written on this thread while Azure is written on the executor
+	auto azure_posted = post(m_executor, both_azure_write, "Azure");
+	bool mysql_written = PostedWrite(mysql_write, "MySQL").wait();
+	bool azure_written = azure_posted->wait();
+
+	if (azure_written && mysql_written)
+		return true;
+
+	//Compensate the side that committed
+	compensate(azure_written, *azure_created, [&azure_entity]() { return azure_entity.abort(); }, "Azure");
+	compensate(mysql_written, mysql_entity.inserted(), [&mysql_entity]() { return mysql_entity.abort(); }, "MySQL");
+	return false;
+}
+
 void WholeHandler::HandleDelete()
 {
 	m_http_request.reply(status_codes::BadRequest);
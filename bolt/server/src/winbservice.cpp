@@ -3,6 +3,7 @@
 #include <winbservice.hpp>
 #include <threadpool.hpp>
 #include <configuration.hpp>
+#include <permission_cache.hpp>
 
 WBService::WBService(PWSTR pszServiceName,
 	BOOL fCanStop,
@@ -58,6 +59,12 @@ void WBService::OnStart(DWORD dwArgc, LPWSTR *lpszArgv)
 	WriteEventLogEntry(L"WBService in OnStart",
 		EVENTLOG_INFORMATION_TYPE);
 
+	if (!Config::getInstance().isValid())
+	{
+		m_log_file << BoltLog::LOG_ERROR << "Invalid configuration, the service is not started";
+		throw static_cast<DWORD>(ERROR_BAD_CONFIGURATION);
+	}
+
 	// Queue the main service function for execution in a worker thread.
 	CThreadPool::QueueUserWorkItem(&WBService::ServiceWorkerThread, this);
 }
@@ -74,6 +81,12 @@ void WBService::ServiceWorkerThread(void)
 	
 	utility::string_t address = Config::getInstance().getServerHostWithPort();
 
+	m_log_file << BoltLog::LOG_INFO << "Loading permission cache";
+	if (!bolt::auth::PermissionCache::getInstance().reload())
+	{
+		m_log_file << BoltLog::LOG_WARNING << "Permission cache not loaded, permissions are read from MySQL until it is";
+	}
+
 	g_server_handler = shared_ptr<Dispatch>(new Dispatch(address));
 	g_server_handler->open().wait();
 
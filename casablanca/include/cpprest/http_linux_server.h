@@ -15,6 +15,8 @@
 #pragma once
 #include <boost/asio.hpp>
 #include <boost/bind.hpp>
+#include <boost/asio/deadline_timer.hpp>
+#include <deque>
 #include <set>
 #include "pplx/threadpool.h"
 #include "http_server.h"
@@ -46,56 +48,127 @@ private:
 
 class hostport_listener;
 
+// One acceptor of a hostport_listener. When a port has several acceptors each owns an io_service
+// and thread, and the connections it accepts are served by that thread.
+struct acceptor_shard
+{
+    // Null when the acceptor runs on the shared thread pool
+    std::unique_ptr<crossplat::threadpool> m_pool;
+    std::unique_ptr<boost::asio::ip::tcp::acceptor> m_acceptor;
+
+    boost::asio::io_service& service()
+    {
+        return m_pool ? m_pool->service() : crossplat::threadpool::shared_instance().service();
+    }
+};
+
 class connection
 {
 private:
+    // A request read from the connection, waiting for its response to be written.
+    // Responses are written in request order, a pipelined request answered early waits for those before it.
+    struct pending_response
+    {
+        pending_response() : ready(false), close(false), keep_alive(false) {}
+
+        http_response response;
+        bool ready;
+        // The connection is closed once this response is written
+        bool close;
+        // An HTTP/1.0 client asked for keep-alive and is told it got it
+        bool keep_alive;
+    };
+
     std::unique_ptr<boost::asio::ip::tcp::socket> m_socket;
     boost::asio::streambuf m_request_buf;
     boost::asio::streambuf m_response_buf;
+    boost::asio::deadline_timer m_idle_timer;
+    // Socket and idle timer handlers run on the strand, work resumed from task continuations is posted to it
+    boost::asio::io_service::strand m_strand;
     http_linux_server* m_p_server;
     hostport_listener* m_p_parent;
-    http_request m_request;
+    http_request m_request; // the request being read
     size_t m_read, m_write;
     size_t m_read_size, m_write_size;
-    bool m_close;
+    std::atomic<bool> m_close; // no request is read after the current one
+    bool m_keep_alive;
     bool m_chunked;
+    bool m_response_chunked;
+    bool m_response_close;
+    size_t m_requests;
+
+    // Guards the response queue, the reader and writer state below and the idle timer
+    pplx::extensibility::recursive_lock_t m_responses_lock;
+    std::deque<std::shared_ptr<pending_response>> m_responses;
+    bool m_writing;
+    bool m_read_paused;
+    // A closing response was written, the responses queued after it are failed instead of written
+    bool m_discard_responses;
+
+    // One reference for the read loop, one per queued response and one per wait on the idle timer
     std::atomic<int> m_refs; // track how many threads are still referring to this
     
 public:
-    connection(std::unique_ptr<boost::asio::ip::tcp::socket> socket, http_linux_server* server, hostport_listener* parent)
+    // service is the io_service the socket was accepted on, the idle timer and the strand run on it too
+    connection(std::unique_ptr<boost::asio::ip::tcp::socket> socket, boost::asio::io_service& service, http_linux_server* server, hostport_listener* parent)
     : m_socket(std::move(socket))
     , m_request_buf()
     , m_response_buf()
+    , m_idle_timer(service)
+    , m_strand(service)
     , m_p_server(server)
     , m_p_parent(parent)
+    , m_close(false)
+    , m_keep_alive(false)
+    , m_chunked(false)
+    , m_response_chunked(false)
+    , m_response_close(false)
+    , m_requests(0)
+    , m_writing(false)
+    , m_read_paused(false)
+    , m_discard_responses(false)
     , m_refs(1)
     {
+        ++listener::details::counters().open_connections;
         start_request_response();
     }
 
     connection(const connection&) = delete;
     connection& operator=(const connection&) = delete;
 
+    // Closes the connection from any thread, the socket is shut down on the strand
     void close();
 
 private:
+    bool add_ref_if_alive();
+    void close_socket();
     void start_request_response();
+    void read_next();
+    void arm_idle_timer();
+    void handle_idle_timeout(const boost::system::error_code& ec);
     void handle_http_line(const boost::system::error_code& ec);
-    void handle_headers();
+    void handle_headers(const char* cur, const char* end, bool http10);
+    void bad_request();
     void handle_body(const boost::system::error_code& ec);
     void handle_chunked_header(const boost::system::error_code& ec);
     void handle_chunked_body(const boost::system::error_code& ec, int toWrite);
-    void dispatch_request_to_listener();
+    void request_body_failed(status_code status);
+    void dispatch_request_to_listener(http_request request);
     void request_data_avail(size_t size);
     void do_response(bool bad_request);
+    void response_ready(const std::shared_ptr<pending_response>& pending, http_response response);
+    void write_next();
+    void discard_responses(std::vector<std::shared_ptr<pending_response>> discarded);
     template <typename ReadHandler>
     void async_read_until_buffersize(size_t size, ReadHandler handler);
-    void async_process_response(http_response response);
+    void async_process_response(http_response response, bool close, bool keep_alive);
     void cancel_sending_response_with_error(http_response response, std::exception_ptr);
     void handle_headers_written(http_response response, const boost::system::error_code& ec);
     void handle_write_large_response(http_response response, const boost::system::error_code& ec);
     void handle_write_chunked_response(http_response response, const boost::system::error_code& ec);
     void handle_response_written(http_response response, const boost::system::error_code& ec);
+    void response_written();
+    void release();
     void finish_request_response();
 };
 
@@ -104,7 +177,7 @@ class hostport_listener
 private:
     friend class connection;
 
-    std::unique_ptr<boost::asio::ip::tcp::acceptor> m_acceptor;
+    std::vector<std::unique_ptr<acceptor_shard>> m_shards;
     std::map<std::string, web::http::experimental::listener::details::http_listener_impl* > m_listeners;
     pplx::extensibility::reader_writer_lock_t m_listeners_lock;
 
@@ -116,15 +189,28 @@ private:
 
     std::string m_host;
     std::string m_port;
+
+    size_t m_acceptors;
+    bool m_pin_acceptors;
+    size_t m_body_chunk_size;
+    long m_keep_alive_timeout;
+    size_t m_max_requests_per_connection;
+    size_t m_max_pipelined_requests;
     
 public:
-     hostport_listener(http_linux_server* server, const std::string& hostport)
-    : m_acceptor()
+     hostport_listener(http_linux_server* server, const std::string& hostport, const http_listener_config& config = http_listener_config())
+    : m_shards()
     , m_listeners()
     , m_listeners_lock()
     , m_connections_lock()
     , m_connections()
     , m_p_server(server)
+    , m_acceptors(config.acceptors())
+    , m_pin_acceptors(config.pin_acceptors())
+    , m_body_chunk_size(config.body_chunk_size())
+    , m_keep_alive_timeout(static_cast<long>(config.keep_alive_timeout().count()))
+    , m_max_requests_per_connection(config.max_requests_per_connection())
+    , m_max_pipelined_requests(config.max_pipelined_requests())
     {
         m_all_connections_complete.set();
 
@@ -146,7 +232,8 @@ public:
     void remove_listener(const std::string& path, web::http::experimental::listener::details::http_listener_impl* listener);
 
 private:
-    void on_accept(boost::asio::ip::tcp::socket* socket, const boost::system::error_code& ec);
+    void accept(acceptor_shard* shard);
+    void on_accept(acceptor_shard* shard, boost::asio::ip::tcp::socket* socket, const boost::system::error_code& ec);
     
 };
 
@@ -32,6 +32,7 @@
 #error "Error: http server APIs are not supported in XP"
 #endif //_WIN32_WINNT < _WIN32_WINNT_VISTA
 
+#include <atomic>
 #include <limits>
 #include <functional>
 
@@ -59,7 +60,13 @@ public:
     /// Create an http_listener configuration with default options.
     /// </summary>
     http_listener_config()
-        : m_timeout(utility::seconds(120))
+        : m_timeout(utility::seconds(120)),
+          m_acceptors(1),
+          m_pin_acceptors(false),
+          m_body_chunk_size(4 * 1024),
+          m_keep_alive_timeout(utility::seconds(60)),
+          m_max_requests_per_connection(0),
+          m_max_pipelined_requests(16)
     {}
 
     /// <summary>
@@ -67,7 +74,13 @@ public:
     /// </summary>
     /// <param name="other">http_listener_config to copy.</param>
     http_listener_config(const http_listener_config &other)
-        : m_timeout(other.m_timeout)
+        : m_timeout(other.m_timeout),
+          m_acceptors(other.m_acceptors),
+          m_pin_acceptors(other.m_pin_acceptors),
+          m_body_chunk_size(other.m_body_chunk_size),
+          m_keep_alive_timeout(other.m_keep_alive_timeout),
+          m_max_requests_per_connection(other.m_max_requests_per_connection),
+          m_max_pipelined_requests(other.m_max_pipelined_requests)
     {}
 
     /// <summary>
@@ -75,7 +88,13 @@ public:
     /// <summary>
     /// <param name="other">http_listener_config to move from.</param>
     http_listener_config(http_listener_config &&other)
-        : m_timeout(std::move(other.m_timeout))
+        : m_timeout(std::move(other.m_timeout)),
+          m_acceptors(other.m_acceptors),
+          m_pin_acceptors(other.m_pin_acceptors),
+          m_body_chunk_size(other.m_body_chunk_size),
+          m_keep_alive_timeout(other.m_keep_alive_timeout),
+          m_max_requests_per_connection(other.m_max_requests_per_connection),
+          m_max_pipelined_requests(other.m_max_pipelined_requests)
     {}
 
     /// <summary>
@@ -87,6 +106,12 @@ public:
         if(this != &rhs)
         {
             m_timeout = rhs.m_timeout;
+            m_acceptors = rhs.m_acceptors;
+            m_pin_acceptors = rhs.m_pin_acceptors;
+            m_body_chunk_size = rhs.m_body_chunk_size;
+            m_keep_alive_timeout = rhs.m_keep_alive_timeout;
+            m_max_requests_per_connection = rhs.m_max_requests_per_connection;
+            m_max_pipelined_requests = rhs.m_max_pipelined_requests;
         }
         return *this;
     }
@@ -100,6 +125,12 @@ public:
         if(this != &rhs)
         {
             m_timeout = std::move(rhs.m_timeout);
+            m_acceptors = rhs.m_acceptors;
+            m_pin_acceptors = rhs.m_pin_acceptors;
+            m_body_chunk_size = rhs.m_body_chunk_size;
+            m_keep_alive_timeout = rhs.m_keep_alive_timeout;
+            m_max_requests_per_connection = rhs.m_max_requests_per_connection;
+            m_max_pipelined_requests = rhs.m_max_pipelined_requests;
         }
         return *this;
     }
@@ -122,14 +153,170 @@ public:
         m_timeout = std::move(timeout);
     }
 
+    /// <summary>
+    /// Get the number of acceptors
+    /// </summary>
+    /// <returns>The number of acceptors listening on the port.</returns>
+    size_t acceptors() const
+    {
+        return m_acceptors;
+    }
+
+    /// <summary>
+    /// Set the number of acceptors
+    /// </summary>
+    /// <param name="acceptors">Acceptors bound to the port with SO_REUSEPORT, each running on its own io_service
+    /// and thread that also serves the connections it accepts. 1 keeps a single acceptor on the shared thread pool.
+    /// Only used by the asio listener, and only where SO_REUSEPORT is available.</param>
+    void set_acceptors(size_t acceptors)
+    {
+        m_acceptors = acceptors == 0 ? 1 : acceptors;
+    }
+
+    /// <summary>
+    /// Get whether acceptor threads are pinned to cores
+    /// </summary>
+    /// <returns>true when acceptor i runs on core i.</returns>
+    bool pin_acceptors() const
+    {
+        return m_pin_acceptors;
+    }
+
+    /// <summary>
+    /// Set whether acceptor threads are pinned to cores
+    /// </summary>
+    /// <param name="pin">true to run acceptor i, and the connections it accepted, on core i.</param>
+    void set_pin_acceptors(bool pin)
+    {
+        m_pin_acceptors = pin;
+    }
+
+    /// <summary>
+    /// Get the size of request body reads
+    /// </summary>
+    /// <returns>The most bytes of a request body read from the socket at once.</returns>
+    size_t body_chunk_size() const
+    {
+        return m_body_chunk_size;
+    }
+
+    /// <summary>
+    /// Set the size of request body reads
+    /// </summary>
+    /// <param name="size">The most bytes of a request body read from the socket at once. Larger reads
+    /// mean fewer round trips through the io_service for large uploads. Only used by the asio listener.</param>
+    void set_body_chunk_size(size_t size)
+    {
+        m_body_chunk_size = size == 0 ? 4 * 1024 : size;
+    }
+
+    /// <summary>
+    /// Get the keep-alive timeout
+    /// </summary>
+    /// <returns>How long an idle connection is kept open, 0 keeps it until the client closes it.</returns>
+    utility::seconds keep_alive_timeout() const
+    {
+        return m_keep_alive_timeout;
+    }
+
+    /// <summary>
+    /// Set the keep-alive timeout
+    /// </summary>
+    /// <param name="timeout">How long a connection with no request in progress waits for the next one
+    /// before it is closed, 0 to wait until the client closes it. Only used by the asio listener.</param>
+    void set_keep_alive_timeout(utility::seconds timeout)
+    {
+        m_keep_alive_timeout = std::move(timeout);
+    }
+
+    /// <summary>
+    /// Get the most requests served on one connection
+    /// </summary>
+    /// <returns>The most requests served on one connection, 0 for no limit.</returns>
+    size_t max_requests_per_connection() const
+    {
+        return m_max_requests_per_connection;
+    }
+
+    /// <summary>
+    /// Set the most requests served on one connection
+    /// </summary>
+    /// <param name="requests">The response to the last request carries Connection: close, 0 for no limit.
+    /// Only used by the asio listener.</param>
+    void set_max_requests_per_connection(size_t requests)
+    {
+        m_max_requests_per_connection = requests;
+    }
+
+    /// <summary>
+    /// Get the most pipelined requests in progress on one connection
+    /// </summary>
+    /// <returns>The most requests read ahead of their responses on one connection.</returns>
+    size_t max_pipelined_requests() const
+    {
+        return m_max_pipelined_requests;
+    }
+
+    /// <summary>
+    /// Set the most pipelined requests in progress on one connection
+    /// </summary>
+    /// <param name="requests">Requests read and handled ahead of their responses on one connection. Reading
+    /// pauses at this many until a response is written. 1 handles one request at a time. Only used by the asio listener.</param>
+    void set_max_pipelined_requests(size_t requests)
+    {
+        m_max_pipelined_requests = requests == 0 ? 1 : requests;
+    }
+
 private:
 
     utility::seconds m_timeout;
+    size_t m_acceptors;
+    bool m_pin_acceptors;
+    size_t m_body_chunk_size;
+    utility::seconds m_keep_alive_timeout;
+    size_t m_max_requests_per_connection;
+    size_t m_max_pipelined_requests;
+};
+
+/// <summary>
+/// Connection and request counters of the listeners in this process.
+/// Only the asio listener keeps them, elsewhere they stay 0.
+/// </summary>
+struct http_listener_statistics
+{
+    http_listener_statistics()
+        : open_connections(0), in_flight_requests(0), requests(0), pipelined_requests(0), idle_timeouts(0)
+    {}
+
+    // Connections accepted and not yet closed
+    size_t open_connections;
+    // Requests read whose response is not written yet
+    size_t in_flight_requests;
+    // Requests read since the process started
+    utility::size64_t requests;
+    // Requests read while an earlier request on the same connection still waited for its response
+    utility::size64_t pipelined_requests;
+    // Connections closed by the keep-alive timeout
+    utility::size64_t idle_timeouts;
 };
 
 namespace details
 {
 
+/// <summary>
+/// Counters behind http_listener::statistics(), updated by the server implementation.
+/// </summary>
+struct listener_counters
+{
+    std::atomic<size_t> open_connections;
+    std::atomic<size_t> in_flight_requests;
+    std::atomic<utility::size64_t> requests;
+    std::atomic<utility::size64_t> pipelined_requests;
+    std::atomic<utility::size64_t> idle_timeouts;
+};
+
+_ASYNCRTIMP listener_counters& counters();
+
 /// <summary>
 /// Internal class for pointer to implementation design pattern.
 /// </summary>
@@ -225,6 +412,12 @@ public:
     /// <remarks>Call close() before allowing a listener to be destroyed.</remarks>
     _ASYNCRTIMP ~http_listener();
     
+    /// <summary>
+    /// Gets the connection and request counters of the listeners in this process.
+    /// </summary>
+    /// <returns>A snapshot of the counters.</returns>
+    _ASYNCRTIMP static http_listener_statistics statistics();
+
     /// <summary>
     /// Asychronously open the listener, i.e. start accepting requests.
     /// </summary>
@@ -26,6 +26,8 @@
 #pragma once
 
 #include <pthread.h>
+#include <unistd.h>
+#include <memory>
 #include <vector>
 
 #if defined(__clang__)
@@ -67,18 +69,30 @@ class threadpool
 {
 public:
 
-    threadpool(size_t n)
+    // When pin_threads is set, thread i is bound to CPU (first_cpu + i) modulo the CPU count.
+    threadpool(size_t n, bool pin_threads = false, size_t first_cpu = 0)
       : m_service(n),
         m_work(m_service)
     {
         for (size_t i = 0; i < n; i++)
-            add_thread();
+            add_thread(pin_threads, first_cpu + i);
     }
 
-    static threadpool& shared_instance()
-    {
-        return s_shared;
-    }
+    // Pool running the io_service of the listener, the http client and file streams.
+    static threadpool& shared_instance();
+
+    // Pool running pplx task continuations, kept off the io_service threads so a
+    // continuation that blocks does not stall socket I/O.
+    static threadpool& continuation_instance();
+
+    // Sizes the shared pools. Must be called before either pool is first used,
+    // a count of 0 keeps the default derived from the number of cores.
+    // Returns false when the pools already exist and were left unchanged.
+    static bool initialize_with_threads(size_t io_threads, size_t continuation_threads, bool pin_threads);
+
+    // Defaults used when the pools are not sized explicitly.
+    static size_t default_io_threads();
+    static size_t default_continuation_threads();
 
     ~threadpool()
     {
@@ -105,15 +119,42 @@ public:
 private:
     struct _cancel_thread { };
 
-    static threadpool s_shared;
+    static void create_shared(size_t io_threads, size_t continuation_threads, bool pin_threads);
+
+    static std::unique_ptr<threadpool> s_shared;
+    static std::unique_ptr<threadpool> s_continuations;
 
-    void add_thread()
+    void add_thread(bool pin_thread, size_t cpu)
     {
         pthread_t t;
         auto result = pthread_create(&t, nullptr, &thread_start, this);
         if (result == 0)
+        {
             m_threads.push_back(t);
+#if defined(__linux__) && !defined(ANDROID)
+            if (pin_thread)
+                pin(t, cpu);
+#else
+            (void)pin_thread;
+            (void)cpu;
+#endif
+        }
+    }
+
+#if defined(__linux__) && !defined(ANDROID)
+    static void pin(pthread_t t, size_t cpu)
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        if (cpus <= 0)
+            return;
+
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(static_cast<int>(cpu % static_cast<size_t>(cpus)), &set);
+        // Pinning is an optimization, a thread that cannot be pinned still runs
+        pthread_setaffinity_np(t, sizeof(set), &set);
     }
+#endif
 
     void remove_thread()
     {
@@ -122,7 +122,7 @@ struct crlf_nonascii_searcher_t
                     state = State::none;
                 }
             }
-            else if (c <= '\x1F' && c >= '\x00')
+            else if (c <= '\x1F' && c >= '\x00' && c != '\t') // tabs are allowed around header values
             {
                 ++cur;
                 return std::make_pair(cur, true);
@@ -166,6 +166,10 @@ const size_t ChunkSize = 4 * 1024;
 namespace details
 {
 
+#if defined(SO_REUSEPORT)
+typedef boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT> reuse_port;
+#endif
+
 void hostport_listener::start()
 {
     // resolve the endpoint address
@@ -174,16 +178,93 @@ void hostport_listener::start()
     tcp::resolver::query query(m_host, m_port);
     tcp::endpoint endpoint = *resolver.resolve(query);
 
-    m_acceptor.reset(new tcp::acceptor(service, endpoint));
-    m_acceptor->set_option(tcp::acceptor::reuse_address(true));
+    pplx::scoped_lock<pplx::extensibility::recursive_lock_t> lock(m_connections_lock);
+
+    if (m_shards.empty())
+    {
+#if defined(SO_REUSEPORT)
+        size_t acceptors = m_acceptors;
+#else
+        // Without SO_REUSEPORT only one socket can listen on the port
+        size_t acceptors = 1;
+#endif
+        for (size_t i = 0; i < acceptors; i++)
+        {
+            std::unique_ptr<acceptor_shard> shard(new acceptor_shard());
+            // A single acceptor keeps using the shared pool
+            if (acceptors > 1)
+                shard->m_pool.reset(new crossplat::threadpool(1, m_pin_acceptors, i));
+            m_shards.push_back(std::move(shard));
+        }
+    }
+
+    try
+    {
+        for (auto& shard : m_shards)
+        {
+            // The options must be set before bind for every socket sharing the port
+            shard->m_acceptor.reset(new tcp::acceptor(shard->service()));
+            shard->m_acceptor->open(endpoint.protocol());
+            shard->m_acceptor->set_option(tcp::acceptor::reuse_address(true));
+#if defined(SO_REUSEPORT)
+            if (m_shards.size() > 1)
+                shard->m_acceptor->set_option(reuse_port(true));
+#endif
+            shard->m_acceptor->bind(endpoint);
+            shard->m_acceptor->listen(socket_base::max_connections);
+        }
+    }
+    catch (...)
+    {
+        for (auto& shard : m_shards)
+            shard->m_acceptor.reset();
+        throw;
+    }
+
+    for (auto& shard : m_shards)
+        accept(shard.get());
+}
 
-    auto socket = new ip::tcp::socket(service);
-    m_acceptor->async_accept(*socket, boost::bind(&hostport_listener::on_accept, this, socket, placeholders::error));
+void hostport_listener::accept(acceptor_shard* shard)
+{
+    // The socket is bound to the io_service of the acceptor, so the connection stays on its thread
+    auto socket = new ip::tcp::socket(shard->service());
+    shard->m_acceptor->async_accept(*socket, boost::bind(&hostport_listener::on_accept, this, shard, socket, placeholders::error));
 }
 
 void connection::close()
+{
+    // A connection already finishing closes itself
+    if (!add_ref_if_alive())
+        return;
+
+    m_strand.post([this]()
+    {
+        close_socket();
+        release();
+    });
+}
+
+// Takes a reference unless the last one is already released.
+bool connection::add_ref_if_alive()
+{
+    int refs = m_refs.load();
+    while (refs != 0)
+    {
+        if (m_refs.compare_exchange_weak(refs, refs + 1))
+            return true;
+    }
+    return false;
+}
+
+void connection::close_socket()
 {
     m_close = true;
+    {
+        pplx::scoped_lock<pplx::extensibility::recursive_lock_t> lock(m_responses_lock);
+        boost::system::error_code ec;
+        m_idle_timer.cancel(ec);
+    }
     auto sock = m_socket.get();
     if (sock != nullptr)
     {
@@ -200,14 +281,77 @@ void connection::start_request_response()
 {
     m_read_size = 0; 
     m_read = 0;
-    m_request_buf.consume(m_request_buf.size()); // clear the buffer
-    
+    // Bytes left after the previous request are the start of a pipelined one and are kept
+
+    arm_idle_timer();
+
     // Wait for either double newline or a char which is not in the range [32-127] which suggests SSL handshaking.
     // For the SSL server support this line might need to be changed. Now, this prevents from hanging when SSL client tries to connect.
-    async_read_until(*m_socket, m_request_buf, crlf_nonascii_searcher, boost::bind(&connection::handle_http_line, this, placeholders::error));
+    async_read_until(*m_socket, m_request_buf, crlf_nonascii_searcher, m_strand.wrap(boost::bind(&connection::handle_http_line, this, placeholders::error)));
+}
+
+// Reads the next request once the current one is read, unless the pipeline is full.
+void connection::read_next()
+{
+    if (m_close)
+    {
+        // The read loop ends, the connection closes once the queued responses are written
+        release();
+        return;
+    }
+
+    {
+        pplx::scoped_lock<pplx::extensibility::recursive_lock_t> lock(m_responses_lock);
+        if (m_responses.size() >= m_p_parent->m_max_pipelined_requests)
+        {
+            // Resumed by response_written
+            m_read_paused = true;
+            return;
+        }
+    }
+    start_request_response();
 }
 
-void hostport_listener::on_accept(ip::tcp::socket* socket, const boost::system::error_code& ec)
+void connection::arm_idle_timer()
+{
+    if (m_p_parent->m_keep_alive_timeout <= 0)
+        return;
+
+    pplx::scoped_lock<pplx::extensibility::recursive_lock_t> lock(m_responses_lock);
+    ++m_refs;
+    // Cancels a wait still pending, which then releases its own reference
+    m_idle_timer.expires_from_now(boost::posix_time::seconds(m_p_parent->m_keep_alive_timeout));
+    m_idle_timer.async_wait(m_strand.wrap(boost::bind(&connection::handle_idle_timeout, this, placeholders::error)));
+}
+
+void connection::handle_idle_timeout(const boost::system::error_code& ec)
+{
+    {
+        pplx::scoped_lock<pplx::extensibility::recursive_lock_t> lock(m_responses_lock);
+        // A request that arrived after the timer fired pushed the expiry out, the wait is then stale
+        if (!ec && m_idle_timer.expires_at() <= boost::asio::deadline_timer::traits_type::now())
+        {
+            if (!m_responses.empty())
+            {
+                // Not idle, a request is still being handled
+                ++m_refs;
+                m_idle_timer.expires_from_now(boost::posix_time::seconds(m_p_parent->m_keep_alive_timeout));
+                m_idle_timer.async_wait(m_strand.wrap(boost::bind(&connection::handle_idle_timeout, this, placeholders::error)));
+            }
+            else
+            {
+                // The pending read completes with an error and ends the read loop
+                ++listener::details::counters().idle_timeouts;
+                m_close = true;
+                boost::system::error_code ignored;
+                m_socket->shutdown(tcp::socket::shutdown_both, ignored);
+            }
+        }
+    }
+    release();
+}
+
+void hostport_listener::on_accept(acceptor_shard* shard, ip::tcp::socket* socket, const boost::system::error_code& ec)
 {
     if (ec)
     {
@@ -217,85 +361,185 @@ void hostport_listener::on_accept(ip::tcp::socket* socket, const boost::system::
     {
         {
             pplx::scoped_lock<pplx::extensibility::recursive_lock_t> lock(m_connections_lock);
-            m_connections.insert(new connection(std::unique_ptr<tcp::socket>(std::move(socket)), m_p_server, this));
+            m_connections.insert(new connection(std::unique_ptr<tcp::socket>(std::move(socket)), shard->service(), m_p_server, this));
             m_all_connections_complete.reset();
             
-            if (m_acceptor)
+            if (shard->m_acceptor)
             {
                 // spin off another async accept
-                auto newSocket = new ip::tcp::socket(crossplat::threadpool::shared_instance().service());
-                m_acceptor->async_accept(*newSocket, boost::bind(&hostport_listener::on_accept, this, newSocket, placeholders::error));
+                accept(shard);
             }
         }
     }
 }
 
+// A range of bytes in the request buffer of a connection. The request line and headers are
+// tokenized in place, only the final header names and values are copied into the request.
+struct text_view
+{
+    const char* begin;
+    const char* end;
+
+    text_view() : begin(nullptr), end(nullptr) {}
+    text_view(const char* b, const char* e) : begin(b), end(e) {}
+
+    size_t size() const { return static_cast<size_t>(end - begin); }
+    bool empty() const { return begin == end; }
+    std::string str() const { return std::string(begin, end); }
+
+    bool iequals(const char* other, size_t length) const
+    {
+        if (size() != length)
+            return false;
+        for (size_t i = 0; i < length; i++)
+        {
+            if (std::tolower(static_cast<unsigned char>(begin[i])) != std::tolower(static_cast<unsigned char>(other[i])))
+                return false;
+        }
+        return true;
+    }
+
+    template <size_t N>
+    bool iequals(const char (&other)[N]) const
+    {
+        return iequals(other, N - 1);
+    }
+
+    bool iequals(const utility::string_t& other) const
+    {
+        return iequals(other.data(), other.size());
+    }
+
+    text_view trim() const
+    {
+        const char* b = begin;
+        const char* e = end;
+        while (b != e && (*b == ' ' || *b == '\t'))
+            ++b;
+        while (e != b && (e[-1] == ' ' || e[-1] == '\t'))
+            --e;
+        return text_view(b, e);
+    }
+};
+
+// Returns the next line of [cur, end) without its line break and moves cur past it.
+// A bare LF is accepted as a line break. Returns false when no complete line is left.
+static bool next_line(const char*& cur, const char* end, text_view& line)
+{
+    const char* lf = static_cast<const char*>(std::memchr(cur, '\n', static_cast<size_t>(end - cur)));
+    if (lf == nullptr)
+        return false;
+
+    line = text_view(cur, (lf != cur && lf[-1] == '\r') ? lf - 1 : lf);
+    cur = lf + 1;
+    return true;
+}
+
+// Maps a method token to the shared method constant, so known methods are not allocated.
+static bool canonical_method(const text_view& token, utility::string_t& method)
+{
+    static const utility::string_t* const known[] =
+    {
+        &http::methods::GET, &http::methods::POST, &http::methods::PUT, &http::methods::DEL, &http::methods::HEAD,
+        &http::methods::TRCE, &http::methods::CONNECT, &http::methods::OPTIONS, &http::methods::PATCH
+    };
+
+    for (auto candidate : known)
+    {
+        if (token.iequals(*candidate))
+        {
+            method = *candidate;
+            return true;
+        }
+    }
+    method = token.str();
+    return false;
+}
+
+// Parses a Content-Length value without a stream. Returns false when it is not a number.
+static bool parse_content_length(const text_view& value, size_t& length)
+{
+    if (value.empty() || value.size() > 19)
+        return false;
+
+    size_t result = 0;
+    for (const char* p = value.begin; p != value.end; ++p)
+    {
+        if (*p < '0' || *p > '9')
+            return false;
+        result = result * 10 + static_cast<size_t>(*p - '0');
+    }
+    length = result;
+    return true;
+}
+
 void connection::handle_http_line(const boost::system::error_code& ec)
 {
+    {
+        pplx::scoped_lock<pplx::extensibility::recursive_lock_t> lock(m_responses_lock);
+        boost::system::error_code ignored;
+        m_idle_timer.expires_at(boost::posix_time::pos_infin, ignored);
+    }
+
     m_request = http_request::_create_request(std::unique_ptr<http::details::_http_server_context>(new linux_request_context()));
     if (ec)
     {
         // client closed connection
-        if ((ec == boost::asio::error::eof) || (ec == boost::asio::error::operation_aborted))
+        if ((ec == boost::asio::error::eof) || (ec == boost::asio::error::operation_aborted) || m_close)
         {
-            finish_request_response();
+            m_close = true;
+            release();
         }
         else
         {
-            m_request.reply(status_codes::BadRequest);
-            do_response(true);
+            bad_request();
         }
     }
     else
     {
-        // read http status line
-        std::istream request_stream(&m_request_buf);
-        std::skipws(request_stream);
-
-        std::string http_verb;
-        request_stream >> http_verb;
-
-        if (boost::iequals(http_verb, http::methods::GET))          http_verb = http::methods::GET;
-        else if (boost::iequals(http_verb, http::methods::POST))    http_verb = http::methods::POST;
-        else if (boost::iequals(http_verb, http::methods::PUT))     http_verb = http::methods::PUT;
-        else if (boost::iequals(http_verb, http::methods::DEL))     http_verb = http::methods::DEL;
-        else if (boost::iequals(http_verb, http::methods::HEAD))    http_verb = http::methods::HEAD;
-        else if (boost::iequals(http_verb, http::methods::TRCE))    http_verb = http::methods::TRCE;
-        else if (boost::iequals(http_verb, http::methods::CONNECT)) http_verb = http::methods::CONNECT;
-        else if (boost::iequals(http_verb, http::methods::OPTIONS)) http_verb = http::methods::OPTIONS;
-
-        // Check to see if there is not allowed character on the input
-        if (!web::http::details::validate_method(http_verb))
+        // The read stops after the blank line ending the headers, so the request line and all
+        // headers are in the buffer. They are parsed where they are, the buffer is consumed
+        // once at the end and keeps any body bytes read along with them.
+        const char* const data = buffer_cast<const char*>(m_request_buf.data());
+        const char* cur = data;
+        const char* const end = data + m_request_buf.size();
+
+        // Empty lines before the request line are ignored
+        text_view line;
+        do
         {
-            m_request.reply(status_codes::BadRequest);
-            m_close = true;
-            do_response(true);
-            return;
-        }
+            if (!next_line(cur, end, line))
+                return bad_request();
+        } while (line.empty());
+
+        // method SP request-target SP HTTP-version
+        const char* first_space = static_cast<const char*>(std::memchr(line.begin, ' ', line.size()));
+        const char* last_space = line.end;
+        while (last_space != line.begin && last_space[-1] != ' ')
+            --last_space;
+        if (first_space == nullptr || last_space == line.begin || last_space - 1 <= first_space)
+            return bad_request();
+
+        text_view version(last_space, line.end);
+        text_view target = text_view(first_space + 1, last_space - 1).trim();
+        if (target.empty() || version.size() != sizeof("HTTP/1.1") - 1 || !text_view(version.begin, version.begin + 5).iequals("HTTP/"))
+            return bad_request();
+
+        utility::string_t http_verb;
+        // Check to see if there is not allowed character on the input
+        if (!canonical_method(text_view(line.begin, first_space), http_verb) && !web::http::details::validate_method(http_verb))
+            return bad_request();
 
         m_request.set_method(http_verb);
 
-        std::string http_path_and_version;
-        std::getline(request_stream, http_path_and_version);
-        const size_t VersionPortionSize = sizeof(" HTTP/1.1\r") - 1;
-        
-        // Make sure path and version is long enough to contain the HTTP version
-        if(http_path_and_version.size() < VersionPortionSize + 2)
-        {
-            m_request.reply(status_codes::BadRequest);
-            m_close = true;
-            do_response(true);
-            return;
-        }
-
         // Get the host part of the address. 
         uri_builder builder;
         builder.set_scheme("http");
         builder.set_host(m_p_parent->m_host, true);
         builder.set_port(m_p_parent->m_port);
 
-        // Get the path - remove the version portion and prefix space
-        builder.append_path(http_path_and_version.substr(1, http_path_and_version.size() - VersionPortionSize - 1));
+        // Get the path
+        builder.append_path(target.str());
         try
         {
             m_request.set_request_uri(builder.to_uri());
@@ -305,60 +549,87 @@ void connection::handle_http_line(const boost::system::error_code& ec)
             m_request.reply(status_codes::BadRequest, e.what());
             m_close = true;
             do_response(true);
+            read_next();
             return;
         }
-            
-        // Get the version
-        std::string http_version = http_path_and_version.substr(http_path_and_version.size() - VersionPortionSize + 1, VersionPortionSize - 2);
-        // if HTTP version is 1.0 then disable pipelining
-        if (http_version == "HTTP/1.0")
-        {
-            m_close = true;
-        }
 
-        handle_headers();
+        handle_headers(cur, end, version.iequals("HTTP/1.0"));
     }
 }
 
-void connection::handle_headers()
+void connection::bad_request()
+{
+    m_request.reply(status_codes::BadRequest);
+    m_close = true;
+    do_response(true);
+    read_next();
+}
+
+void connection::handle_headers(const char* cur, const char* const end, bool http10)
 {
-    std::istream request_stream(&m_request_buf);
-    std::string header;
-    while (std::getline(request_stream, header) && header != "\r")
+    const char* const data = buffer_cast<const char*>(m_request_buf.data());
+    bool has_content_length = false;
+
+    text_view line;
+    for (;;)
     {
-        auto colon = header.find(':');
-        if (colon != std::string::npos && colon != 0)
+        if (!next_line(cur, end, line))
         {
-            auto name = header.substr(0, colon);
-            auto value = header.substr(colon + 1, header.length() - (colon + 1)); // also exclude '\r'
-            http::details::trim_whitespace(name);
-            http::details::trim_whitespace(value);
+            // The headers were cut short, by a control character or a non-ASCII byte
+            return bad_request();
+        }
+        if (line.empty())
+            break;
 
-            auto& currentValue = m_request.headers()[name];
-            if (currentValue.empty() || boost::iequals(name, header_names::content_length)) // (content-length is already set)
-            {
-                currentValue = value;
-            }
-            else 
-            {
-                currentValue += U(", ") + value;
-            }
+        const char* colon = static_cast<const char*>(std::memchr(line.begin, ':', line.size()));
+        if (colon == nullptr || colon == line.begin)
+            return bad_request();
+
+        text_view name = text_view(line.begin, colon).trim();
+        text_view value = text_view(colon + 1, line.end).trim();
+
+        if (name.iequals(header_names::content_length))
+        {
+            if (!parse_content_length(value, m_read_size))
+                return bad_request();
+            has_content_length = true;
         }
-        else
+
+        auto& currentValue = m_request.headers()[name.str()];
+        if (currentValue.empty() || name.iequals(header_names::content_length)) // (content-length is already set)
         {
-            m_request.reply(status_codes::BadRequest);
-            m_close = true;
-            do_response(true);
-            return;
+            currentValue.assign(value.begin, value.end);
+        }
+        else 
+        {
+            currentValue += U(", ");
+            currentValue.append(value.begin, value.end);
         }
     }
 
-    m_close = m_chunked = false;
+    // Whatever follows the headers is the start of the body
+    m_request_buf.consume(static_cast<size_t>(cur - data));
+
+    m_chunked = false;
+    m_keep_alive = false;
     utility::string_t name;
-    // check if the client has requested we close the connection
+    // HTTP/1.1 connections stay open unless the client asks to close them,
+    // HTTP/1.0 ones only when the client asks for keep-alive
     if (m_request.headers().match(header_names::connection, name))
     {
-        m_close = boost::iequals(name, U("close"));
+        m_keep_alive = http10 && boost::ifind_first(name, U("keep-alive"));
+        m_close = http10 ? !m_keep_alive : static_cast<bool>(boost::ifind_first(name, U("close")));
+    }
+    else
+    {
+        m_close = http10;
+    }
+
+    ++m_requests;
+    ++listener::details::counters().requests;
+    if (m_p_parent->m_max_requests_per_connection != 0 && m_requests >= m_p_parent->m_max_requests_per_connection)
+    {
+        m_close = true;
     }
 
     if (m_request.headers().match(header_names::transfer_encoding, name))
@@ -369,14 +640,20 @@ void connection::handle_headers()
     Concurrency::streams::producer_consumer_buffer<uint8_t> buf;
     m_request._get_impl()->set_instream(buf.create_istream());
     m_request._get_impl()->set_outstream(buf.create_ostream(), false);
+
+    // The response is queued before the request is handed out, keeping responses in request order.
+    // The listener gets its own handle, m_request moves on to the next request once this body is read.
+    do_response(false);
+    http_request request = m_request;
+
     if (m_chunked)
     {
-        boost::asio::async_read_until(*m_socket, m_request_buf, CRLF, boost::bind(&connection::handle_chunked_header, this, placeholders::error));
-        dispatch_request_to_listener();
+        boost::asio::async_read_until(*m_socket, m_request_buf, CRLF, m_strand.wrap(boost::bind(&connection::handle_chunked_header, this, placeholders::error)));
+        dispatch_request_to_listener(request);
         return;
     }
 
-    if (!m_request.headers().match(header_names::content_length, m_read_size))
+    if (!has_content_length)
     {
         m_read_size = 0;
     }
@@ -384,14 +661,15 @@ void connection::handle_headers()
     if (m_read_size == 0)
     {
         request_data_avail( 0);
-    }
-    else // need to read the sent data
-    {
-        m_read = 0;
-        async_read_until_buffersize(std::min(ChunkSize, m_read_size), boost::bind(&connection::handle_body, this, placeholders::error));
+        dispatch_request_to_listener(request);
+        read_next();
+        return;
     }
 
-    dispatch_request_to_listener();
+    // need to read the sent data
+    m_read = 0;
+    async_read_until_buffersize(std::min(m_p_parent->m_body_chunk_size, m_read_size), boost::bind(&connection::handle_body, this, placeholders::error));
+    dispatch_request_to_listener(request);
 }
 
 void connection::handle_chunked_header(const boost::system::error_code& ec)
@@ -404,13 +682,16 @@ void connection::handle_chunked_header(const boost::system::error_code& ec)
         m_request_buf.consume(CRLF.size());
         m_read += len;
         if (len == 0)
+        {
             request_data_avail(m_read);
+            read_next();
+        }
         else
             async_read_until_buffersize(len + 2, boost::bind(&connection::handle_chunked_body, this, boost::asio::placeholders::error, len));
     }
     else
     {
-        m_request._reply_if_not_already(status_codes::BadRequest);
+        request_body_failed(status_codes::BadRequest);
     }
 }
 
@@ -421,22 +702,26 @@ void connection::handle_chunked_body(const boost::system::error_code& ec, int to
         auto writebuf = m_request._get_impl()->outstream().streambuf();
         writebuf.putn(buffer_cast<const uint8_t *>(m_request_buf.data()), toWrite).then([=](pplx::task<size_t> writeChunkTask) 
         {
-            try 
+            // The read loop continues on the strand, not on the continuation thread
+            m_strand.post([=]()
             {
-                writeChunkTask.get();
-            } catch (...) {
-                m_request._reply_if_not_already(status_codes::InternalError);
-                return;
-            }
-        
-            m_request_buf.consume(2 + toWrite);
-            boost::asio::async_read_until(*m_socket, m_request_buf, CRLF, 
-                    boost::bind(&connection::handle_chunked_header, this, placeholders::error));
+                try 
+                {
+                    writeChunkTask.get();
+                } catch (...) {
+                    request_body_failed(status_codes::InternalError);
+                    return;
+                }
+            
+                m_request_buf.consume(2 + toWrite);
+                boost::asio::async_read_until(*m_socket, m_request_buf, CRLF, 
+                        m_strand.wrap(boost::bind(&connection::handle_chunked_header, this, placeholders::error)));
+            });
         });
     }
     else
     {
-        m_request._reply_if_not_already(status_codes::BadRequest);
+        request_body_failed(status_codes::BadRequest);
     }
 }
 
@@ -445,48 +730,65 @@ void connection::handle_body(const boost::system::error_code& ec)
     // read body
     if (ec)
     {
-        m_request._reply_if_not_already(status_codes::BadRequest);
+        request_body_failed(status_codes::BadRequest);
     }
     else if (m_read < m_read_size)  // there is more to read
     {
         auto writebuf = m_request._get_impl()->outstream().streambuf();
         writebuf.putn(boost::asio::buffer_cast<const uint8_t*>(m_request_buf.data()), std::min(m_request_buf.size(), m_read_size - m_read)).then([=](pplx::task<size_t> writtenSizeTask) 
         {
-            size_t writtenSize = 0;
-            try 
+            // The read loop continues on the strand, not on the continuation thread
+            m_strand.post([=]()
             {
-                writtenSize = writtenSizeTask.get();
-            } catch (...) {
-                m_request._reply_if_not_already(status_codes::InternalError);
-                return;
-            }
-            m_read += writtenSize;
-            m_request_buf.consume(writtenSize);
-            async_read_until_buffersize(std::min(ChunkSize, m_read_size - m_read), boost::bind(&connection::handle_body, this, placeholders::error));
+                size_t writtenSize = 0;
+                try 
+                {
+                    writtenSize = writtenSizeTask.get();
+                } catch (...) {
+                    request_body_failed(status_codes::InternalError);
+                    return;
+                }
+                m_read += writtenSize;
+                m_request_buf.consume(writtenSize);
+                async_read_until_buffersize(std::min(m_p_parent->m_body_chunk_size, m_read_size - m_read), boost::bind(&connection::handle_body, this, placeholders::error));
+            });
         });
     }
     else  // have read request body
     {
         request_data_avail(m_read);
+        read_next();
     }
 }
 
+// The rest of the connection cannot be framed once a body fails, it is closed after the queued responses.
+void connection::request_body_failed(status_code status)
+{
+    m_request._reply_if_not_already(status);
+    m_request._get_impl()->_complete(m_read, std::make_exception_ptr(http_exception("error reading request body")));
+    m_close = true;
+    read_next();
+}
+
 template <typename ReadHandler>
 void connection::async_read_until_buffersize(size_t size, ReadHandler handler)
 {
     auto bufsize = m_request_buf.size();
     if (bufsize >= size)
-        boost::asio::async_read(*m_socket, m_request_buf, transfer_at_least(0), handler);
+        boost::asio::async_read(*m_socket, m_request_buf, transfer_at_least(0), m_strand.wrap(handler));
     else
-        boost::asio::async_read(*m_socket, m_request_buf, transfer_at_least(size - bufsize), handler);
+        boost::asio::async_read(*m_socket, m_request_buf, transfer_at_least(size - bufsize), m_strand.wrap(handler));
 }
 
-void connection::dispatch_request_to_listener()
+void connection::dispatch_request_to_listener(http_request request)
 {
+    // the body may finish and the connection close while the listener still runs
+    ++m_refs;
+
     // locate the listener:
     web::http::experimental::listener::details::http_listener_impl* pListener = nullptr;
     {
-        auto path_segments = uri::split_path(uri::decode(m_request.relative_uri().path()));
+        auto path_segments = uri::split_path(uri::decode(request.relative_uri().path()));
         for (auto i = static_cast<long>(path_segments.size()); i >= 0; --i)
         {
             std::string path = "";
@@ -508,13 +810,11 @@ void connection::dispatch_request_to_listener()
 
     if (pListener == nullptr)
     {
-        m_request.reply(status_codes::NotFound);
-        do_response(false);
+        request.reply(status_codes::NotFound);
     }
     else
     {
-        m_request._set_listener_path(pListener->uri().path());
-        do_response(false);
+        request._set_listener_path(pListener->uri().path());
         
         // Look up the lock for the http_listener.
         pplx::extensibility::reader_writer_lock_t *pListenerLock;
@@ -524,7 +824,8 @@ void connection::dispatch_request_to_listener()
             // It is possible the listener could have unregistered.
             if(m_p_server->m_registered_listeners.find(pListener) == m_p_server->m_registered_listeners.end())
             {
-                m_request.reply(status_codes::NotFound);
+                request.reply(status_codes::NotFound);
+                release();
                 return;
             }
             pListenerLock = m_p_server->m_registered_listeners[pListener].get();
@@ -536,22 +837,22 @@ void connection::dispatch_request_to_listener()
 
         try
         {
-            pListener->handle_request(m_request);
+            pListener->handle_request(request);
             pListenerLock->unlock();
         } 
         catch(const std::exception &e)
         {
             pListenerLock->unlock();
-            m_request._reply_if_not_already(status_codes::InternalError);
+            request._reply_if_not_already(status_codes::InternalError);
         }
         catch(...)
         {
             pListenerLock->unlock();
-            m_request._reply_if_not_already(status_codes::InternalError);
+            request._reply_if_not_already(status_codes::InternalError);
         }
     }
 
-    if (--m_refs == 0) delete this;
+    release();
 }
 
 void connection::request_data_avail(size_t size)
@@ -560,10 +861,26 @@ void connection::request_data_avail(size_t size)
     m_request._get_impl()->_complete(size);
 }
 
+// Queues a slot for the response of m_request, responses are written in the order their slots were queued.
 void connection::do_response(bool bad_request)
 {
     ++m_refs;
-    pplx::task<http_response> response_task = m_request.get_response();
+    ++listener::details::counters().in_flight_requests;
+
+    auto pending = std::make_shared<pending_response>();
+    pending->close = m_close;
+    pending->keep_alive = m_keep_alive;
+    {
+        pplx::scoped_lock<pplx::extensibility::recursive_lock_t> lock(m_responses_lock);
+        if (!m_responses.empty())
+        {
+            ++listener::details::counters().pipelined_requests;
+        }
+        m_responses.push_back(pending);
+    }
+
+    http_request request = m_request;
+    pplx::task<http_response> response_task = request.get_response();
 
     response_task.then([=](pplx::task<http::http_response> r_task)
     {
@@ -582,21 +899,80 @@ void connection::do_response(bool bad_request)
         }
         
         // before sending response, the full incoming message need to be processed.
+        // The queued response holds a reference, so the connection outlives the post to its strand.
         if (bad_request)
         {
-            async_process_response(response);
+            m_strand.post([=]() { response_ready(pending, response); });
         }
         else
         {
-            m_request.content_ready().then([=](pplx::task<http::http_request>) 
+            request.content_ready().then([=](pplx::task<http::http_request>) 
             {
-                async_process_response(response);
+                m_strand.post([=]() { response_ready(pending, response); });
             });
         }
     });
 }
 
-void connection::async_process_response(http_response response)
+void connection::response_ready(const std::shared_ptr<pending_response>& pending, http_response response)
+{
+    {
+        pplx::scoped_lock<pplx::extensibility::recursive_lock_t> lock(m_responses_lock);
+        pending->response = response;
+        pending->ready = true;
+    }
+    write_next();
+}
+
+// Starts writing the oldest response if it is ready and nothing is being written.
+// Once a closing response is written the ready responses are failed instead, in order.
+void connection::write_next()
+{
+    std::shared_ptr<pending_response> next;
+    std::vector<std::shared_ptr<pending_response>> discarded;
+    {
+        pplx::scoped_lock<pplx::extensibility::recursive_lock_t> lock(m_responses_lock);
+        if (m_discard_responses)
+        {
+            while (!m_responses.empty() && m_responses.front()->ready)
+            {
+                discarded.push_back(m_responses.front());
+                m_responses.pop_front();
+            }
+        }
+        else
+        {
+            if (m_writing || m_responses.empty() || !m_responses.front()->ready)
+                return;
+
+            m_writing = true;
+            next = m_responses.front();
+        }
+    }
+
+    if (next)
+        async_process_response(next->response, next->close, next->keep_alive);
+    else
+        discard_responses(std::move(discarded));
+}
+
+// Fails responses that cannot be written any more and drops their references.
+void connection::discard_responses(std::vector<std::shared_ptr<pending_response>> discarded)
+{
+    for (auto& pending : discarded)
+    {
+        auto * context = static_cast<linux_request_context*>(pending->response._get_server_context());
+        if (context != nullptr)
+        {
+            context->m_response_completed.set_exception(std::make_exception_ptr(http_exception("connection closed before the response was written")));
+        }
+        --listener::details::counters().in_flight_requests;
+        // Each response holds its own reference, the connection is gone only after the last one
+        release();
+    }
+}
+
+void connection::async_process_response(http_response response, bool close, bool keep_alive)
 {
     m_response_buf.consume(m_response_buf.size()); // clear the buffer
     std::ostream os(&m_response_buf);
@@ -605,17 +981,17 @@ void connection::async_process_response(http_response response)
         << response.reason_phrase()
         << CRLF;
 
-    m_chunked = false;
+    m_response_chunked = false;
     m_write = m_write_size = 0;
 
     std::string transferencoding;
     if (response.headers().match(header_names::transfer_encoding, transferencoding) && transferencoding == "chunked")
     {
-        m_chunked  = true;
+        m_response_chunked  = true;
     }
     if (!response.headers().match(header_names::content_length, m_write_size) && response.body())
     {
-        m_chunked = true;
+        m_response_chunked = true;
         response.headers()[header_names::transfer_encoding] = U("chunked");
     }
     if (!response.body())
@@ -623,21 +999,29 @@ void connection::async_process_response(http_response response)
         response.headers().add(header_names::content_length,0);
     }
 
+    // check if the responder has requested we close the connection, and tell the client what happens to it
+    m_response_close = close;
+    utility::string_t connection_header;
+    if (response.headers().match(header_names::connection, connection_header) && boost::iequals(connection_header, U("close")))
+    {
+        m_response_close = true;
+    }
+    if (m_response_close)
+    {
+        response.headers()[header_names::connection] = U("close");
+    }
+    else if (keep_alive)
+    {
+        response.headers()[header_names::connection] = U("keep-alive");
+    }
+
     for(const auto & header : response.headers())
     {
-        // check if the responder has requested we close the connection
-        if (boost::iequals(header.first, U("connection"))) 
-        {
-            if (boost::iequals(header.second, U("close")))
-            {
-                m_close = true;
-            }
-        }
         os << header.first << ": " << header.second << CRLF;
     }
     os << CRLF;
 
-    boost::asio::async_write(*m_socket, m_response_buf, boost::bind(&connection::handle_headers_written, this, response, placeholders::error));
+    boost::asio::async_write(*m_socket, m_response_buf, m_strand.wrap(boost::bind(&connection::handle_headers_written, this, response, placeholders::error)));
 }
 
 void connection::cancel_sending_response_with_error(http_response response, std::exception_ptr eptr)
@@ -646,7 +1030,8 @@ void connection::cancel_sending_response_with_error(http_response response, std:
     context->m_response_completed.set_exception(eptr);
     
     // always terminate the connection since error happens
-    finish_request_response();
+    m_response_close = true;
+    response_written();
 }
 
 void connection::handle_write_chunked_response(http_response response, const boost::system::error_code& ec)
@@ -661,22 +1046,26 @@ void connection::handle_write_chunked_response(http_response response, const boo
 
     readbuf.getn(buffer_cast<uint8_t *>(membuf) + http::details::chunked_encoding::data_offset, ChunkSize).then([=](pplx::task<size_t> actualSizeTask) 
     {		
-        size_t actualSize = 0;
-        try 
-        {
-            actualSize = actualSizeTask.get();
-        } catch (...) {
-            return cancel_sending_response_with_error(response, std::current_exception());
-        }
-        size_t offset = http::details::chunked_encoding::add_chunked_delimiters(buffer_cast<uint8_t *>(membuf), ChunkSize+http::details::chunked_encoding::additional_encoding_space, actualSize);
-        m_response_buf.commit(actualSize + http::details::chunked_encoding::additional_encoding_space);
-        m_response_buf.consume(offset);
-        boost::asio::async_write(
-                *m_socket, 
-                m_response_buf,
-                boost::bind(actualSize == 0 ? &connection::handle_response_written : &connection::handle_write_chunked_response, 
-                this, 
-                response, placeholders::error));
+        // The write continues on the strand, not on the continuation thread
+        m_strand.post([=]()
+        {
+            size_t actualSize = 0;
+            try 
+            {
+                actualSize = actualSizeTask.get();
+            } catch (...) {
+                return cancel_sending_response_with_error(response, std::current_exception());
+            }
+            size_t offset = http::details::chunked_encoding::add_chunked_delimiters(buffer_cast<uint8_t *>(membuf), ChunkSize+http::details::chunked_encoding::additional_encoding_space, actualSize);
+            m_response_buf.commit(actualSize + http::details::chunked_encoding::additional_encoding_space);
+            m_response_buf.consume(offset);
+            boost::asio::async_write(
+                    *m_socket, 
+                    m_response_buf,
+                    m_strand.wrap(boost::bind(actualSize == 0 ? &connection::handle_response_written : &connection::handle_write_chunked_response, 
+                    this, 
+                    response, placeholders::error)));
+        });
     });
 }
 
@@ -691,16 +1080,20 @@ void connection::handle_write_large_response(http_response response, const boost
     size_t readBytes = std::min(ChunkSize, m_write_size - m_write);
     readbuf.getn(buffer_cast<uint8_t *>(m_response_buf.prepare(readBytes)), readBytes).then([=](pplx::task<size_t> actualSizeTask) 
     {
-        size_t actualSize = 0;
-        try 
+        // The write continues on the strand, not on the continuation thread
+        m_strand.post([=]()
         {
-            actualSize = actualSizeTask.get();
-        } catch (...) {
-            return cancel_sending_response_with_error(response, std::current_exception());
-        }
-        m_write += actualSize;
-        m_response_buf.commit(actualSize);
-        boost::asio::async_write(*m_socket, m_response_buf, boost::bind(&connection::handle_write_large_response, this, response, placeholders::error));
+            size_t actualSize = 0;
+            try 
+            {
+                actualSize = actualSizeTask.get();
+            } catch (...) {
+                return cancel_sending_response_with_error(response, std::current_exception());
+            }
+            m_write += actualSize;
+            m_response_buf.commit(actualSize);
+            boost::asio::async_write(*m_socket, m_response_buf, m_strand.wrap(boost::bind(&connection::handle_write_large_response, this, response, placeholders::error)));
+        });
     });
 }
 
@@ -712,7 +1105,7 @@ void connection::handle_headers_written(http_response response, const boost::sys
     }
     else
     {
-        if (m_chunked)
+        if (m_response_chunked)
             handle_write_chunked_response(response, ec);
         else
             handle_write_large_response(response, ec);
@@ -729,15 +1122,56 @@ void connection::handle_response_written(http_response response, const boost::sy
     else
     {
         context->m_response_completed.set();
-        if (!m_close)
+        response_written();
+    }
+}
+
+// Drops the written response from the queue, then closes the connection or moves on to the next response.
+void connection::response_written()
+{
+    bool resume_read = false;
+    bool release_read = false;
+    {
+        pplx::scoped_lock<pplx::extensibility::recursive_lock_t> lock(m_responses_lock);
+        m_responses.pop_front();
+        m_writing = false;
+
+        if (m_read_paused)
         {
-            start_request_response();
+            m_read_paused = false;
+            if (m_response_close || m_close)
+                release_read = true;
+            else
+                resume_read = true;
         }
-        else
+        if (m_response_close)
         {
-            finish_request_response();
+            m_close = true;
+            m_discard_responses = true;
         }
     }
+    --listener::details::counters().in_flight_requests;
+
+    if (m_response_close)
+    {
+        // fails the pending read, the rest of the queue is failed as the responses become ready
+        boost::system::error_code ignored;
+        m_socket->shutdown(tcp::socket::shutdown_both, ignored);
+    }
+    else if (resume_read)
+    {
+        start_request_response();
+    }
+    write_next();
+
+    if (release_read)
+        release();
+    release();
+}
+
+void connection::release()
+{
+    if (--m_refs == 0) finish_request_response();
 }
 
 void connection::finish_request_response()
@@ -750,8 +1184,10 @@ void connection::finish_request_response()
             m_p_parent->m_all_connections_complete.set();
     }
 
-    close();
-    if (--m_refs == 0) delete this;
+    // No operation is pending once the last reference is gone, the socket is closed right here
+    close_socket();
+    --listener::details::counters().open_connections;
+    delete this;
 }
 
 void hostport_listener::stop()
@@ -759,7 +1195,10 @@ void hostport_listener::stop()
     // halt existing connections
     {
         pplx::scoped_lock<pplx::extensibility::recursive_lock_t> lock(m_connections_lock);
-        m_acceptor.reset();
+        for (auto& shard : m_shards)
+        {
+            shard->m_acceptor.reset();
+        }
         for(auto connection : m_connections)
         {
             connection->close();
@@ -859,7 +1298,7 @@ pplx::task<void> http_linux_server::register_listener(details::http_listener_imp
         if (found_hostport_listener == m_listeners.end())
         {
             found_hostport_listener = m_listeners.insert(
-                std::make_pair(hostport, utility::details::make_unique<details::hostport_listener>(this, hostport))).first;
+                std::make_pair(hostport, utility::details::make_unique<details::hostport_listener>(this, hostport, listener->configuration()))).first;
 
             if (m_started)
                 found_hostport_listener->second->start();
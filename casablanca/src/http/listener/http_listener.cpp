@@ -34,6 +34,30 @@ namespace experimental {
 namespace listener
 {
 
+namespace details
+{
+
+listener_counters& counters()
+{
+    // Zero initialized before any listener can touch it
+    static listener_counters s_counters;
+    return s_counters;
+}
+
+}
+
+http_listener_statistics http_listener::statistics()
+{
+    auto& counters = details::counters();
+    http_listener_statistics statistics;
+    statistics.open_connections = counters.open_connections.load();
+    statistics.in_flight_requests = counters.in_flight_requests.load();
+    statistics.requests = counters.requests.load();
+    statistics.pipelined_requests = counters.pipelined_requests.load();
+    statistics.idle_timeouts = counters.idle_timeouts.load();
+    return statistics;
+}
+
 // Helper function to check URI components.
 static void check_listener_uri(const http::uri &address)
 {
@@ -54,7 +54,7 @@ namespace details {
 
     _PPLXIMP void linux_scheduler::schedule( TaskProc_t proc, void* param)
     {
-        crossplat::threadpool::shared_instance().schedule(boost::bind(proc, param));
+        crossplat::threadpool::continuation_instance().schedule(boost::bind(proc, param));
     }
 
 } // namespace details
@@ -18,10 +18,65 @@
 **/
 #include "stdafx.h"
 
+#include <algorithm>
+#include <mutex>
+#include <thread>
+
 namespace crossplat
 {
-// initialize the static shared threadpool 
-threadpool threadpool::s_shared(40);
+// The shared pools are created on first use, or by initialize_with_threads
+std::unique_ptr<threadpool> threadpool::s_shared;
+std::unique_ptr<threadpool> threadpool::s_continuations;
+
+static std::once_flag s_shared_created;
+
+size_t threadpool::default_io_threads()
+{
+    // One thread per core keeps every core busy with socket I/O without
+    // all of them contending on a single io_service queue for long
+    return (std::max)(2u, std::thread::hardware_concurrency());
+}
+
+size_t threadpool::default_continuation_threads()
+{
+    // Continuations may block on a task, so there are more of them than cores
+    return (std::max)(4u, 2 * std::thread::hardware_concurrency());
+}
+
+void threadpool::create_shared(size_t io_threads, size_t continuation_threads, bool pin_threads)
+{
+    if (io_threads == 0)
+        io_threads = default_io_threads();
+    if (continuation_threads == 0)
+        continuation_threads = default_continuation_threads();
+
+    // Continuation threads are pinned after the I/O threads, wrapping around the cores
+    s_shared.reset(new threadpool(io_threads, pin_threads, 0));
+    s_continuations.reset(new threadpool(continuation_threads, pin_threads, io_threads));
+}
+
+bool threadpool::initialize_with_threads(size_t io_threads, size_t continuation_threads, bool pin_threads)
+{
+    bool created = false;
+    std::call_once(s_shared_created, [&]()
+    {
+        create_shared(io_threads, continuation_threads, pin_threads);
+        created = true;
+    });
+    return created;
+}
+
+threadpool& threadpool::shared_instance()
+{
+    std::call_once(s_shared_created, []() { create_shared(0, 0, false); });
+    return *s_shared;
+}
+
+threadpool& threadpool::continuation_instance()
+{
+    std::call_once(s_shared_created, []() { create_shared(0, 0, false); });
+    return *s_continuations;
+}
 
 #if defined(ANDROID)
 // This pointer will be 0-initialized by default (at load time).
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// <summary>
+/// Fixed set of threads for work that blocks, such as MySQL calls and synchronous storage requests.
+/// The queue in front of the threads is bounded, so an overloaded server refuses work
+/// instead of parking the threads that serve the network.
+/// </summary>
+class BlockingExecutor
+{
+public:
+	/// <summary>
+	/// Starts the threads.
+	/// </summary>
+	/// <param name="threads">Threads running work, at least one is started.</param>
+	/// <param name="queue_size">Work items waiting for a thread before tryPost refuses more.</param>
+	BlockingExecutor(size_t threads, size_t queue_size) : m_state(std::make_shared<State>(queue_size))
+	{
+		if (threads == 0)
+			threads = 1;
+
+		m_threads.reserve(threads);
+		for (size_t i = 0; i < threads; ++i)
+		{
+			m_threads.push_back(std::thread(&BlockingExecutor::run, m_state));
+		}
+	}
+
+	/// <summary>
+	/// Runs the queued work, then stops the threads.
+	/// The executor may be destroyed by work running on one of its own threads, when that work
+	/// releases the last owner. That thread is detached instead of joined, it holds the shared
+	/// state and finishes the queue on its own.
+	/// </summary>
+	~BlockingExecutor()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_state->mutex);
+			m_state->stopping = true;
+		}
+		m_state->ready.notify_all();
+
+		for (auto &thread : m_threads)
+		{
+			if (thread.get_id() == std::this_thread::get_id())
+				thread.detach();
+			else
+				thread.join();
+		}
+	}
+
+	/// <summary>
+	/// Queues work for the next free thread.
+	/// </summary>
+	/// <returns>false when the queue is full or the executor is stopping, the work is not run.</returns>
+	bool tryPost(std::function<void()> work)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_state->mutex);
+			if (m_state->stopping || m_state->queue.size() >= m_state->queue_size)
+				return false;
+
+			m_state->queue.push_back(std::move(work));
+		}
+		m_state->ready.notify_one();
+		return true;
+	}
+
+	/// <summary>
+	/// Work items waiting for a thread.
+	/// </summary>
+	size_t pending()
+	{
+		std::lock_guard<std::mutex> lock(m_state->mutex);
+		return m_state->queue.size();
+	}
+
+private:
+	BlockingExecutor(const BlockingExecutor&);
+	BlockingExecutor &operator=(const BlockingExecutor&);
+
+	/// <summary>
+	/// Queue shared by the executor and its threads, it outlives an executor destroyed from one of them.
+	/// </summary>
+	struct State
+	{
+		explicit State(size_t queue_size) : queue_size(queue_size), stopping(false)
+		{
+		}
+
+		const size_t queue_size;
+		bool stopping;
+		std::mutex mutex;
+		std::condition_variable ready;
+		std::deque<std::function<void()>> queue;
+	};
+
+	static void run(std::shared_ptr<State> state)
+	{
+		for (;;)
+		{
+			std::function<void()> work;
+			{
+				std::unique_lock<std::mutex> lock(state->mutex);
+				state->ready.wait(lock, [&state] { return state->stopping || !state->queue.empty(); });
+
+				if (state->queue.empty())
+					return;
+
+				work = std::move(state->queue.front());
+				state->queue.pop_front();
+			}
+
+			//Work reports its own failures, one that escapes must not take the thread down
+			try
+			{
+				work();
+			}
+			catch (...)
+			{
+			}
+		}
+	}
+
+	std::shared_ptr<State> m_state;
+	std::vector<std::thread> m_threads;
+};
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <limits>
 #include <memory>
 #include <mutex>
 
@@ -23,6 +24,41 @@ public:
 	static const std::string bolt_host;
 	static const std::string bolt_port;
 
+	static const std::string auth_pool_min_size;
+	static const std::string auth_pool_max_size;
+	static const std::string auth_pool_wait_timeout;
+	static const std::string auth_pool_idle_timeout;
+
+	static const std::string data_pool_database;
+	static const std::string data_pool_min_size;
+	static const std::string data_pool_max_size;
+	static const std::string data_pool_wait_timeout;
+	static const std::string data_pool_idle_timeout;
+
+	static const std::string permission_cache_refresh;
+	static const std::string signing_key_cache_ttl;
+
+	static const std::string whole_consistency;
+
+	static const std::string max_page_size;
+
+	static const std::string blocking_threads;
+	static const std::string blocking_queue_size;
+
+	static const std::string io_threads;
+	static const std::string continuation_threads;
+	static const std::string pin_threads;
+	static const std::string listener_acceptors;
+	static const std::string body_chunk_size;
+	static const std::string keep_alive_timeout;
+	static const std::string max_requests_per_connection;
+	static const std::string max_pipelined_requests;
+
+	static const std::string log_file;
+	static const std::string log_level;
+	static const std::string log_max_size;
+	static const std::string log_max_files;
+
 
 	virtual ~Config() {}
 	static Config& getInstance();
@@ -31,6 +67,19 @@ public:
 	std::string Config::getStdConfigOption(const std::string con_name);
 	utility::string_t getServerHostWithPort();
 
+	/// <summary>
+	/// Reads a non-negative whole number option. When the config file was not read the compiled-in
+	/// default is returned. When the value is not a number or lies outside minimum..maximum
+	/// a warning is logged and the default is returned.
+	/// </summary>
+	unsigned long getNumberOption(const std::string con_name, unsigned long minimum = 0,
+		unsigned long maximum = (std::numeric_limits<unsigned long>::max)());
+
+	/// <summary>
+	/// False when the config file could not be parsed or holds an invalid value
+	/// </summary>
+	bool isValid() const;
+
 private:
 	/// <summary>
 	/// Initializes a new instance of the <see cref="Config"/> class.
@@ -38,6 +87,11 @@ private:
 	/// </summary>
 	Config(void);
 
+	/// <summary>
+	/// The default of an option as declared in the options description.
+	/// </summary>
+	std::string getDefaultOption(const std::string con_name);
+
 	Config(const Config& src);
 	Config &operator=(const Config& rhs);
 	static std::unique_ptr<Config> m_instance;
@@ -55,6 +109,8 @@ private:
 
 	std::string m_config_file = "c:/bolt_config.cfg";
 
+	bool m_valid = true;
+
 	/// <summary>
 	/// A Group of options that will be
 	/// read from config file
@@ -0,0 +1,424 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <fcntl.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <io.h>
+#include <share.h>
+#else
+#include <cerrno>
+#include <unistd.h>
+#endif
+
+//The writer lives in boltauth, every module that logs shares its instance
+#ifdef _WIN32
+#ifdef BOLTAUTH_DLL
+#define BOLTLOG_API __declspec( dllexport )
+#else
+#define BOLTLOG_API __declspec( dllimport )
+#endif
+#else
+#define BOLTLOG_API
+#endif
+
+/// <summary>
+/// Process-wide writer behind BoltLog.
+/// Threads that log only claim a slot in a lock-free ring and move their line into it,
+/// a background thread formats the timestamps and appends whole batches to the file with one write.
+/// When the ring is full lines are dropped and counted rather than blocking the caller.
+/// </summary>
+class LogWriter
+{
+public:
+	enum level
+	{
+		error = 0,
+		warning = 1,
+		info = 2
+	};
+
+	/// <summary>
+	/// Where and what to log, see configure.
+	/// </summary>
+	struct Options
+	{
+		// Log file, empty for the platform default
+		std::string path;
+		// Lines above this level are discarded before they are formatted
+		level max_level = info;
+		// The file is rotated once it would grow past this many bytes, 0 never rotates
+		size_t max_size = 10 * 1024 * 1024;
+		// Rotated files kept next to the log as path.1 ... path.N
+		size_t max_files = 5;
+	};
+
+	/// <summary>
+	/// The one writer of the process, defined in boltauth so boltserver and the storage modules share it.
+	/// </summary>
+	BOLTLOG_API static LogWriter &getInstance();
+
+	/// <summary>
+	/// Reads a level name: error, warning or info.
+	/// </summary>
+	static level parseLevel(const std::string &name)
+	{
+		if (name == "error")
+			return error;
+		if (name == "warning")
+			return warning;
+		return info;
+	}
+
+	static std::string defaultPath()
+	{
+		const char *path = std::getenv("BOLT_LOG_FILE");
+		if (path != nullptr && *path != '\0')
+			return path;
+#ifdef _WIN32
+		return "c:/bolt_log.log";
+#else
+		return "bolt_log.log";
+#endif
+	}
+
+	/// <summary>
+	/// Applies new options, the file is reopened before the next batch is written.
+	/// </summary>
+	void configure(const Options &options)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_options = options;
+		if (m_options.path.empty())
+			m_options.path = defaultPath();
+		m_max_level.store(static_cast<int>(options.max_level), std::memory_order_relaxed);
+		m_reopen = true;
+	}
+
+	bool enabled(level l) const
+	{
+		return static_cast<int>(l) <= m_max_level.load(std::memory_order_relaxed);
+	}
+
+	/// <summary>
+	/// Queues a line, without the trailing newline. Never blocks.
+	/// </summary>
+	void push(level l, std::string text)
+	{
+		auto now = std::chrono::system_clock::now();
+
+		Slot *slot;
+		size_t pos = m_enqueue.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			slot = &m_slots[pos & (capacity - 1)];
+			size_t sequence = slot->sequence.load(std::memory_order_acquire);
+			auto diff = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(pos);
+			if (diff == 0)
+			{
+				if (m_enqueue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (diff < 0)
+			{
+				//The writer is behind by a whole ring
+				m_dropped.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+			else
+			{
+				pos = m_enqueue.load(std::memory_order_relaxed);
+			}
+		}
+
+		slot->time = now;
+		slot->line_level = l;
+		slot->text = std::move(text);
+		slot->sequence.store(pos + 1, std::memory_order_release);
+
+		//A wake-up lost to the race with the writer going to sleep costs at most one poll interval
+		if (m_sleeping.load(std::memory_order_acquire))
+			m_wake.notify_one();
+	}
+
+	/// <summary>
+	/// Lines dropped because the ring was full.
+	/// </summary>
+	size_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+	~LogWriter()
+	{
+		m_stopping.store(true, std::memory_order_release);
+		m_wake.notify_one();
+		if (m_thread.joinable())
+			m_thread.join();
+		closeFile();
+	}
+
+private:
+	static const size_t capacity = 8192;
+	// Lines moved into one write at most, bounds the batch buffer
+	static const size_t batch_lines = 1024;
+
+	struct Slot
+	{
+		std::atomic<size_t> sequence;
+		std::chrono::system_clock::time_point time;
+		level line_level;
+		std::string text;
+	};
+
+	LogWriter()
+		: m_slots(new Slot[capacity]), m_enqueue(0), m_dequeue(0), m_dropped(0), m_reported_dropped(0),
+		m_max_level(static_cast<int>(info)), m_stopping(false), m_sleeping(false), m_reopen(true),
+		m_fd(-1), m_size(0), m_cached_second(-1)
+	{
+		for (size_t i = 0; i < capacity; ++i)
+		{
+			m_slots[i].sequence.store(i, std::memory_order_relaxed);
+		}
+		m_options.path = defaultPath();
+		m_thread = std::thread(&LogWriter::run, this);
+	}
+
+	LogWriter(const LogWriter&);
+	LogWriter &operator=(const LogWriter&);
+
+	void run()
+	{
+		std::string batch;
+		for (;;)
+		{
+			bool stopping = m_stopping.load(std::memory_order_acquire);
+
+			size_t lines = drain(batch);
+			if (!batch.empty())
+			{
+				writeBatch(batch);
+				batch.clear();
+			}
+
+			if (lines == 0)
+			{
+				if (stopping)
+					return;
+				sleep();
+			}
+		}
+	}
+
+	/// <summary>
+	/// Moves up to batch_lines queued lines into batch, formatted.
+	/// </summary>
+	size_t drain(std::string &batch)
+	{
+		size_t lines = 0;
+		for (; lines < batch_lines; ++lines)
+		{
+			Slot &slot = m_slots[m_dequeue & (capacity - 1)];
+			if (slot.sequence.load(std::memory_order_acquire) != m_dequeue + 1)
+				break;
+
+			format(slot, batch);
+			slot.text.clear();
+			slot.sequence.store(m_dequeue + capacity, std::memory_order_release);
+			++m_dequeue;
+		}
+
+		size_t dropped = m_dropped.load(std::memory_order_relaxed);
+		if (dropped != m_reported_dropped)
+		{
+			Slot note;
+			note.time = std::chrono::system_clock::now();
+			note.line_level = warning;
+			note.text = std::to_string(dropped - m_reported_dropped) + " log lines dropped, the log queue was full";
+			format(note, batch);
+			m_reported_dropped = dropped;
+		}
+		return lines;
+	}
+
+	void sleep()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_sleeping.store(true, std::memory_order_seq_cst);
+		Slot &next = m_slots[m_dequeue & (capacity - 1)];
+		if (next.sequence.load(std::memory_order_acquire) != m_dequeue + 1 && !m_stopping.load(std::memory_order_acquire))
+		{
+			m_wake.wait_for(lock, std::chrono::milliseconds(50));
+		}
+		m_sleeping.store(false, std::memory_order_relaxed);
+	}
+
+	/// <summary>
+	/// Appends "[ date ] [LEVEL]: text" to out. The date is only formatted again when the second changes.
+	/// </summary>
+	void format(const Slot &slot, std::string &out)
+	{
+		time_t second = std::chrono::system_clock::to_time_t(slot.time);
+		if (second != m_cached_second)
+		{
+			struct tm tstruct;
+#ifdef _WIN32
+			localtime_s(&tstruct, &second);
+#else
+			localtime_r(&second, &tstruct);
+#endif
+			char buf[80];
+			strftime(buf, sizeof(buf), "%Y-%m-%d.%X", &tstruct);
+			m_cached_prefix = std::string("[ ") + buf + " ] ";
+			m_cached_second = second;
+		}
+
+		out += m_cached_prefix;
+		switch (slot.line_level)
+		{
+		case error:
+			out += "[ERROR]: ";
+			break;
+		case warning:
+			out += "[WARNING]: ";
+			break;
+		default:
+			out += "[INFO]: ";
+			break;
+		}
+
+		size_t length = slot.text.size();
+		while (length > 0 && (slot.text[length - 1] == '\n' || slot.text[length - 1] == '\r'))
+			--length;
+		out.append(slot.text, 0, length);
+		out += '\n';
+	}
+
+	void writeBatch(const std::string &batch)
+	{
+		Options options;
+		bool reopen;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			reopen = m_reopen;
+			m_reopen = false;
+			options = m_options;
+		}
+
+		if (reopen)
+		{
+			closeFile();
+			m_path = options.path;
+			m_max_size = options.max_size;
+			m_max_files = options.max_files;
+		}
+
+		if (m_fd < 0)
+			openFile();
+
+		if (m_fd >= 0 && m_max_size != 0 && m_size > 0 && m_size + batch.size() > m_max_size)
+			rotate();
+
+		if (m_fd < 0)
+			return;
+
+		const char *data = batch.data();
+		size_t left = batch.size();
+		while (left > 0)
+		{
+#ifdef _WIN32
+			int written = _write(m_fd, data, static_cast<unsigned int>(left));
+#else
+			ssize_t written = ::write(m_fd, data, left);
+			if (written < 0 && errno == EINTR)
+				continue;
+#endif
+			if (written <= 0)
+				break;
+			data += written;
+			left -= static_cast<size_t>(written);
+		}
+		m_size += batch.size() - left;
+	}
+
+	void openFile()
+	{
+#ifdef _WIN32
+		_sopen_s(&m_fd, m_path.c_str(), _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY, _SH_DENYNO, _S_IREAD | _S_IWRITE);
+		m_size = m_fd >= 0 ? static_cast<size_t>(_lseeki64(m_fd, 0, SEEK_END)) : 0;
+#else
+		m_fd = ::open(m_path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+		m_size = m_fd >= 0 ? static_cast<size_t>(::lseek(m_fd, 0, SEEK_END)) : 0;
+#endif
+	}
+
+	void closeFile()
+	{
+		if (m_fd < 0)
+			return;
+#ifdef _WIN32
+		_close(m_fd);
+#else
+		::close(m_fd);
+#endif
+		m_fd = -1;
+		m_size = 0;
+	}
+
+	/// <summary>
+	/// Shifts path.N-1 to path.N down to path to path.1 and starts an empty log.
+	/// </summary>
+	void rotate()
+	{
+		closeFile();
+		if (m_max_files == 0)
+		{
+			std::remove(m_path.c_str());
+		}
+		else
+		{
+			std::remove((m_path + "." + std::to_string(m_max_files)).c_str());
+			for (size_t i = m_max_files - 1; i >= 1; --i)
+			{
+				std::rename((m_path + "." + std::to_string(i)).c_str(), (m_path + "." + std::to_string(i + 1)).c_str());
+			}
+			std::rename(m_path.c_str(), (m_path + ".1").c_str());
+		}
+		openFile();
+	}
+
+	std::unique_ptr<Slot[]> m_slots;
+	std::atomic<size_t> m_enqueue;
+	// Only touched by the writer thread
+	size_t m_dequeue;
+	std::atomic<size_t> m_dropped;
+	size_t m_reported_dropped;
+	std::atomic<int> m_max_level;
+	std::atomic<bool> m_stopping;
+	std::atomic<bool> m_sleeping;
+
+	// Guards m_options and m_reopen, and the writer's sleep
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+	Options m_options;
+	bool m_reopen;
+
+	// File state, only touched by the writer thread
+	std::string m_path;
+	size_t m_max_size;
+	size_t m_max_files;
+	int m_fd;
+	size_t m_size;
+	time_t m_cached_second;
+	std::string m_cached_prefix;
+
+	// Started last, it uses everything above
+	std::thread m_thread;
+};
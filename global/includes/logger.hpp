@@ -1,119 +1,78 @@
 #pragma once
 
-#include <fstream>
-#include <time.h>
 #include <string>
-
+#include <type_traits>
+#include <log_writer.hpp>
+
+/// <summary>
+/// Logs to the process-wide LogWriter.
+/// A BoltLog holds no state, so owning or copying one costs nothing. Each statement is one line:
+///	logger << BoltLog::LOG_ERROR << "Query failed: " << e.what() << " code " << e.getErrorCode();
+/// The line is queued when the statement ends. Lines above the configured level are not formatted at all.
+/// </summary>
 class BoltLog {
 
 public:
-	//If you cant / dont - want - to use C++11, remove the "class" word after enum
 	enum TYPE { LOG_ERROR, LOG_WARNING, LOG_INFO };
 
-	// ctor (remove parameters if you dont need them)
-	explicit BoltLog(const char *fname = "c:/bolt_log.log")
-		: numWarnings(0U),
-		numErrors(0U)
+	/// <summary>
+	/// One line being built, queued by the destructor at the end of the logging statement.
+	/// </summary>
+	class Record
 	{
-
-		myFile.open(fname, std::ios_base::app | std::ios_base::out);
-
-		// Write the first lines
-		//if (myFile.is_open()) {
-		//	myFile << "My Game Engine, version " << std::endl;
-		//	myFile << "Log file created" << std::endl << std::endl;
-		//} // if
-
-	}
-
-
-	// dtor
-	~BoltLog() {
-
-		if (myFile.is_open()) {
-			//myFile << std::endl << std::endl;
-
-			// Report number of errors and warnings
-			//myFile << numWarnings << " warnings" << std::endl;
-			//myFile << numErrors << " errors" << std::endl;
-
-			myFile.close();
-		} // if
-
-	}
-
-
-	// Overload << operator using log type
-	friend BoltLog &operator << (BoltLog &logger, const BoltLog::TYPE l_type){
-
-		switch (l_type) {
-		case BoltLog::LOG_ERROR:
-			logger.myFile << "[ " << logger.currentDateTime() << " ] " << "[ERROR]: ";
-			++logger.numErrors;
-			break;
-
-		case BoltLog::LOG_WARNING:
-			logger.myFile << "[ " << logger.currentDateTime() << " ] " << "[WARNING]: ";
-			++logger.numWarnings;
-			break;
-
-		default:
-			logger.myFile << "[ " << logger.currentDateTime() << " ] " << "[INFO]: ";
-			break;
-		} // sw
-
-
-		return logger;
-
-	}
-
-
-	// Overload << operator using C style strings
-	// No need for std::string objects here
-	friend BoltLog &operator << (BoltLog &logger, const char *text) {
-
-		logger.myFile << text << std::endl;
-		return logger;
-
-	}
-
-	friend BoltLog &operator << (BoltLog &logger, const std::string text) {
-
-		logger.myFile << text << std::endl;
-		return logger;
-
-	}
-
-	friend BoltLog &operator << (BoltLog &logger, const int text) {
-
-		logger.myFile << text << std::endl;
-		return logger;
-
-	}
-
-
-	// Make it Non Copyable (or you can inherit from sf::NonCopyable if you want)
-	BoltLog(const BoltLog &) = delete;
-	BoltLog &operator= (const BoltLog &) = delete;
-
-
-
-private:
-	std::string currentDateTime()
+	public:
+		explicit Record(TYPE l_type)
+			: m_level(static_cast<LogWriter::level>(l_type)),
+			m_enabled(LogWriter::getInstance().enabled(static_cast<LogWriter::level>(l_type)))
+		{
+		}
+
+		Record(Record &&other)
+			: m_level(other.m_level), m_enabled(other.m_enabled), m_text(std::move(other.m_text))
+		{
+			other.m_enabled = false;
+		}
+
+		~Record()
+		{
+			if (m_enabled)
+				LogWriter::getInstance().push(m_level, std::move(m_text));
+		}
+
+		Record &operator << (const char *text)
+		{
+			if (m_enabled && text != nullptr)
+				m_text += text;
+			return *this;
+		}
+
+		Record &operator << (const std::string &text)
+		{
+			if (m_enabled)
+				m_text += text;
+			return *this;
+		}
+
+		template <typename T>
+		typename std::enable_if<std::is_arithmetic<T>::value, Record&>::type operator << (T value)
+		{
+			if (m_enabled)
+				m_text += std::to_string(value);
+			return *this;
+		}
+
+	private:
+		Record(const Record &);
+		Record &operator= (const Record &);
+
+		LogWriter::level m_level;
+		bool m_enabled;
+		std::string m_text;
+	};
+
+	// Starts a line of the given type
+	friend Record operator << (BoltLog &, const BoltLog::TYPE l_type)
 	{
-		time_t     now = time(nullptr);
-		struct tm  tstruct;
-		char       buf[80];
-		tstruct = *localtime(&now);
-		// Visit http://en.cppreference.com/w/cpp/chrono/c/strftime
-		// for more information about date/time format
-		strftime(buf, sizeof(buf), "%Y-%m-%d.%X", &tstruct);
-
-		return buf;
+		return Record(l_type);
 	}
-
-	std::ofstream           myFile;
-	unsigned int            numWarnings;
-	unsigned int            numErrors;
-
-}; // class end
\ No newline at end of file
+};
@@ -0,0 +1,621 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <limits>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <cppconn/driver.h>
+#include <cppconn/connection.h>
+#include <cppconn/exception.h>
+#include <cppconn/prepared_statement.h>
+#include <cppconn/resultset.h>
+
+/// <summary>
+/// Connection parameters and sizing of a MysqlConnectionPool.
+/// </summary>
+struct MysqlPoolOptions
+{
+	std::string host;
+	unsigned int port = 3306;
+	std::string user;
+	std::string password;
+	std::string schema;
+
+	// Connections kept open even when idle.
+	size_t min_size = 2;
+	// Hard limit of open connections, leased and idle together.
+	size_t max_size = 16;
+	// How long acquire() blocks for a free connection before it gives up.
+	std::chrono::milliseconds wait_timeout = std::chrono::milliseconds(5000);
+	// Idle connections above min_size are closed after this long.
+	std::chrono::milliseconds idle_timeout = std::chrono::milliseconds(300000);
+	// An idle connection older than this is pinged before it is handed out.
+	std::chrono::milliseconds validation_interval = std::chrono::milliseconds(30000);
+	// Prepared statements kept per connection. With 0 statements only live until the lease is returned.
+	size_t statement_cache_size = 64;
+};
+
+/// <summary>
+/// Counters of a MysqlConnectionPool, used to size the pool.
+/// Wait times are in microseconds and only count checkouts that had to wait.
+/// </summary>
+struct MysqlPoolStatistics
+{
+	uint64_t checkouts = 0;
+	uint64_t waits = 0;
+	uint64_t wait_time_total = 0;
+	uint64_t wait_time_max = 0;
+	uint64_t timeouts = 0;
+	uint64_t connections_opened = 0;
+	uint64_t connections_closed = 0;
+	size_t in_use = 0;
+	size_t idle = 0;
+	size_t max_size = 0;
+
+	uint64_t statement_hits = 0;
+	uint64_t statement_misses = 0;
+	uint64_t statement_evictions = 0;
+	size_t statement_cache_size = 0;
+};
+
+/// <summary>
+/// LRU cache of prepared statements of one connection, keyed by the exact SQL
+/// text. A statement handed out to a lease is pinned
+/// until the lease is returned, so a lease never loses a statement it still holds:
+/// eviction skips pinned statements, and the cache may grow past its capacity
+/// until the lease is returned.
+/// </summary>
+class MysqlStatementCache
+{
+public:
+	MysqlStatementCache() : m_generation(0) {}
+
+	/// <summary>
+	/// Returns the cached statement for a query, pinned and reset to its state when it
+	/// was prepared, or nullptr on a miss.
+	/// </summary>
+	sql::PreparedStatement *find(const std::string &key)
+	{
+		auto iter = m_index.find(key);
+		if (iter == m_index.end())
+			return nullptr;
+
+		m_entries.splice(m_entries.begin(), m_entries, iter->second);
+		Entry &entry = *iter->second;
+		entry.pinned = true;
+		// A previous lease may have changed the result set type, e.g. to forward only.
+		entry.statement->setResultSetType(entry.result_set_type);
+		entry.statement->clearParameters();
+		return entry.statement.get();
+	}
+
+	/// <summary>
+	/// Adds a statement as most recently used, pinned.
+	/// </summary>
+	/// <returns>Number of statements evicted to stay within capacity.</returns>
+	size_t insert(const std::string &key, std::unique_ptr<sql::PreparedStatement> statement, size_t capacity)
+	{
+		size_t evicted = trim(capacity > 0 ? capacity - 1 : 0);
+
+		Entry entry;
+		entry.key = key;
+		entry.result_set_type = statement->getResultSetType();
+		entry.statement = std::move(statement);
+		entry.pinned = true;
+		m_entries.push_front(std::move(entry));
+		m_index[key] = m_entries.begin();
+		return evicted;
+	}
+
+	/// <summary>
+	/// Unpins every statement when a lease is returned, and evicts down to capacity.
+	/// </summary>
+	/// <returns>Number of statements evicted.</returns>
+	size_t unpin(size_t capacity)
+	{
+		for (auto &entry : m_entries)
+			entry.pinned = false;
+		m_retired.clear();
+		return trim(capacity);
+	}
+
+	/// <summary>
+	/// Drops every statement, e.g. after a schema change. Pinned statements stay alive,
+	/// out of the cache, until the lease is returned.
+	/// </summary>
+	void retire()
+	{
+		for (auto &entry : m_entries)
+		{
+			if (entry.pinned)
+				m_retired.push_back(std::move(entry.statement));
+		}
+		m_index.clear();
+		m_entries.clear();
+	}
+
+	/// <summary>
+	/// Drops every statement, pinned or not. Only for a connection that is not leased.
+	/// </summary>
+	void clear()
+	{
+		m_index.clear();
+		m_entries.clear();
+		m_retired.clear();
+	}
+
+	unsigned int generation() const { return m_generation; }
+	void setGeneration(unsigned int generation) { m_generation = generation; }
+
+private:
+	struct Entry
+	{
+		Entry() : result_set_type(sql::ResultSet::TYPE_SCROLL_INSENSITIVE), pinned(false) {}
+
+		Entry(Entry &&other)
+			: key(std::move(other.key)), statement(std::move(other.statement)),
+			result_set_type(other.result_set_type), pinned(other.pinned)
+		{
+		}
+
+		std::string key;
+		std::unique_ptr<sql::PreparedStatement> statement;
+		// The type the statement was prepared with, restored when it is handed out again.
+		sql::ResultSet::enum_type result_set_type;
+		// Handed out to the current lease.
+		bool pinned;
+	};
+
+	/// <summary>
+	/// Evicts least recently used statements that are not pinned until at most capacity are left.
+	/// </summary>
+	size_t trim(size_t capacity)
+	{
+		size_t evicted = 0;
+		auto iter = m_entries.end();
+		while (m_entries.size() > capacity && iter != m_entries.begin())
+		{
+			--iter;
+			if (iter->pinned)
+				continue;
+
+			m_index.erase(iter->key);
+			iter = m_entries.erase(iter);
+			++evicted;
+		}
+		return evicted;
+	}
+
+	// Most recently used at the front.
+	std::list<Entry> m_entries;
+	std::unordered_map<std::string, std::list<Entry>::iterator> m_index;
+	// Statements dropped by retire() while a lease still held them.
+	std::vector<std::unique_ptr<sql::PreparedStatement>> m_retired;
+	unsigned int m_generation;
+};
+
+/// <summary>
+/// A connection owned by the pool together with its statement cache.
+/// </summary>
+struct MysqlPooledConnection
+{
+	explicit MysqlPooledConnection(sql::Connection *conn) : connection(conn) {}
+
+	~MysqlPooledConnection()
+	{
+		// Statements have to go before the connection they were prepared on.
+		statements.clear();
+	}
+
+	std::unique_ptr<sql::Connection> connection;
+	MysqlStatementCache statements;
+};
+
+class MysqlConnectionPool;
+
+/// <summary>
+/// A connection checked out of a MysqlConnectionPool. The connection goes back
+/// to the pool when the lease is destroyed. A lease destroyed before done() was
+/// called, typically because an exception unwound it, returns its connection as
+/// suspect. It is validated before its next checkout, so a "server has gone away"
+/// error leads to a reconnect instead of a second failure.
+/// </summary>
+class MysqlConnectionLease
+{
+public:
+	MysqlConnectionLease(MysqlConnectionLease &&other)
+		: m_pool(other.m_pool), m_connection(std::move(other.m_connection)), m_broken(other.m_broken),
+		m_done(other.m_done)
+	{
+		other.m_pool = nullptr;
+	}
+
+	~MysqlConnectionLease();
+
+	sql::Connection *getConnection() const { return m_connection->connection.get(); }
+	sql::Connection *operator->() const { return m_connection->connection.get(); }
+
+	/// <summary>
+	/// Returns a prepared statement from the connection's statement cache, preparing it on a miss.
+	/// The statement belongs to the cache and stays pinned until the lease is returned:
+	/// do not delete it, and do not use it after the lease is gone.
+	/// </summary>
+	/// <param name="sql">The query.</param>
+	/// <returns>The statement with its parameters cleared and its result set type reset.</returns>
+	sql::PreparedStatement *prepareStatement(const std::string &sql);
+
+	/// <summary>
+	/// Marks the connection as unusable. It is validated, and reconnected if needed,
+	/// before it is leased again.
+	/// </summary>
+	void invalidate() { m_broken = true; }
+
+	/// <summary>
+	/// Marks the work on the connection as finished without an error, call it before leaving
+	/// the scope of the lease normally.
+	/// </summary>
+	void done() { m_done = true; }
+
+	MysqlConnectionLease(const MysqlConnectionLease &) = delete;
+	MysqlConnectionLease &operator=(const MysqlConnectionLease &) = delete;
+
+private:
+	friend class MysqlConnectionPool;
+
+	MysqlConnectionLease(MysqlConnectionPool *pool, std::unique_ptr<MysqlPooledConnection> connection)
+		: m_pool(pool), m_connection(std::move(connection)), m_broken(false), m_done(false)
+	{
+	}
+
+	MysqlConnectionPool *m_pool;
+	std::unique_ptr<MysqlPooledConnection> m_connection;
+	bool m_broken;
+	bool m_done;
+};
+
+/// <summary>
+/// Bounded pool of MySQL connections. acquire() hands out the most recently used
+/// idle connection, opens a new one while below max_size, or waits up to
+/// wait_timeout for a lease to be returned. A timeout is reported as
+/// sql::SQLException so callers keep their existing error handling.
+/// </summary>
+class MysqlConnectionPool
+{
+public:
+	typedef std::chrono::steady_clock clock;
+
+	explicit MysqlConnectionPool(const MysqlPoolOptions &options)
+		: m_options(options), m_open(0), m_stats(),
+		m_statement_generation(0), m_statement_hits(0), m_statement_misses(0), m_statement_evictions(0)
+	{
+		if (m_options.max_size == 0)
+			m_options.max_size = 1;
+		if (m_options.min_size > m_options.max_size)
+			m_options.min_size = m_options.max_size;
+
+		m_driver = get_driver_instance();
+
+		// Pre-opening is best effort, an unreachable server is reported by the first acquire().
+		try
+		{
+			for (size_t i = 0; i < m_options.min_size; i++)
+			{
+				std::unique_ptr<MysqlPooledConnection> connection(connect());
+				m_idle.push_back(IdleConnection(std::move(connection), clock::now()));
+				++m_open;
+				++m_stats.connections_opened;
+			}
+		}
+		catch (sql::SQLException &)
+		{
+		}
+	}
+
+	~MysqlConnectionPool()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_idle.clear();
+	}
+
+	/// <summary>
+	/// Checks a connection out of the pool.
+	/// </summary>
+	/// <returns>A lease that returns the connection when destroyed.</returns>
+	MysqlConnectionLease acquire()
+	{
+		std::vector<std::unique_ptr<MysqlPooledConnection>> expired;
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		reapIdle(expired);
+
+		if (m_idle.empty() && m_open >= m_options.max_size)
+		{
+			const clock::time_point started = clock::now();
+			const clock::time_point deadline = started + m_options.wait_timeout;
+			bool timed_out = false;
+
+			while (m_idle.empty() && m_open >= m_options.max_size && !timed_out)
+			{
+				timed_out = m_available.wait_until(lock, deadline) == std::cv_status::timeout
+					&& m_idle.empty() && m_open >= m_options.max_size;
+			}
+
+			const uint64_t waited = static_cast<uint64_t>(
+				std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - started).count());
+			++m_stats.waits;
+			m_stats.wait_time_total += waited;
+			if (waited > m_stats.wait_time_max)
+				m_stats.wait_time_max = waited;
+
+			if (timed_out)
+			{
+				++m_stats.timeouts;
+				throw sql::SQLException("Timed out waiting for a pooled MySQL connection", "HY000", 0);
+			}
+		}
+		++m_stats.checkouts;
+
+		if (!m_idle.empty())
+		{
+			IdleConnection idle(std::move(m_idle.back()));
+			m_idle.pop_back();
+			lock.unlock();
+			expired.clear();
+
+			if (idle.suspect || clock::now() - idle.last_used > m_options.validation_interval)
+			{
+				revalidate(idle.connection);
+			}
+			return MysqlConnectionLease(this, std::move(idle.connection));
+		}
+
+		++m_open;
+		++m_stats.connections_opened;
+		lock.unlock();
+		expired.clear();
+
+		try
+		{
+			return MysqlConnectionLease(this, std::unique_ptr<MysqlPooledConnection>(connect()));
+		}
+		catch (...)
+		{
+			discard();
+			throw;
+		}
+	}
+
+	/// <summary>
+	/// Number of connections currently open, leased and idle together.
+	/// </summary>
+	size_t size() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_open;
+	}
+
+	/// <summary>
+	/// Drops the cached statements of every connection, e.g. after a schema change.
+	/// Each connection clears its cache the next time it prepares a statement.
+	/// </summary>
+	void invalidateStatements()
+	{
+		++m_statement_generation;
+	}
+
+	/// <summary>
+	/// Snapshot of the pool counters.
+	/// </summary>
+	MysqlPoolStatistics statistics() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		MysqlPoolStatistics stats = m_stats;
+		stats.idle = m_idle.size();
+		stats.in_use = m_open - m_idle.size();
+		stats.max_size = m_options.max_size;
+		stats.statement_hits = m_statement_hits;
+		stats.statement_misses = m_statement_misses;
+		stats.statement_evictions = m_statement_evictions;
+		stats.statement_cache_size = m_options.statement_cache_size;
+		return stats;
+	}
+
+	MysqlConnectionPool(const MysqlConnectionPool &) = delete;
+	MysqlConnectionPool &operator=(const MysqlConnectionPool &) = delete;
+
+private:
+	friend class MysqlConnectionLease;
+
+	struct IdleConnection
+	{
+		IdleConnection(std::unique_ptr<MysqlPooledConnection> conn, clock::time_point used, bool is_suspect = false)
+			: connection(std::move(conn)), last_used(used), suspect(is_suspect)
+		{
+		}
+
+		IdleConnection(IdleConnection &&other)
+			: connection(std::move(other.connection)), last_used(other.last_used), suspect(other.suspect)
+		{
+		}
+
+		IdleConnection &operator=(IdleConnection &&other)
+		{
+			connection = std::move(other.connection);
+			last_used = other.last_used;
+			suspect = other.suspect;
+			return *this;
+		}
+
+		std::unique_ptr<MysqlPooledConnection> connection;
+		clock::time_point last_used;
+		bool suspect;
+	};
+
+	MysqlPooledConnection *connect()
+	{
+		std::unique_ptr<sql::Connection> connection(m_driver->connect("tcp://" + m_options.host + ":" + std::to_string(m_options.port), m_options.user, m_options.password));
+		connection->setSchema(m_options.schema);
+
+		MysqlPooledConnection *pooled = new MysqlPooledConnection(connection.release());
+		pooled->statements.setGeneration(m_statement_generation);
+		return pooled;
+	}
+
+	sql::PreparedStatement *prepareStatement(MysqlPooledConnection &pooled, const std::string &sql)
+	{
+		const unsigned int generation = m_statement_generation;
+		if (pooled.statements.generation() != generation)
+		{
+			pooled.statements.retire();
+			pooled.statements.setGeneration(generation);
+		}
+
+		//Keyed on the exact text, whitespace inside literals and quoted identifiers is significant
+		const std::string &key = sql;
+		sql::PreparedStatement *statement = pooled.statements.find(key);
+		if (statement)
+		{
+			++m_statement_hits;
+			return statement;
+		}
+
+		++m_statement_misses;
+		std::unique_ptr<sql::PreparedStatement> prepared(pooled.connection->prepareStatement(sql));
+		statement = prepared.get();
+		m_statement_evictions += pooled.statements.insert(key, std::move(prepared), statementCapacity());
+		return statement;
+	}
+
+	size_t statementCapacity() const
+	{
+		return m_options.statement_cache_size != 0 ? m_options.statement_cache_size : (std::numeric_limits<size_t>::max)();
+	}
+
+	/// <summary>
+	/// Pings a connection and reopens it when the server dropped it.
+	/// Throws sql::SQLException, and releases the pool slot, when the server stays unreachable.
+	/// </summary>
+	void revalidate(std::unique_ptr<MysqlPooledConnection> &pooled)
+	{
+		try
+		{
+			if (pooled->connection->isValid())
+				return;
+
+			// Statements do not survive a reconnect
+			pooled->statements.clear();
+			if (pooled->connection->reconnect())
+			{
+				pooled->connection->setSchema(m_options.schema);
+				return;
+			}
+		}
+		catch (sql::SQLException &)
+		{
+		}
+
+		pooled.reset();
+		try
+		{
+			pooled.reset(connect());
+			std::lock_guard<std::mutex> lock(m_mutex);
+			++m_stats.connections_closed;
+			++m_stats.connections_opened;
+		}
+		catch (...)
+		{
+			discard();
+			throw;
+		}
+	}
+
+	/// <summary>
+	/// Closes idle connections that outlived idle_timeout, keeping at least min_size open.
+	/// The connections are handed to the caller so they are closed outside the lock.
+	/// </summary>
+	void reapIdle(std::vector<std::unique_ptr<MysqlPooledConnection>> &expired)
+	{
+		const clock::time_point now = clock::now();
+		while (!m_idle.empty() && m_open > m_options.min_size
+			&& now - m_idle.front().last_used > m_options.idle_timeout)
+		{
+			expired.push_back(std::move(m_idle.front().connection));
+			m_idle.pop_front();
+			--m_open;
+			++m_stats.connections_closed;
+		}
+	}
+
+	void release(std::unique_ptr<MysqlPooledConnection> pooled, bool suspect)
+	{
+		// A statement interrupted by an error may be left mid-result, start over on this connection.
+		if (pooled && (suspect || m_options.statement_cache_size == 0))
+			pooled->statements.clear();
+		else if (pooled)
+			m_statement_evictions += pooled->statements.unpin(statementCapacity());
+
+		std::vector<std::unique_ptr<MysqlPooledConnection>> expired;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (pooled)
+			{
+				m_idle.push_back(IdleConnection(std::move(pooled), clock::now(), suspect));
+			}
+			else
+			{
+				--m_open;
+				++m_stats.connections_closed;
+			}
+			reapIdle(expired);
+		}
+		m_available.notify_one();
+	}
+
+	void discard()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			--m_open;
+			++m_stats.connections_closed;
+		}
+		m_available.notify_one();
+	}
+
+	MysqlPoolOptions m_options;
+	sql::Driver *m_driver;
+
+	mutable std::mutex m_mutex;
+	std::condition_variable m_available;
+	// Most recently returned connection at the back, longest idle at the front.
+	std::deque<IdleConnection> m_idle;
+	size_t m_open;
+	MysqlPoolStatistics m_stats;
+
+	// Statement cache counters are updated by lease holders outside the pool lock.
+	std::atomic<unsigned int> m_statement_generation;
+	std::atomic<uint64_t> m_statement_hits;
+	std::atomic<uint64_t> m_statement_misses;
+	std::atomic<uint64_t> m_statement_evictions;
+};
+
+inline sql::PreparedStatement *MysqlConnectionLease::prepareStatement(const std::string &sql)
+{
+	return m_pool->prepareStatement(*m_connection, sql);
+}
+
+inline MysqlConnectionLease::~MysqlConnectionLease()
+{
+	if (m_pool)
+	{
+		m_pool->release(std::move(m_connection), m_broken || !m_done);
+	}
+}
@@ -1,4 +1,5 @@
 #include <fstream>
+#include <limits>
 #include <configuration.hpp>
 
 using namespace std;
@@ -33,6 +34,133 @@ const string Config::bolt_host = "bolt-host";
 /// </summary>
 const string Config::bolt_port = "bolt-port";
 
+/// <summary>
+/// Connections the auth pool keeps open
+/// </summary>
+const string Config::auth_pool_min_size = "auth-pool-min-size";
+/// <summary>
+/// Upper bound of the auth pool
+/// </summary>
+const string Config::auth_pool_max_size = "auth-pool-max-size";
+/// <summary>
+/// Milliseconds an auth lookup waits for a free connection
+/// </summary>
+const string Config::auth_pool_wait_timeout = "auth-pool-wait-timeout";
+/// <summary>
+/// Seconds an idle auth connection is kept above the minimum
+/// </summary>
+const string Config::auth_pool_idle_timeout = "auth-pool-idle-timeout";
+
+/// <summary>
+/// Database holding the tables served by the REST API
+/// </summary>
+const string Config::data_pool_database = "data-pool-database";
+/// <summary>
+/// Connections the data pool keeps open
+/// </summary>
+const string Config::data_pool_min_size = "data-pool-min-size";
+/// <summary>
+/// Upper bound of the data pool
+/// </summary>
+const string Config::data_pool_max_size = "data-pool-max-size";
+/// <summary>
+/// Milliseconds a table request waits for a free connection
+/// </summary>
+const string Config::data_pool_wait_timeout = "data-pool-wait-timeout";
+/// <summary>
+/// Seconds an idle data connection is kept above the minimum
+/// </summary>
+const string Config::data_pool_idle_timeout = "data-pool-idle-timeout";
+
+/// <summary>
+/// Seconds between checks of the grant tables for changes
+/// </summary>
+const string Config::permission_cache_refresh = "permission-cache-refresh";
+/// <summary>
+/// Seconds a signing key is cached
+/// </summary>
+const string Config::signing_key_cache_ttl = "signing-key-cache-ttl";
+
+/// <summary>
+/// Write mode of the whole database: both, azure or mysql
+/// </summary>
+const string Config::whole_consistency = "whole-consistency";
+
+/// <summary>
+/// Entities returned by one GET on a collection
+/// </summary>
+const string Config::max_page_size = "max-page-size";
+
+/// <summary>
+/// Threads that run requests, storage calls block only these
+/// </summary>
+const string Config::blocking_threads = "blocking-threads";
+
+/// <summary>
+/// Requests waiting for a blocking thread before the server answers 503
+/// </summary>
+const string Config::blocking_queue_size = "blocking-queue-size";
+
+/// <summary>
+/// Threads of the listener and http client io_service, 0 for one per core
+/// </summary>
+const string Config::io_threads = "io-threads";
+
+/// <summary>
+/// Threads running task continuations, 0 for two per core
+/// </summary>
+const string Config::continuation_threads = "continuation-threads";
+
+/// <summary>
+/// Binds each io and continuation thread to one core
+/// </summary>
+const string Config::pin_threads = "pin-threads";
+
+/// <summary>
+/// Sockets accepting connections on the server port, each with its own thread
+/// </summary>
+const string Config::listener_acceptors = "listener-acceptors";
+
+/// <summary>
+/// Bytes of a request body read from the socket at once
+/// </summary>
+const string Config::body_chunk_size = "body-chunk-size";
+
+/// <summary>
+/// Seconds an idle keep-alive connection stays open
+/// </summary>
+const string Config::keep_alive_timeout = "keep-alive-timeout";
+
+/// <summary>
+/// Requests served on one connection before it is closed
+/// </summary>
+const string Config::max_requests_per_connection = "max-requests-per-connection";
+
+/// <summary>
+/// Requests read ahead on one connection while earlier responses are pending
+/// </summary>
+const string Config::max_pipelined_requests = "max-pipelined-requests";
+
+/// <summary>
+/// Log file, empty for the platform default
+/// </summary>
+const string Config::log_file = "log-file";
+
+/// <summary>
+/// Most verbose level logged: error, warning or info
+/// </summary>
+const string Config::log_level = "log-level";
+
+/// <summary>
+/// Bytes the log grows to before it is rotated
+/// </summary>
+const string Config::log_max_size = "log-max-size";
+
+/// <summary>
+/// Rotated log files kept
+/// </summary>
+const string Config::log_max_files = "log-max-files";
+
 // Config Class Declaration
 unique_ptr<Config> Config::m_instance;
 once_flag Config::m_instance_flag;
@@ -58,6 +186,41 @@ Config::Config()
 		string conf_bolt_host;
 		string conf_bolt_port;
 
+		string conf_auth_pool_min_size;
+		string conf_auth_pool_max_size;
+		string conf_auth_pool_wait_timeout;
+		string conf_auth_pool_idle_timeout;
+
+		string conf_data_pool_database;
+		string conf_data_pool_min_size;
+		string conf_data_pool_max_size;
+		string conf_data_pool_wait_timeout;
+		string conf_data_pool_idle_timeout;
+
+		string conf_permission_cache_refresh;
+		string conf_signing_key_cache_ttl;
+
+		string conf_whole_consistency;
+
+		string conf_max_page_size;
+
+		string conf_blocking_threads;
+		string conf_blocking_queue_size;
+
+		string conf_io_threads;
+		string conf_continuation_threads;
+		string conf_pin_threads;
+		string conf_listener_acceptors;
+		string conf_body_chunk_size;
+		string conf_keep_alive_timeout;
+		string conf_max_requests_per_connection;
+		string conf_max_pipelined_requests;
+
+		string conf_log_file;
+		string conf_log_level;
+		string conf_log_max_size;
+		string conf_log_max_files;
+
 		// Declare a group of options that will be
 		// allowed in config file
 		po::options_description config("Configuration");
@@ -68,7 +231,34 @@ Config::Config()
 			(mysql_user.c_str(), po::value<string>(&conf_mysql_user)->default_value("root"), "Name of the mysql database")
 			(mysql_password.c_str(), po::value<string>(&conf_mysql_password)->default_value(""), "Password of the mysql database")
 			(bolt_host.c_str(), po::value<string>(&conf_bolt_host)->default_value("localhost"), "Bolt server host")
-			(bolt_port.c_str(), po::value<string>(&conf_bolt_port)->default_value("34568"), "bolt server password");
+			(bolt_port.c_str(), po::value<string>(&conf_bolt_port)->default_value("34568"), "bolt server password")
+			(auth_pool_min_size.c_str(), po::value<string>(&conf_auth_pool_min_size)->default_value("2"), "Connections the auth pool keeps open")
+			(auth_pool_max_size.c_str(), po::value<string>(&conf_auth_pool_max_size)->default_value("8"), "Maximum connections of the auth pool")
+			(auth_pool_wait_timeout.c_str(), po::value<string>(&conf_auth_pool_wait_timeout)->default_value("2000"), "Milliseconds to wait for an auth connection")
+			(auth_pool_idle_timeout.c_str(), po::value<string>(&conf_auth_pool_idle_timeout)->default_value("300"), "Seconds before an idle auth connection is closed")
+			(data_pool_database.c_str(), po::value<string>(&conf_data_pool_database)->default_value("boltdata"), "Name of the mysql database holding the served tables")
+			(data_pool_min_size.c_str(), po::value<string>(&conf_data_pool_min_size)->default_value("2"), "Connections the data pool keeps open")
+			(data_pool_max_size.c_str(), po::value<string>(&conf_data_pool_max_size)->default_value("16"), "Maximum connections of the data pool")
+			(data_pool_wait_timeout.c_str(), po::value<string>(&conf_data_pool_wait_timeout)->default_value("5000"), "Milliseconds to wait for a data connection")
+			(data_pool_idle_timeout.c_str(), po::value<string>(&conf_data_pool_idle_timeout)->default_value("300"), "Seconds before an idle data connection is closed")
+			(permission_cache_refresh.c_str(), po::value<string>(&conf_permission_cache_refresh)->default_value("5"), "Seconds between permission cache version checks")
+			(signing_key_cache_ttl.c_str(), po::value<string>(&conf_signing_key_cache_ttl)->default_value("300"), "Seconds a signing key is cached")
+			(whole_consistency.c_str(), po::value<string>(&conf_whole_consistency)->default_value("both"), "Whole database writes: both, or the primary azure/mysql with async replication")
+			(max_page_size.c_str(), po::value<string>(&conf_max_page_size)->default_value("1000"), "Entities returned by one GET on a collection, and the upper bound of $top")
+			(blocking_threads.c_str(), po::value<string>(&conf_blocking_threads)->default_value("32"), "Threads that run requests and their blocking storage calls")
+			(blocking_queue_size.c_str(), po::value<string>(&conf_blocking_queue_size)->default_value("512"), "Requests queued for a blocking thread before 503 is returned")
+			(io_threads.c_str(), po::value<string>(&conf_io_threads)->default_value("0"), "Listener and http client I/O threads, 0 for one per core")
+			(continuation_threads.c_str(), po::value<string>(&conf_continuation_threads)->default_value("0"), "Task continuation threads, 0 for two per core")
+			(pin_threads.c_str(), po::value<string>(&conf_pin_threads)->default_value("false"), "Pin io and continuation threads to cores: true or false")
+			(listener_acceptors.c_str(), po::value<string>(&conf_listener_acceptors)->default_value("1"), "Acceptors sharing the server port with SO_REUSEPORT, each on its own thread")
+			(body_chunk_size.c_str(), po::value<string>(&conf_body_chunk_size)->default_value("65536"), "Bytes of a request body read from the socket at once")
+			(keep_alive_timeout.c_str(), po::value<string>(&conf_keep_alive_timeout)->default_value("60"), "Seconds an idle keep-alive connection stays open, 0 never closes it")
+			(max_requests_per_connection.c_str(), po::value<string>(&conf_max_requests_per_connection)->default_value("0"), "Requests served on one connection before it is closed, 0 for no limit")
+			(max_pipelined_requests.c_str(), po::value<string>(&conf_max_pipelined_requests)->default_value("16"), "Requests read ahead on one connection while earlier responses are pending")
+			(log_file.c_str(), po::value<string>(&conf_log_file)->default_value(""), "Log file, empty for the platform default")
+			(log_level.c_str(), po::value<string>(&conf_log_level)->default_value("info"), "Most verbose level logged: error, warning or info")
+			(log_max_size.c_str(), po::value<string>(&conf_log_max_size)->default_value("10485760"), "Bytes the log grows to before it is rotated, 0 never rotates")
+			(log_max_files.c_str(), po::value<string>(&conf_log_max_files)->default_value("5"), "Rotated log files kept");
 
 		//Add allowed configurations
 		m_config_file_options.add(config);
@@ -83,20 +273,38 @@ Config::Config()
 		{
 			store(parse_config_file(ifs, m_config_file_options), m_config_map);
 			notify(m_config_map);
+
+			LogWriter::Options log_options;
+			log_options.path = conf_log_file;
+			log_options.max_level = LogWriter::parseLevel(conf_log_level);
+			log_options.max_size = stoul(conf_log_max_size);
+			log_options.max_files = stoul(conf_log_max_files);
+			LogWriter::getInstance().configure(log_options);
+
+			if (conf_whole_consistency != "both" && conf_whole_consistency != "azure" && conf_whole_consistency != "mysql")
+			{
+				throw po::validation_error(po::validation_error::invalid_option_value, whole_consistency, conf_whole_consistency);
+			}
 		}
 	}
 	catch (exception& e)
 	{
+		m_valid = false;
 		bolt_log << BoltLog::LOG_ERROR << e.what() << "\n";
 	}
 }
 
+bool Config::isValid() const
+{
+	return m_valid;
+}
+
 utility::string_t Config::getConfigOption(const string con_name)
 {
 	if (!m_config_map.count(con_name))
 	{
 		bolt_log << BoltLog::LOG_ERROR << "Config read error: " << m_config_file << "\n";
-		return nullptr;
+		return utility::string_t();
 	}
 	return utility::conversions::to_string_t(m_config_map[con_name].as<string>());
 }
@@ -106,11 +314,71 @@ string Config::getStdConfigOption(const string con_name)
 	if (!m_config_map.count(con_name))
 	{
 		bolt_log << BoltLog::LOG_ERROR << "Config read error: " << m_config_file << "\n";
-		return nullptr;
+		return string();
 	}
 	return m_config_map[con_name].as<string>();
 }
 
+/// <summary>
+/// Reads a whole number without sign, false when text is empty, holds anything else or overflows.
+/// </summary>
+static bool parseNumber(const string &text, unsigned long &value)
+{
+	if (text.empty() || text.size() > 19)
+		return false;
+
+	unsigned long long number = 0;
+	for (char c : text)
+	{
+		if (c < '0' || c > '9')
+			return false;
+		number = number * 10 + static_cast<unsigned long long>(c - '0');
+	}
+	if (number > numeric_limits<unsigned long>::max())
+		return false;
+	value = static_cast<unsigned long>(number);
+	return true;
+}
+
+string Config::getDefaultOption(const string con_name)
+{
+	const po::option_description *option = m_config_file_options.find_nothrow(con_name, false);
+	boost::any value;
+	if (option == nullptr || !option->semantic()->apply_default(value))
+		return string();
+	return boost::any_cast<string>(value);
+}
+
+unsigned long Config::getNumberOption(const string con_name, unsigned long minimum, unsigned long maximum)
+{
+	unsigned long value = 0;
+	//Without a config file the map is empty, its error was already logged
+	if (m_config_map.count(con_name))
+	{
+		string text = m_config_map[con_name].as<string>();
+		if (!parseNumber(text, value))
+		{
+			bolt_log << BoltLog::LOG_WARNING << con_name << " is not a number: '" << text << "', the default is used";
+		}
+		else if (value < minimum || value > maximum)
+		{
+			bolt_log << BoltLog::LOG_WARNING << con_name << " must be between " << minimum << " and " << maximum
+				<< ", not " << value << ", the default is used";
+		}
+		else
+		{
+			return value;
+		}
+	}
+
+	if (!parseNumber(getDefaultOption(con_name), value))
+	{
+		bolt_log << BoltLog::LOG_ERROR << con_name << " has no numeric default";
+		return 0;
+	}
+	return value;
+}
+
 utility::string_t Config::getServerHostWithPort()
 {
 	utility::string_t address = U("http://") + getConfigOption(bolt_host) + U(":");
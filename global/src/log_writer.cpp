@@ -0,0 +1,7 @@
+#include <log_writer.hpp>
+
+LogWriter &LogWriter::getInstance()
+{
+	static LogWriter instance;
+	return instance;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#ifdef BOLTAZURE_DLL
+#define BOLTAZURE_API __declspec( dllexport )
+#else
+#define BOLTAZURE_API __declspec( dllimport )
+#endif
+
+#include "was/table.h"
+#include <logger.hpp>
+
+namespace bolt {
+	namespace storage {
+		namespace boltazure {
+			using namespace azure::storage;
+
+			/// <summary>
+			/// Writes many entities of one table with entity group transactions.
+			/// Entities are grouped by PartitionKey and sent in batches of up to 100 insert-or-merge operations,
+			/// properties an entity does not carry keep their stored values, as in the MySQL batch.
+			/// </summary>
+			class AzureBatch
+			{
+			public:
+				/// <summary>
+				/// Outcome of a single entity of the batch.
+				/// </summary>
+				struct Result
+				{
+					Result() : succeeded(false) {}
+
+					bool succeeded;
+					utility::string_t error;
+				};
+
+				BOLTAZURE_API AzureBatch(cloud_table table);
+				BOLTAZURE_API ~AzureBatch();
+
+				/// <summary>
+				/// Queues an entity, it is written by execute().
+				/// </summary>
+				/// <param name="entity">The entity.</param>
+				BOLTAZURE_API void add(const table_entity& entity);
+
+				BOLTAZURE_API size_t size() const;
+
+				/// <summary>
+				/// Writes the queued entities. A batch is atomic on the storage side,
+				/// so a failing batch fails every entity it carried.
+				/// </summary>
+				/// <returns>One result per entity, in the order they were added.</returns>
+				BOLTAZURE_API std::vector<Result> execute();
+
+			private:
+				class ABImpl;
+				std::shared_ptr<ABImpl> bimpl;
+			};
+		}
+	}
+}
@@ -2,24 +2,94 @@
 
 #include <was/storage_account.h>
 #include <was/table.h>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 namespace bolt {
 	namespace storage {
 		namespace boltazure {
 			using namespace azure::storage;
 
+			/// <summary>
+			/// Process-wide Azure table client. The storage account is parsed and the
+			/// table client created once; cloud_table references are cached per table name,
+			/// and each table is created at most once while it stays cached.
+			/// Table names come from request URLs, so the cache keeps only the most recently
+			/// used max_cached_tables tables.
+			/// </summary>
 			class AzureConnection
 			{
 			public:
-				AzureConnection() {}
 				~AzureConnection() {}
+				static AzureConnection& get_instance();
+
 				cloud_storage_account connect(utility::string_t account_name, utility::string_t account_key);
 				cloud_storage_account connect();
 
+				/// <summary>
+				/// The shared table client.
+				/// </summary>
+				cloud_table_client tableClient();
+
+				/// <summary>
+				/// Returns the cached reference of a table.
+				/// </summary>
+				/// <param name="table_name">The table name.</param>
+				/// <param name="create">Create the table unless it is already known to exist.</param>
+				cloud_table getTable(const utility::string_t& table_name, bool create = false);
+
+				/// <summary>
+				/// Creates a table if it does not exist and remembers that it exists.
+				/// </summary>
+				/// <returns>true when the table was created by this call.</returns>
+				bool createTable(const utility::string_t& table_name);
+
+				/// <summary>
+				/// Deletes a table and forgets its reference.
+				/// </summary>
+				/// <returns>true when the table existed.</returns>
+				bool deleteTable(const utility::string_t& table_name);
+
 			private:
+				static const size_t max_cached_tables = 1024;
+
+				struct CachedTable
+				{
+					cloud_table table;
+					// create_if_not_exists already ran for the table
+					bool exists;
+					// Position in m_recent
+					std::list<utility::string_t>::iterator recent;
+				};
+
+				AzureConnection();
+
+				/// <summary>
+				/// Finds or adds the entry of a table and marks it most recently used.
+				/// Evicts the least recently used entries beyond max_cached_tables. m_mutex must be held.
+				/// </summary>
+				CachedTable &touch(const utility::string_t& table_name);
+
+				/// <summary>
+				/// Remembers that a table exists, if it is still cached. m_mutex must be held.
+				/// </summary>
+				void markExisting(const utility::string_t& table_name);
+
+				AzureConnection(const AzureConnection& src);
+				AzureConnection &operator=(const AzureConnection& rhs);
+				static std::unique_ptr<AzureConnection> m_instance;
+				static std::once_flag m_instance_flag;
+
 				cloud_storage_account storage_account;
-				void set_connect();
+				cloud_table_client m_table_client;
+
+				std::mutex m_mutex;
+				std::unordered_map<utility::string_t, CachedTable> m_tables;
+				// Cached table names, most recently used first
+				std::list<utility::string_t> m_recent;
 			};
 		}
 	}
-}
\ No newline at end of file
+}
@@ -88,6 +88,11 @@ namespace bolt  {
 				/// <returns></returns>
 				BOLTAZURE_API void insert(utility::string_t property_name, utility::uuid value);
 
+				/// <summary>
+				/// Gets the entity with the properties inserted so far, e.g. to add it to a <see cref="AzureBatch"/>.
+				/// </summary>
+				BOLTAZURE_API const table_entity& tableEntity() const;
+
 				/// <summary>
 				/// Create a Entity in the table.Have to pass PartitonKey,RowKey and entity size as params
 				/// Creates the entity.
@@ -106,6 +111,12 @@ namespace bolt  {
 				BOLTAZURE_API bool executeEntity();
 				BOLTAZURE_API bool replaceEntity();
 				BOLTAZURE_API bool patchEntity();
+
+				/// <summary>
+				/// Looks the entity up by its keys. An entity that cannot be looked up counts as existing.
+				/// </summary>
+				/// <returns></returns>
+				BOLTAZURE_API bool entityExists();
 				BOLTAZURE_API bool abort();
 
 			};
@@ -38,11 +38,25 @@ namespace bolt {
 				/// <returns>Query result vector</returns>
 				BOLTAZURE_API std::vector<table_entity> filterByKey(utility::string_t partition_key, utility::string_t row_key);
 
+				/// <summary>
+				/// Finds an entity by its keys without blocking the calling thread.
+				/// </summary>
+				/// <param name="partition_key">The partition key.</param>
+				/// <param name="row_key">The row key.</param>
+				/// <returns>The entity, or no entities when it does not exist or the request failed.</returns>
+				BOLTAZURE_API pplx::task<std::vector<table_entity>> filterByKeyAsync(utility::string_t partition_key, utility::string_t row_key);
+
 				BOLTAZURE_API void select(const std::vector<utility::string_t> columns);
 				BOLTAZURE_API void setFilterCondition(const utility::string_t property_name, const utility::string_t coperator, const utility::string_t value);
 				BOLTAZURE_API void setAndFilterCondition(const utility::string_t property_name, const utility::string_t coperator, const utility::string_t value);
 				BOLTAZURE_API void setOrFilterCondition(const utility::string_t property_name, const utility::string_t coperator, const utility::string_t value);
 
+				/// <summary>
+				/// Sets a complete filter string, replacing the filter conditions.
+				/// </summary>
+				/// <param name="filter">The filter, as built by table_query::generate_filter_condition and combine_filter_conditions.</param>
+				BOLTAZURE_API void setFilterString(const utility::string_t filter);
+
 				/// <summary>
 				/// Filter by Field
 				/// Filters the byfield.
@@ -76,6 +90,14 @@ namespace bolt {
 				BOLTAZURE_API bool executeDelete();
 
 				BOLTAZURE_API std::vector<table_entity> queryAll();
+
+				/// <summary>
+				/// Runs the query for a single page without blocking the calling thread.
+				/// </summary>
+				/// <param name="take_count">Maximum entities in the page.</param>
+				/// <param name="token">Continuation of the previous page, empty for the first one.</param>
+				/// <returns>The entities and the continuation of the next page, empty on the last one.</returns>
+				BOLTAZURE_API pplx::task<table_query_segment> querySegmentAsync(int take_count, const continuation_token &token);
 			};
 		}
 	}
@@ -0,0 +1,93 @@
+#include <azure_batch.h>
+#include <map>
+#include <unordered_set>
+
+namespace bolt  {
+	namespace storage {
+		namespace boltazure {
+
+			//Limit of operations in one entity group transaction
+			static const size_t max_batch_operations = 100;
+
+			class AzureBatch::ABImpl
+			{
+			public:
+				cloud_table table;
+				std::vector<table_entity> entities;
+				BoltLog bolt_logger;
+			};
+
+			AzureBatch::AzureBatch(cloud_table table) : bimpl{ new ABImpl }
+			{
+				bimpl->table = table;
+			}
+
+			AzureBatch::~AzureBatch()
+			{
+			}
+
+			void AzureBatch::add(const table_entity& entity)
+			{
+				bimpl->entities.push_back(entity);
+			}
+
+			size_t AzureBatch::size() const
+			{
+				return bimpl->entities.size();
+			}
+
+			std::vector<AzureBatch::Result> AzureBatch::execute()
+			{
+				std::vector<Result> results(bimpl->entities.size());
+
+				std::map<utility::string_t, std::vector<size_t>> partitions;
+				for (size_t i = 0; i < bimpl->entities.size(); ++i)
+				{
+					partitions[bimpl->entities[i].partition_key()].push_back(i);
+				}
+
+				for (const auto& partition : partitions)
+				{
+					const std::vector<size_t>& members = partition.second;
+					size_t first = 0;
+					while (first < members.size())
+					{
+						//A batch may not touch the same entity twice, a repeated RowKey starts the next batch
+						table_batch_operation operation;
+						std::unordered_set<utility::string_t> row_keys;
+						size_t last = first;
+						for (; last < members.size() && last - first < max_batch_operations; ++last)
+						{
+							const table_entity& entity = bimpl->entities[members[last]];
+							if (!row_keys.insert(entity.row_key()).second)
+								break;
+							operation.insert_or_merge_entity(entity);
+						}
+
+						bool succeeded = true;
+						utility::string_t error;
+						try
+						{
+							bimpl->table.execute_batch(operation);
+						}
+						catch (const storage_exception& e)
+						{
+							succeeded = false;
+							error = e.result().extended_error().message();
+							bimpl->bolt_logger << BoltLog::LOG_ERROR << utility::conversions::to_utf8string(error)
+								<< e.result().http_status_code();
+						}
+
+						for (size_t i = first; i < last; ++i)
+						{
+							results[members[i]].succeeded = succeeded;
+							results[members[i]].error = error;
+						}
+						first = last;
+					}
+				}
+				return results;
+			}
+		}
+	}
+}
@@ -3,15 +3,19 @@
 namespace bolt  {
 	namespace storage {
 		namespace boltazure {
-			/// <summary>
-			///Function for connect to Azure database using Development settings
-			/// <summary>
-			/// Connects this instance.
-			/// </summary>
-			/// <returns></returns>
-			void AzureConnection::set_connect()
+			std::unique_ptr<AzureConnection> AzureConnection::m_instance;
+			std::once_flag AzureConnection::m_instance_flag;
+
+			AzureConnection& AzureConnection::get_instance()
 			{
+				std::call_once(m_instance_flag, [] {m_instance.reset(new AzureConnection); });
+				return *m_instance.get();
+			}
 
+			AzureConnection::AzureConnection()
+			{
+				storage_account = connect();
+				m_table_client = storage_account.create_cloud_table_client();
 			}
 
 			/// <summary>
@@ -28,11 +32,98 @@ namespace bolt  {
 				return cloud_storage_account::parse(ConnectionString);
 			}
 
+			/// <summary>
+			///Function for connect to Azure database using Development settings
+			/// <summary>
+			/// Connects this instance.
+			/// </summary>
+			/// <returns></returns>
 			cloud_storage_account AzureConnection::connect()
 			{
 				utility::string_t connection_string = U("UseDevelopmentStorage=true;");
 				return cloud_storage_account::parse(connection_string);
 			}
+
+			cloud_table_client AzureConnection::tableClient()
+			{
+				return m_table_client;
+			}
+
+			AzureConnection::CachedTable &AzureConnection::touch(const utility::string_t& table_name)
+			{
+				auto iter = m_tables.find(table_name);
+				if (iter != m_tables.end())
+				{
+					m_recent.splice(m_recent.begin(), m_recent, iter->second.recent);
+					return iter->second;
+				}
+
+				while (m_tables.size() >= max_cached_tables)
+				{
+					m_tables.erase(m_recent.back());
+					m_recent.pop_back();
+				}
+
+				m_recent.push_front(table_name);
+				CachedTable &entry = m_tables[table_name];
+				entry.table = m_table_client.get_table_reference(table_name);
+				entry.exists = false;
+				entry.recent = m_recent.begin();
+				return entry;
+			}
+
+			void AzureConnection::markExisting(const utility::string_t& table_name)
+			{
+				auto iter = m_tables.find(table_name);
+				if (iter != m_tables.end())
+					iter->second.exists = true;
+			}
+
+			cloud_table AzureConnection::getTable(const utility::string_t& table_name, bool create)
+			{
+				cloud_table table;
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					CachedTable &entry = touch(table_name);
+					table = entry.table;
+
+					if (!create || entry.exists)
+						return table;
+				}
+
+				//Concurrent first writers may both get here, create_if_not_exists is harmless twice
+				table.create_if_not_exists();
+
+				std::lock_guard<std::mutex> lock(m_mutex);
+				markExisting(table_name);
+				return table;
+			}
+
+			bool AzureConnection::createTable(const utility::string_t& table_name)
+			{
+				cloud_table table = getTable(table_name);
+				bool created = table.create_if_not_exists();
+
+				std::lock_guard<std::mutex> lock(m_mutex);
+				markExisting(table_name);
+				return created;
+			}
+
+			bool AzureConnection::deleteTable(const utility::string_t& table_name)
+			{
+				cloud_table table = getTable(table_name);
+				{
+					//Forget the table first, a write racing the delete has to create it again
+					std::lock_guard<std::mutex> lock(m_mutex);
+					auto iter = m_tables.find(table_name);
+					if (iter != m_tables.end())
+					{
+						m_recent.erase(iter->second.recent);
+						m_tables.erase(iter);
+					}
+				}
+				return table.delete_table_if_exists();
+			}
 		}
 	}
-}
\ No newline at end of file
+}
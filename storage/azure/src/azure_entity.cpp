@@ -28,6 +28,11 @@ namespace bolt  {
 				aimpl->tab_entity = entity;
 			}
 
+			const table_entity& AzureEntity::tableEntity() const
+			{
+				return aimpl->tab_entity;
+			}
+
 			int AzureEntity::createEntity(utility::string_t PartitonKey, utility::string_t RowKey, size_t size)
 			{
 				// Insert a table entity
@@ -104,15 +109,30 @@ namespace bolt  {
 				return false;
 			}
 
+			bool AzureEntity::entityExists()
+			{
+				table_operation operation = table_operation::retrieve_entity(aimpl->tab_entity.partition_key(), aimpl->tab_entity.row_key());
+				try
+				{
+					return aimpl->table.execute(operation).http_status_code() != web::http::status_codes::NotFound;
+				}
+				catch (const storage_exception& e)
+				{
+					aimpl->bolt_logger << BoltLog::LOG_ERROR << utility::conversions::to_utf8string(e.result().extended_error().message())
+						<< e.result().http_status_code();
+				}
+				return true;
+			}
+
 			bool AzureEntity::abort()
 			{
 				table_entity table_en = aimpl->tab_entity;
 				table_operation operation2 = table_operation::retrieve_entity(table_en.partition_key(), table_en.row_key());
-				table_result retrieve_result = aimpl->table.execute(operation2);
-
-				table_operation operation4 = table_operation::delete_entity(retrieve_result.entity());
 
 				try {
+					table_result retrieve_result = aimpl->table.execute(operation2);
+
+					table_operation operation4 = table_operation::delete_entity(retrieve_result.entity());
 					aimpl->table.execute(operation4);
 					return true;
 				}
@@ -15,18 +15,12 @@ namespace bolt {
 			class AzureQuery::AQImpl
 			{
 			public:
-				AQImpl()
-				{
-					m_table_client = m_connection.connect().create_cloud_table_client();
-				}
-
-				AzureConnection m_connection;
-				cloud_table_client m_table_client;
 				cloud_table m_table;
 				table_query m_table_query;
 
 				std::map<utility::string_t, FilterCondition> m_query;
 				std::vector<utility::string_t> m_select_coloumns;
+				utility::string_t m_filter_string;
 
 				BoltLog bolt_logger;
 
@@ -46,7 +40,11 @@ namespace bolt {
 						t_query.set_select_columns(m_select_coloumns);
 					}
 
-					if (filter != m_query.cend())
+					if (!m_filter_string.empty())
+					{
+						t_query.set_filter_string(m_filter_string);
+					}
+					else if (filter != m_query.cend())
 					{
 						q_filter = table_query::generate_filter_condition(filter->second.property_name, filter->second.condition, filter->second.value);
 						t_query.set_filter_string(q_filter);
@@ -69,27 +67,37 @@ namespace bolt {
 
 			AzureQuery::AzureQuery(utility::string_t table_name) : qimpl{ new AQImpl }
 			{
-				qimpl->m_table = qimpl->m_table_client.get_table_reference(table_name);
+				qimpl->m_table = AzureConnection::get_instance().getTable(table_name);
 			}
 
 			std::vector<table_entity> AzureQuery::filterByKey(utility::string_t partition_key, utility::string_t row_key)
 			{
-				std::vector<table_entity> entities;
-				try
-				{
-					table_query query;
-					query.set_filter_string(table_query::combine_filter_conditions(
-						table_query::generate_filter_condition(U("PartitionKey"), query_comparison_operator::equal, partition_key),
-						query_logical_operator::and,
-						table_query::generate_filter_condition(U("RowKey"), query_comparison_operator::equal, row_key)));
-					entities = qimpl->m_table.execute_query(query);
-				}
-				catch (const storage_exception& e)
+				return filterByKeyAsync(partition_key, row_key).get();
+			}
+
+			pplx::task<std::vector<table_entity>> AzureQuery::filterByKeyAsync(utility::string_t partition_key, utility::string_t row_key)
+			{
+				table_query query;
+				query.set_filter_string(table_query::combine_filter_conditions(
+					table_query::generate_filter_condition(U("PartitionKey"), query_comparison_operator::equal, partition_key),
+					query_logical_operator::and,
+					table_query::generate_filter_condition(U("RowKey"), query_comparison_operator::equal, row_key)));
+
+				//The continuation keeps the implementation, and its logger, alive until the reply arrives
+				auto impl = qimpl;
+				return qimpl->m_table.execute_query_async(query).then([impl](pplx::task<std::vector<table_entity>> result)
 				{
-					qimpl->bolt_logger << BoltLog::LOG_ERROR << utility::conversions::to_utf8string(e.result().extended_error().message())
-						<< e.result().http_status_code();
-				}
-				return entities;
+					try
+					{
+						return result.get();
+					}
+					catch (const storage_exception& e)
+					{
+						impl->bolt_logger << BoltLog::LOG_ERROR << utility::conversions::to_utf8string(e.result().extended_error().message())
+							<< e.result().http_status_code();
+					}
+					return std::vector<table_entity>();
+				});
 			}
 
 			void AzureQuery::select(std::vector<utility::string_t> const columns)
@@ -127,6 +135,11 @@ namespace bolt {
 				qimpl->m_query[U("orjoin")] = condition;
 			}
 
+			void AzureQuery::setFilterString(utility::string_t const filter)
+			{
+				qimpl->m_filter_string = filter;
+			}
+
 			std::vector<table_entity> AzureQuery::filterByProperty(utility::string_t property_name, utility::string_t value)
 			{
 				std::vector<table_entity> entities;
@@ -203,6 +216,13 @@ namespace bolt {
 			{
 				return qimpl->m_table.execute_query(qimpl->buildQuery());
 			}
+
+			pplx::task<table_query_segment> AzureQuery::querySegmentAsync(int take_count, const continuation_token &token)
+			{
+				table_query query = qimpl->buildQuery();
+				query.set_take_count(take_count);
+				return qimpl->m_table.execute_query_segmented_async(query, token);
+			}
 		}
 	}
 }
\ No newline at end of file
@@ -6,11 +6,7 @@ namespace bolt {
 		namespace boltazure {
 			AzureTable::AzureTable(utility::string_t table_name)
 			{
-				AzureConnection connection;
-				cloud_table_client table_client = connection.connect().create_cloud_table_client();
-				cloud_table table = table_client.get_table_reference(table_name);
-				table.create_if_not_exists();
-				m_cloud_table = table;
+				m_cloud_table = AzureConnection::get_instance().getTable(table_name, true);
 			}
 
 			cloud_table AzureTable::getTable()
@@ -20,8 +16,7 @@ namespace bolt {
 
 			std::vector<utility::string_t> AzureTable::getTableList()
 			{
-				AzureConnection connection;
-				auto table_client = connection.connect().create_cloud_table_client();
+				auto table_client = AzureConnection::get_instance().tableClient();
 				auto tables = table_client.list_tables();
 
 				std::vector<utility::string_t> table_names;
@@ -34,18 +29,12 @@ namespace bolt {
 
 			bool AzureTable::createTable(utility::string_t table_name)
 			{
-				AzureConnection connection;
-				cloud_table_client table_client = connection.connect().create_cloud_table_client();
-				cloud_table table = table_client.get_table_reference(table_name);
-				return table.create_if_not_exists();
+				return AzureConnection::get_instance().createTable(table_name);
 			}
 
 			bool AzureTable::deleteTable(utility::string_t table_name)
 			{
-				AzureConnection connection;
-				cloud_table_client table_client = connection.connect().create_cloud_table_client();
-				cloud_table table = table_client.get_table_reference(table_name);
-				return table.delete_table_if_exists();
+				return AzureConnection::get_instance().deleteTable(table_name);
 			}
 		}
 	}
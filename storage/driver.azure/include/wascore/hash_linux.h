@@ -0,0 +1,70 @@
+// -----------------------------------------------------------------------------------------
+// <copyright file="hash_linux.h" company="Microsoft">
+//    Copyright 2013 Microsoft Corporation
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+// </copyright>
+// -----------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "basic_types.h"
+#include "streambuf.h"
+
+#ifndef WIN32
+
+#include <openssl/evp.h>
+
+namespace azure { namespace storage { namespace core {
+
+    // The digests run on OpenSSL's EVP interface, which picks the SHA-NI, AVX2, AVX or SSSE3
+    // SHA-256 code path for the CPU at startup and falls back to portable C elsewhere.
+
+    class basic_hash_hmac_sha256_streambuf : public basic_hash_streambuf
+    {
+    public:
+
+        explicit basic_hash_hmac_sha256_streambuf(const std::vector<unsigned char>& key);
+        ~basic_hash_hmac_sha256_streambuf();
+
+        pplx::task<void> _close_write();
+        pplx::task<int_type> _putc(char_type ch);
+        pplx::task<size_t> _putn(const char_type* ptr, size_t count);
+
+    private:
+
+        static const size_t block_size = 64;
+
+        // Runs the inner hash while data is written, the outer one on close
+        EVP_MD_CTX* m_context;
+        unsigned char m_outer_pad[block_size];
+    };
+
+    class basic_hash_md5_streambuf : public basic_hash_streambuf
+    {
+    public:
+
+        basic_hash_md5_streambuf();
+        ~basic_hash_md5_streambuf();
+
+        pplx::task<void> _close_write();
+        pplx::task<int_type> _putc(char_type ch);
+        pplx::task<size_t> _putn(const char_type* ptr, size_t count);
+
+    private:
+
+        EVP_MD_CTX* m_context;
+    };
+
+}}} // namespace azure::storage::core
+
+#endif
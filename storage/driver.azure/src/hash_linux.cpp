@@ -0,0 +1,172 @@
+// -----------------------------------------------------------------------------------------
+// <copyright file="hash_linux.cpp" company="Microsoft">
+//    Copyright 2013 Microsoft Corporation
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+// </copyright>
+// -----------------------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "wascore/hash_linux.h"
+
+#ifndef WIN32
+
+#include <cstring>
+#include <openssl/crypto.h>
+
+namespace azure {
+	namespace storage {
+		namespace core {
+
+			static EVP_MD_CTX* create_digest_context(const EVP_MD* digest)
+			{
+				EVP_MD_CTX* context = EVP_MD_CTX_create();
+				if (context == nullptr)
+				{
+					throw std::bad_alloc();
+				}
+
+				if (EVP_DigestInit_ex(context, digest, nullptr) != 1)
+				{
+					EVP_MD_CTX_destroy(context);
+					throw std::runtime_error("EVP_DigestInit_ex failed");
+				}
+
+				return context;
+			}
+
+			// HMAC (RFC 2104) over the EVP digest: H(K ^ opad, H(K ^ ipad, text))
+			basic_hash_hmac_sha256_streambuf::basic_hash_hmac_sha256_streambuf(const std::vector<unsigned char>& key)
+			{
+				unsigned char block[block_size] = {};
+				if (key.size() > block_size)
+				{
+					// Longer keys are hashed first
+					EVP_MD_CTX* key_context = create_digest_context(EVP_sha256());
+					unsigned int key_length = 0;
+					EVP_DigestUpdate(key_context, key.data(), key.size());
+					EVP_DigestFinal_ex(key_context, block, &key_length);
+					EVP_MD_CTX_destroy(key_context);
+				}
+				else if (!key.empty())
+				{
+					std::memcpy(block, key.data(), key.size());
+				}
+
+				m_context = create_digest_context(EVP_sha256());
+
+				unsigned char inner_pad[block_size];
+				for (size_t i = 0; i < block_size; ++i)
+				{
+					inner_pad[i] = block[i] ^ 0x36;
+					m_outer_pad[i] = block[i] ^ 0x5c;
+				}
+
+				int status = EVP_DigestUpdate(m_context, inner_pad, block_size);
+				OPENSSL_cleanse(block, block_size);
+				OPENSSL_cleanse(inner_pad, block_size);
+				if (status != 1)
+				{
+					EVP_MD_CTX_destroy(m_context);
+					throw std::runtime_error("EVP_DigestUpdate failed");
+				}
+			}
+
+			basic_hash_hmac_sha256_streambuf::~basic_hash_hmac_sha256_streambuf()
+			{
+				OPENSSL_cleanse(m_outer_pad, block_size);
+				EVP_MD_CTX_destroy(m_context);
+			}
+
+			pplx::task<void> basic_hash_hmac_sha256_streambuf::_close_write()
+			{
+				unsigned char inner_hash[EVP_MAX_MD_SIZE];
+				unsigned int inner_length = 0;
+				unsigned int hash_length = 0;
+				m_hash.resize(EVP_MAX_MD_SIZE);
+
+				if (EVP_DigestFinal_ex(m_context, inner_hash, &inner_length) != 1
+					|| EVP_DigestInit_ex(m_context, EVP_sha256(), nullptr) != 1
+					|| EVP_DigestUpdate(m_context, m_outer_pad, block_size) != 1
+					|| EVP_DigestUpdate(m_context, inner_hash, inner_length) != 1
+					|| EVP_DigestFinal_ex(m_context, m_hash.data(), &hash_length) != 1)
+				{
+					store_and_throw(std::make_exception_ptr(std::runtime_error("HMAC-SHA256 failed")));
+				}
+
+				m_hash.resize(hash_length);
+				return basic_hash_streambuf::_close_write();
+			}
+
+			pplx::task<basic_hash_hmac_sha256_streambuf::int_type> basic_hash_hmac_sha256_streambuf::_putc(basic_hash_hmac_sha256_streambuf::char_type ch)
+			{
+				return putn(&ch, 1).then([ch](size_t count) -> basic_hash_hmac_sha256_streambuf::int_type
+				{
+					return count ? (basic_hash_hmac_sha256_streambuf::int_type)ch : traits::eof();
+				});
+			}
+
+			pplx::task<size_t> basic_hash_hmac_sha256_streambuf::_putn(const basic_hash_hmac_sha256_streambuf::char_type* ptr, size_t count)
+			{
+				if (EVP_DigestUpdate(m_context, ptr, count) != 1)
+				{
+					store_and_throw(std::make_exception_ptr(std::runtime_error("EVP_DigestUpdate failed")));
+				}
+
+				return pplx::task_from_result(count);
+			}
+
+			basic_hash_md5_streambuf::basic_hash_md5_streambuf()
+			{
+				m_context = create_digest_context(EVP_md5());
+			}
+
+			basic_hash_md5_streambuf::~basic_hash_md5_streambuf()
+			{
+				EVP_MD_CTX_destroy(m_context);
+			}
+
+			pplx::task<void> basic_hash_md5_streambuf::_close_write()
+			{
+				unsigned int hash_length = 0;
+				m_hash.resize(EVP_MAX_MD_SIZE);
+				if (EVP_DigestFinal_ex(m_context, m_hash.data(), &hash_length) != 1)
+				{
+					store_and_throw(std::make_exception_ptr(std::runtime_error("MD5 failed")));
+				}
+
+				m_hash.resize(hash_length);
+				return basic_hash_streambuf::_close_write();
+			}
+
+			pplx::task<basic_hash_md5_streambuf::int_type> basic_hash_md5_streambuf::_putc(basic_hash_md5_streambuf::char_type ch)
+			{
+				return putn(&ch, 1).then([ch](size_t count) -> basic_hash_md5_streambuf::int_type
+				{
+					return count ? (basic_hash_md5_streambuf::int_type)ch : traits::eof();
+				});
+			}
+
+			pplx::task<size_t> basic_hash_md5_streambuf::_putn(const basic_hash_md5_streambuf::char_type* ptr, size_t count)
+			{
+				if (EVP_DigestUpdate(m_context, ptr, count) != 1)
+				{
+					store_and_throw(std::make_exception_ptr(std::runtime_error("EVP_DigestUpdate failed")));
+				}
+
+				return pplx::task_from_result(count);
+			}
+		}
+	}
+} // namespace azure::storage::core
+
+#endif // !WIN32
@@ -0,0 +1,64 @@
+#pragma once
+
+#ifdef BOLTMYSQL_DLL
+#define BOLTMYSQL_API __declspec( dllexport )
+#else
+#define BOLTMYSQL_API __declspec( dllimport )
+#endif
+
+#include <memory>
+#include <vector>
+#include <cpprest/asyncrt_utils.h>
+#include <mysql_table_entity.h>
+
+namespace bolt {
+	namespace storage {
+		namespace mysql {
+
+			/// <summary>
+			/// Writes many entities of one table with multi-row statements.
+			/// Entities with the same set of properties share one INSERT ... ON DUPLICATE KEY UPDATE,
+			/// so an existing row is merged as in <see cref="MysqlEntity::executeEntity"/>.
+			/// An entity whose RowKey is stored in another partition is not written and fails.
+			/// All statements run in one transaction.
+			/// </summary>
+			class MysqlBatch
+			{
+			public:
+				/// <summary>
+				/// Outcome of a single entity of the batch.
+				/// </summary>
+				struct Result
+				{
+					Result() : succeeded(false) {}
+
+					bool succeeded;
+					utility::string_t error;
+				};
+
+				BOLTMYSQL_API MysqlBatch(utility::string_t table_name);
+				BOLTMYSQL_API ~MysqlBatch();
+
+				/// <summary>
+				/// Queues an entity, it is written by execute().
+				/// </summary>
+				/// <param name="entity">The entity, it must have a PartitionKey and a RowKey.</param>
+				BOLTMYSQL_API void add(const mysql_table_entity& entity);
+
+				BOLTMYSQL_API size_t size() const;
+
+				/// <summary>
+				/// Writes the queued entities.
+				/// A failing statement is rolled back to its savepoint and fails only the entities it carried,
+				/// the rest of the batch is still committed.
+				/// </summary>
+				/// <returns>One result per entity, in the order they were added.</returns>
+				BOLTMYSQL_API std::vector<Result> execute();
+
+			private:
+				class MBImpl;
+				std::shared_ptr<MBImpl> bimpl;
+			};
+		}
+	}
+}
@@ -16,6 +16,7 @@
 #include <cppconn/metadata.h>
 #include <memory>
 #include <mutex>
+#include <mysql_pool.hpp>
 
 namespace bolt {
 	namespace storage {
@@ -30,13 +31,25 @@ namespace bolt {
 
 
 				/// <summary>
-				/// Return this instance of database connection.
+				/// Checks a connection out of the pool. The connection is returned when the lease goes out of scope,
+				/// so keep the lease alive for as long as statements and result sets created from it.
 				/// </summary>
 				/// <returns></returns>
-				BOLTMYSQL_API std::shared_ptr<sql::Connection> getConnection();
+				BOLTMYSQL_API MysqlConnectionLease acquire();
+
+				/// <summary>
+				/// Checkout and wait counters of the data pool.
+				/// </summary>
+				/// <returns></returns>
+				BOLTMYSQL_API MysqlPoolStatistics statistics();
+
+				/// <summary>
+				/// Drops cached prepared statements on all connections after a schema change.
+				/// </summary>
+				BOLTMYSQL_API void invalidateStatements();
 			private:
 
-				std::shared_ptr<sql::Connection> m_connection;
+				std::unique_ptr<MysqlConnectionPool> m_pool;
 
 				MysqlConnection(void);
 
@@ -47,14 +60,11 @@ namespace bolt {
 
 
 				/// <summary>
-				/// Gets the connection.
+				/// Creates the connection pool.
 				/// </summary>
-				/// <param name="host">The host.</param>
-				/// <param name="username">The username.</param>
-				/// <param name="password">The password.</param>
-				/// <param name="db">The database.</param>
+				/// <param name="options">The server, account, database and pool sizes.</param>
 				/// <returns></returns>
-				int setConnectionParams(std::string host, std::string username, std::string password, std::string db);
+				int setConnectionParams(const MysqlPoolOptions& options);
 
 			};
 		}
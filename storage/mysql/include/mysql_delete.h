@@ -9,6 +9,8 @@
 #include <cpprest/asyncrt_utils.h>
 #include <string>
 #include <logger.hpp>
+#include <vector>
+#include <mysql_property.h>
 
 namespace bolt {
 	namespace storage {
@@ -30,6 +32,12 @@ namespace bolt {
 				BOLTMYSQL_API MysqlDelete& andWhere(utility::string_t conditions);
 				BOLTMYSQL_API MysqlDelete& orWhere(utility::string_t conditions);
 
+				/// <summary>
+				/// Sets the values of the ? placeholders in the where clause, in order.
+				/// </summary>
+				/// <param name="parameters">The values.</param>
+				BOLTMYSQL_API MysqlDelete& bind(std::vector<mysql_property> parameters);
+
 			private:
 				class MDImpl;
 				std::shared_ptr<MDImpl> dimpl;
@@ -7,6 +7,12 @@
 #endif
 #include <memory>
 #include <cpprest/asyncrt_utils.h>
+#include <mysql_property.h>
+#include <mysql_table_entity.h>
+
+namespace sql {
+	class PreparedStatement;
+}
 
 namespace bolt  {
 	namespace storage {
@@ -86,18 +92,75 @@ namespace bolt  {
 				/// <param name="value">The value.</param>
 				/// <returns></returns>
 				BOLTMYSQL_API void insertTimestamp(utility::string_t property_name, utility::datetime value);
+
+				/// <summary>
+				/// Gets the entity with the properties inserted so far, e.g. to add it to a <see cref="MysqlBatch"/>.
+				/// </summary>
+				BOLTMYSQL_API const mysql_table_entity& tableEntity() const;
 				
+				/// <summary>
+				/// How an upsert treats a row that already has the entity's RowKey.
+				/// </summary>
+				enum class upsert_mode
+				{
+					/// <summary>
+					/// Overwrites the entity's properties and keeps the other columns of the row.
+					/// </summary>
+					merge,
+
+					/// <summary>
+					/// Replaces the whole row, columns missing from the entity become NULL.
+					/// </summary>
+					replace
+				};
+
+				/// <summary>
+				/// Inserts the entity or updates the existing row in a single statement.
+				/// RowKey is the table's primary key, so a row with the entity's RowKey in another partition
+				/// is left untouched and the upsert fails.
+				/// </summary>
+				/// <param name="mode">Merge or replace an existing row.</param>
+				/// <returns></returns>
+				BOLTMYSQL_API bool upsertEntity(upsert_mode mode);
+
 				/// <summary>
 				/// Add Entity to a Table
-				/// Executes the entity.
+				/// Executes the entity. An existing entity is merged.
 				/// </summary>
 				/// <returns></returns>
 				BOLTMYSQL_API bool executeEntity();
+
+				/// <summary>
+				/// Inserts the entity or replaces the existing one.
+				/// </summary>
+				/// <returns></returns>
 				BOLTMYSQL_API bool replaceEntity();
 				BOLTMYSQL_API bool patchEntity();
 				BOLTMYSQL_API bool entityExists(utility::string_t row_key, utility::string_t partition_key);
+
+				/// <summary>
+				/// Tells whether the last upsert created the row, rather than updating one that existed.
+				/// </summary>
+				/// <returns></returns>
+				BOLTMYSQL_API bool inserted() const;
 				BOLTMYSQL_API bool abort();
 
+				/// <summary>
+				/// Binds a property value to a statement parameter according to its type.
+				/// </summary>
+				/// <param name="statement">The prepared statement.</param>
+				/// <param name="index">The 1-based parameter index.</param>
+				/// <param name="property">The property value.</param>
+				static void bindProperty(sql::PreparedStatement *statement, int index, const mysql_property& property);
+
+				/// <summary>
+				/// Builds an ON DUPLICATE KEY UPDATE assignment that only applies when the existing row
+				/// is in the inserted row's partition, other partitions keep their value.
+				/// </summary>
+				/// <param name="column">The quoted column name.</param>
+				/// <param name="value">The new value, e.g. VALUES(column).</param>
+				static std::string samePartitionUpdate(const std::string& column, const std::string& value);
+
 			};
 		}
 	}
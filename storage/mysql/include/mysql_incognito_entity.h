@@ -1,5 +1,5 @@
 #pragma once
-#include <mysql_property.h>
+#include <mysql_property_map.h>
 
 namespace bolt
 {
@@ -14,8 +14,8 @@ namespace bolt
 			{
 			public:
 
-				typedef std::unordered_map<utility::string_t, mysql::mysql_property> properties_type;
-				typedef std::unordered_map<utility::string_t, mysql::mysql_property>::value_type property_type;
+				typedef mysql_property_map properties_type;
+				typedef mysql_property_map::value_type property_type;
 
 				/// <summary>
 				/// Initializes a new instance of the <see cref="mysql::storage::mysql_table_entity"/> class.
@@ -38,6 +38,8 @@ namespace bolt
 			const utility::string_t double_negative_infinity(U("-Infinity"));
 			/// <summary>
 			/// Class for storing information about a single property in an entity in a table.
+			/// Numbers, booleans and date/times are held in place and read back as they were set,
+			/// only strings and byte arrays (as base64) use the string, whose small-string buffer keeps short ones inline.
 			/// </summary>
 			class mysql_property
 			{
@@ -48,7 +50,7 @@ namespace bolt
 				/// Initializes a new instance of the <see cref="entity_property"/> class.
 				/// </summary>
 				mysql_property()
-					: m_property_type(myedm_type::string), m_is_null(true)
+					: m_property_type(myedm_type::string), m_is_null(true), m_integer(0)
 				{
 				}
 
@@ -57,7 +59,7 @@ namespace bolt
 				/// </summary>
 				/// <param name="value">A byte array.</param>
 				mysql_property(const std::vector<uint8_t>& value)
-					: m_property_type(myedm_type::binary), m_is_null(false)
+					: m_property_type(myedm_type::binary), m_is_null(false), m_integer(0)
 				{
 					set_value_impl(value);
 				}
@@ -127,7 +129,7 @@ namespace bolt
 				/// </summary>
 				/// <param name="value">A string value.</param>
 				mysql_property(utility::string_t value)
-					: m_property_type(myedm_type::string), m_is_null(false), m_value(move(value))
+					: m_property_type(myedm_type::string), m_is_null(false), m_integer(0), m_value(move(value))
 				{
 				}
 
@@ -136,7 +138,7 @@ namespace bolt
 				/// </summary>
 				/// <param name="value">A string value.</param>
 				mysql_property(const utility::char_t* value)
-					: m_property_type(myedm_type::string), m_is_null(false)
+					: m_property_type(myedm_type::string), m_is_null(false), m_integer(0)
 				{
 					set_value_impl(value);
 				}
@@ -156,7 +158,12 @@ namespace bolt
 				/// <param name="property_type">An <see cref="edm_type" /> object indicating the property type.</param>
 				void set_property_type(myedm_type property_type)
 				{
-					m_property_type = property_type;
+					if (m_property_type != property_type)
+					{
+						//Keep the value as text, the getters parse it as the new type
+						m_value = str();
+						m_property_type = property_type;
+					}
 				}
 
 				/// <summary>
@@ -259,6 +266,8 @@ namespace bolt
 				/// <param name="value">The byte array value.</param>
 				void set_value(const std::vector<uint8_t>& value)
 				{
+					m_property_type = myedm_type::binary;
+					m_is_null = false;
 					set_value_impl(value);
 				}
 
@@ -344,6 +353,7 @@ namespace bolt
 				{
 					m_property_type = myedm_type::string;
 					m_is_null = false;
+					m_integer = 0;
 					m_value = move(value);
 				}
 
@@ -361,11 +371,8 @@ namespace bolt
 				/// <summary>
 				/// Returns the value of the <see cref="entity_property"/> object as a string.
 				/// </summary>
-				/// <returns>A string containing the property value.</returns>
-				const utility::string_t& str() const
-				{
-					return m_value;
-				}
+				/// <returns>A string containing the property value, formatted when it is not a string.</returns>
+				BOLTMYSQL_API utility::string_t str() const;
 
 			private:
 
@@ -376,33 +383,62 @@ namespace bolt
 
 				void set_value_impl(bool value)
 				{
-					m_value = value ? U("true") : U("false");
+					m_boolean = value;
+					m_value.clear();
 				}
 
 				void set_value_impl(utility::datetime value)
 				{
-					m_value = value.to_string(utility::datetime::ISO_8601);
+					m_datetime = value.to_interval();
+					m_value.clear();
 				}
 
-				BOLTMYSQL_API void set_value_impl(double value);
+				void set_value_impl(double value)
+				{
+					m_double = value;
+					m_value.clear();
+				}
 
-				BOLTMYSQL_API void set_value_impl(long double value);
+				void set_value_impl(long double value)
+				{
+					m_double = static_cast<double>(value);
+					m_value.clear();
+				}
 				/*void set_value_impl(const utility::uuid& value)
 				{
 				m_value = utility::uuid_to_string(value);
 				}*/
 
-				BOLTMYSQL_API void set_value_impl(int32_t value);
+				void set_value_impl(int32_t value)
+				{
+					m_integer = value;
+					m_value.clear();
+				}
 
-				BOLTMYSQL_API void set_value_impl(int64_t value);
+				void set_value_impl(int64_t value)
+				{
+					m_integer = value;
+					m_value.clear();
+				}
 
 				void set_value_impl(const utility::char_t * value)
 				{
+					m_integer = 0;
 					m_value = value;
 				}
 
 				myedm_type m_property_type;
 				bool m_is_null;
+				//The value, by m_property_type
+				union
+				{
+					bool m_boolean;
+					//int32 and int64
+					int64_t m_integer;
+					double m_double;
+					utility::datetime::interval_type m_datetime;
+				};
+				//string, binary as base64 and guid
 				utility::string_t m_value;
 			};
 		}
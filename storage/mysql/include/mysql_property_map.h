@@ -0,0 +1,147 @@
+#pragma once
+#include <algorithm>
+#include <utility>
+#include <vector>
+#include <mysql_property.h>
+
+namespace bolt
+{
+	namespace storage
+	{
+		namespace mysql
+		{
+			/// <summary>
+			/// The properties of an entity, indexed by property name.
+			/// An entity has a handful of properties, so they are kept in one vector sorted by name:
+			/// one allocation per entity, and a binary search over a few contiguous entries to find one.
+			/// Iteration is in name order. The names must not be changed through an iterator.
+			/// </summary>
+			class mysql_property_map
+			{
+			public:
+
+				typedef utility::string_t key_type;
+				typedef mysql_property mapped_type;
+				typedef std::pair<utility::string_t, mysql_property> value_type;
+				typedef std::vector<value_type>::iterator iterator;
+				typedef std::vector<value_type>::const_iterator const_iterator;
+				typedef std::vector<value_type>::size_type size_type;
+
+				iterator begin()
+				{
+					return m_properties.begin();
+				}
+
+				iterator end()
+				{
+					return m_properties.end();
+				}
+
+				const_iterator begin() const
+				{
+					return m_properties.begin();
+				}
+
+				const_iterator end() const
+				{
+					return m_properties.end();
+				}
+
+				const_iterator cbegin() const
+				{
+					return m_properties.cbegin();
+				}
+
+				const_iterator cend() const
+				{
+					return m_properties.cend();
+				}
+
+				size_type size() const
+				{
+					return m_properties.size();
+				}
+
+				bool empty() const
+				{
+					return m_properties.empty();
+				}
+
+				void clear()
+				{
+					m_properties.clear();
+				}
+
+				void reserve(size_type count)
+				{
+					m_properties.reserve(count);
+				}
+
+				iterator find(const key_type &key)
+				{
+					iterator it = lower_bound(key);
+					return it != m_properties.end() && it->first == key ? it : m_properties.end();
+				}
+
+				const_iterator find(const key_type &key) const
+				{
+					return const_cast<mysql_property_map*>(this)->find(key);
+				}
+
+				size_type count(const key_type &key) const
+				{
+					return find(key) != end() ? 1 : 0;
+				}
+
+				/// <summary>
+				/// Adds a property, unless one with the same name is already there.
+				/// </summary>
+				/// <returns>The property with the name, and whether it was added.</returns>
+				std::pair<iterator, bool> insert(value_type value)
+				{
+					iterator it = lower_bound(value.first);
+					if (it != m_properties.end() && it->first == value.first)
+					{
+						return std::make_pair(it, false);
+					}
+					return std::make_pair(m_properties.insert(it, std::move(value)), true);
+				}
+
+				mapped_type& operator[](const key_type &key)
+				{
+					iterator it = lower_bound(key);
+					if (it == m_properties.end() || it->first != key)
+					{
+						it = m_properties.insert(it, value_type(key, mapped_type()));
+					}
+					return it->second;
+				}
+
+				iterator erase(const_iterator position)
+				{
+					return m_properties.erase(m_properties.begin() + (position - m_properties.cbegin()));
+				}
+
+				size_type erase(const key_type &key)
+				{
+					iterator it = find(key);
+					if (it == m_properties.end())
+					{
+						return 0;
+					}
+					m_properties.erase(it);
+					return 1;
+				}
+
+			private:
+				iterator lower_bound(const key_type &key)
+				{
+					return std::lower_bound(m_properties.begin(), m_properties.end(), key,
+						[](const value_type &property, const key_type &name) { return property.first < name; });
+				}
+
+				std::vector<value_type> m_properties;
+			};
+		}
+	}
+}
@@ -6,13 +6,14 @@
 #define BOLTMYSQL_API __declspec( dllimport )
 #endif
 
-#include <deque>
+#include <functional>
 #include <vector>
 #include <map>
 #include <string>
 #include <cpprest/asyncrt_utils.h>
 #include <logger.hpp>
 #include <mysql_result.h>
+#include <mysql_result_set.h>
 #include <mysql_table_entity.h>
 
 namespace bolt  {
@@ -47,9 +48,33 @@ namespace bolt  {
 				BOLTMYSQL_API MysqlQuery& offset(utility::string_t offset);
 				BOLTMYSQL_API MysqlQuery& munion(utility::string_t sql);
 
+				/// <summary>
+				/// Sets the values of the ? placeholders in the query, in order.
+				/// A query with parameters runs as a prepared statement from the connection's cache.
+				/// </summary>
+				/// <param name="parameters">The values.</param>
+				BOLTMYSQL_API MysqlQuery& bind(std::vector<mysql_property> parameters);
 
-				BOLTMYSQL_API std::deque<mysql_table_entity> filterByKey(utility::string_t partition_key, utility::string_t row_key);
-				BOLTMYSQL_API std::deque<mysql_table_entity> queryAll();
+
+				/// <summary>
+				/// Runs the query for the entity with the given keys.
+				/// </summary>
+				/// <returns>The matching rows, empty when the query failed.</returns>
+				BOLTMYSQL_API mysql_result_set filterByKey(utility::string_t partition_key, utility::string_t row_key);
+
+				/// <summary>
+				/// Runs the query and reads the whole result, stored by column.
+				/// </summary>
+				/// <returns>The rows, empty when the query failed.</returns>
+				BOLTMYSQL_API mysql_result_set queryAll();
+
+				/// <summary>
+				/// Runs the query and hands each row to callback as it arrives from the server,
+				/// without keeping the result in memory. The entity is reused for the next row.
+				/// </summary>
+				/// <param name="callback">Called for every row, returns false to stop reading.</param>
+				/// <returns>false when the query failed.</returns>
+				BOLTMYSQL_API bool queryEach(std::function<bool(const mysql_table_entity&)> callback);
 				
 			private:
 				class MQImpl;
@@ -0,0 +1,324 @@
+#pragma once
+
+#ifdef BOLTMYSQL_DLL
+#define BOLTMYSQL_API __declspec( dllexport )
+#else
+#define BOLTMYSQL_API __declspec( dllimport )
+#endif
+
+#include <cstddef>
+#include <iterator>
+#include <vector>
+#include <mysql_table_entity.h>
+
+namespace sql
+{
+	class ResultSet;
+	class ResultSetMetaData;
+}
+
+namespace bolt
+{
+	namespace storage
+	{
+		namespace mysql
+		{
+			/// <summary>
+			/// The rows of a query, stored by column.
+			/// The column names and types are read from the result metadata once per query, every row only adds its values:
+			/// integers and doubles to one vector per column, strings and keys to a single text buffer shared by the whole result.
+			/// A string equal to the one above it in the same column is stored once.
+			/// </summary>
+			class mysql_result_set
+			{
+			public:
+
+				/// <summary>
+				/// Where a column of a MySQL result goes, worked out from the result metadata.
+				/// </summary>
+				struct field
+				{
+					enum kind { property, partition_key, row_key, timestamp };
+
+					//Position in the MySQL result, from 1
+					int index;
+					kind target;
+					//The type of a property, as readRow has always mapped it from the MySQL type
+					myedm_type type;
+					utility::string_t name;
+				};
+
+				/// <summary>
+				/// Reads the fields of a result. NULL and unknown columns are left out,
+				/// as is a property whose name was already taken by an earlier column.
+				/// </summary>
+				/// <param name="meta">The metadata of the result.</param>
+				BOLTMYSQL_API static std::vector<field> describe(sql::ResultSetMetaData *meta);
+
+				/// <summary>
+				/// Reads every remaining row of res.
+				/// </summary>
+				/// <param name="res">A result set positioned before its first row.</param>
+				BOLTMYSQL_API static mysql_result_set read(sql::ResultSet &res);
+
+				/// <summary>
+				/// A string of the result, a range of its text buffer.
+				/// </summary>
+				struct text_range
+				{
+					size_t offset;
+					size_t length;
+				};
+
+				/// <summary>
+				/// An entity property column.
+				/// </summary>
+				class column
+				{
+				public:
+					const utility::string_t& name() const
+					{
+						return m_name;
+					}
+
+					myedm_type type() const
+					{
+						return m_type;
+					}
+
+				private:
+					friend class mysql_result_set;
+
+					utility::string_t m_name;
+					myedm_type m_type;
+					//One of these holds the values, by type
+					std::vector<int64_t> m_integers;
+					std::vector<double> m_doubles;
+					std::vector<text_range> m_strings;
+				};
+
+				/// <summary>
+				/// One row, a view into the result set. It stays valid as long as the result set.
+				/// </summary>
+				class row
+				{
+				public:
+					row(const mysql_result_set *result, size_t index)
+						: m_result(result), m_index(index)
+					{
+					}
+
+					/// <summary>
+					/// Gets the number of properties, the same for every row.
+					/// </summary>
+					size_t size() const
+					{
+						return m_result->m_columns.size();
+					}
+
+					const utility::string_t& name(size_t property) const
+					{
+						return m_result->m_columns[property].m_name;
+					}
+
+					myedm_type type(size_t property) const
+					{
+						return m_result->m_columns[property].m_type;
+					}
+
+					int32_t int32_value(size_t property) const
+					{
+						return static_cast<int32_t>(m_result->m_columns[property].m_integers[m_index]);
+					}
+
+					int64_t int64_value(size_t property) const
+					{
+						return m_result->m_columns[property].m_integers[m_index];
+					}
+
+					double double_value(size_t property) const
+					{
+						return m_result->m_columns[property].m_doubles[m_index];
+					}
+
+					utility::string_t string_value(size_t property) const
+					{
+						return m_result->text(m_result->m_columns[property].m_strings[m_index]);
+					}
+
+					/// <summary>
+					/// Gets a property as a <see cref="mysql_property"/>, which holds numbers as they are.
+					/// </summary>
+					mysql_property property(size_t index) const
+					{
+						switch (type(index))
+						{
+						case myedm_type::int32:
+							return mysql_property(int32_value(index));
+						case myedm_type::int64:
+							return mysql_property(int64_value(index));
+						case myedm_type::double_floating_point:
+							return mysql_property(double_value(index));
+						default:
+							return mysql_property(string_value(index));
+						}
+					}
+
+					utility::string_t partition_key() const
+					{
+						return m_result->text(m_result->m_partition_keys[m_index]);
+					}
+
+					utility::string_t row_key() const
+					{
+						return m_result->text(m_result->m_row_keys[m_index]);
+					}
+
+					utility::datetime timestamp() const
+					{
+						return utility::datetime() + m_result->m_timestamps[m_index];
+					}
+
+					/// <summary>
+					/// Copies the row into a <see cref="mysql_table_entity"/>.
+					/// </summary>
+					mysql_table_entity to_entity() const
+					{
+						mysql_table_entity entity(partition_key(), row_key());
+						entity.set_timestamp(timestamp());
+						for (size_t i = 0; i < size(); ++i)
+						{
+							entity.add_property(name(i), property(i));
+						}
+						return entity;
+					}
+
+				private:
+					const mysql_result_set *m_result;
+					size_t m_index;
+				};
+
+				class const_iterator
+				{
+				public:
+					typedef std::forward_iterator_tag iterator_category;
+					typedef row value_type;
+					typedef std::ptrdiff_t difference_type;
+					typedef const row* pointer;
+					typedef row reference;
+
+					const_iterator(const mysql_result_set *result, size_t index)
+						: m_row(result, index), m_result(result), m_index(index)
+					{
+					}
+
+					row operator*() const
+					{
+						return row(m_result, m_index);
+					}
+
+					const row* operator->() const
+					{
+						m_row = row(m_result, m_index);
+						return &m_row;
+					}
+
+					const_iterator& operator++()
+					{
+						++m_index;
+						return *this;
+					}
+
+					const_iterator operator++(int)
+					{
+						const_iterator previous = *this;
+						++m_index;
+						return previous;
+					}
+
+					bool operator==(const const_iterator &other) const
+					{
+						return m_index == other.m_index && m_result == other.m_result;
+					}
+
+					bool operator!=(const const_iterator &other) const
+					{
+						return !(*this == other);
+					}
+
+				private:
+					mutable row m_row;
+					const mysql_result_set *m_result;
+					size_t m_index;
+				};
+
+				mysql_result_set()
+					: m_size(0)
+				{
+				}
+
+				/// <summary>
+				/// Gets the number of rows.
+				/// </summary>
+				size_t size() const
+				{
+					return m_size;
+				}
+
+				bool empty() const
+				{
+					return m_size == 0;
+				}
+
+				/// <summary>
+				/// Gets the entity property columns, in select order.
+				/// </summary>
+				const std::vector<column>& columns() const
+				{
+					return m_columns;
+				}
+
+				row operator[](size_t index) const
+				{
+					return row(this, index);
+				}
+
+				const_iterator begin() const
+				{
+					return const_iterator(this, 0);
+				}
+
+				const_iterator end() const
+				{
+					return const_iterator(this, m_size);
+				}
+
+				const_iterator cbegin() const
+				{
+					return begin();
+				}
+
+				const_iterator cend() const
+				{
+					return end();
+				}
+
+			private:
+				utility::string_t text(const text_range &range) const
+				{
+					return m_text.substr(range.offset, range.length);
+				}
+
+				//Adds value to the text buffer, unless it is the last string of cells
+				text_range intern(const std::vector<text_range> &cells, const utility::string_t &value);
+
+				std::vector<column> m_columns;
+				std::vector<text_range> m_partition_keys;
+				std::vector<text_range> m_row_keys;
+				std::vector<utility::datetime::interval_type> m_timestamps;
+				utility::string_t m_text;
+				size_t m_size;
+			};
+		}
+	}
+}
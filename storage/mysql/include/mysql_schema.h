@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cpprest/asyncrt_utils.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace bolt {
+	namespace storage {
+		namespace mysql {
+
+			/// <summary>
+			/// Cache of the columns of each MySQL table, so writes do not run SHOW COLUMNS.
+			/// A table is read once, updated in place when columns are added, and dropped
+			/// when the table is deleted. Tables are keyed by their exact name, as MySQL
+			/// table names are case sensitive on most platforms.
+			/// </summary>
+			class MysqlSchema
+			{
+			public:
+				/// <summary>
+				/// Column types indexed by lower-cased column name, MySQL column names are case insensitive.
+				/// </summary>
+				typedef std::unordered_map<utility::string_t, std::string> columns_type;
+
+				virtual ~MysqlSchema() {}
+				static MysqlSchema& get_instance();
+
+				/// <summary>
+				/// Returns the columns of a table, reading them on the first use.
+				/// </summary>
+				/// <param name="table_name">The table name.</param>
+				/// <returns>nullptr when the columns could not be read.</returns>
+				std::shared_ptr<const columns_type> getColumns(const utility::string_t& table_name);
+
+				/// <summary>
+				/// Records columns added by ALTER TABLE.
+				/// </summary>
+				/// <param name="table_name">The table name.</param>
+				/// <param name="columns">Column names and their SQL types.</param>
+				void addColumns(const utility::string_t& table_name, const std::vector<std::pair<utility::string_t, std::string>>& columns);
+
+				/// <summary>
+				/// Forgets a table, it is read again on the next use.
+				/// </summary>
+				/// <param name="table_name">The table name.</param>
+				void invalidate(const utility::string_t& table_name);
+
+				/// <summary>
+				/// Key of a column name in a columns_type map.
+				/// </summary>
+				static utility::string_t key(const utility::string_t& name);
+
+			private:
+				static const int max_load_attempts = 3;
+
+				struct Table
+				{
+					Table() : generation(0) {}
+
+					//Null until read, and again after invalidate()
+					std::shared_ptr<const columns_type> columns;
+					//Bumped by every schema change, a load that started under an older value is discarded
+					unsigned long generation;
+				};
+
+				MysqlSchema(void) {}
+
+				MysqlSchema(const MysqlSchema& src);
+				MysqlSchema &operator=(const MysqlSchema& rhs);
+				static std::unique_ptr<MysqlSchema> m_instance;
+				static std::once_flag m_instance_flag;
+
+				std::mutex m_mutex;
+				//Column maps are never modified once published, updates replace the whole map
+				std::unordered_map<utility::string_t, Table> m_tables;
+			};
+		}
+	}
+}
@@ -27,6 +27,7 @@ namespace bolt {
 				string_t m_table_name;
 
 				static std::vector<mysql_incognito_entity> innerMaintananceQuery(string_t sql);
+				static std::string columnType(myedm_type datatype);
 			public:
 				BOLTMYSQL_API MysqlTable();
 				BOLTMYSQL_API MysqlTable(string_t table_name);
@@ -36,6 +37,15 @@ namespace bolt {
 				BOLTMYSQL_API static std::vector<string_t> getColumns(string_t table_name);
 				BOLTMYSQL_API static bool createColumn(string_t table_name, string_t column_name, myedm_type datatype);
 				BOLTMYSQL_API static bool hasColumn(string_t table_name, string_t column_name);
+
+				/// <summary>
+				/// Adds every property that has no column yet, in a single ALTER TABLE.
+				/// The columns are looked up in the schema cache, so nothing is sent to MySQL when all exist.
+				/// </summary>
+				/// <param name="table_name">The table name.</param>
+				/// <param name="properties">The properties of the entity about to be written.</param>
+				/// <returns>true when all properties have a column.</returns>
+				BOLTMYSQL_API static bool createColumns(string_t table_name, const mysql_table_entity::properties_type& properties);
 				
 				
 				BOLTMYSQL_API static std::vector<mysql_incognito_entity> analyzeTable(string_t table_name);
@@ -0,0 +1,277 @@
+#include <mysql_batch.h>
+#include <mysql_connection.h>
+#include <mysql_entity.h>
+#include <mysql_table.h>
+#include <mysql_schema.h>
+#include <logger.hpp>
+#include <algorithm>
+#include <map>
+
+namespace bolt
+{
+	namespace storage
+	{
+		namespace mysql
+		{
+			//MySQL refuses statements with more than 65535 placeholders
+			static const size_t max_batch_placeholders = 65535;
+			static const size_t max_batch_rows = 500;
+
+			class MysqlBatch::MBImpl
+			{
+			public:
+				string_t table_name;
+				std::vector<mysql_table_entity> entities;
+
+				/// <summary>
+				/// Builds the INSERT for rows entities sharing the given columns.
+				/// </summary>
+				std::string insertQuery(const std::vector<string_t>& columns, size_t rows) const
+				{
+					std::string c_columns;
+					std::string c_updates;
+					for (const auto& column : columns)
+					{
+						std::string name = "`" + conversions::to_utf8string(column) + "`";
+						c_columns += name + ",";
+						c_updates += MysqlEntity::samePartitionUpdate(name, "VALUES(" + name + ")") + ",";
+					}
+					c_columns += "PartitionKey,RowKey";
+					//Keeps the clause valid for entities without properties
+					c_updates += "PartitionKey = PartitionKey";
+
+					std::string row = "(";
+					for (size_t i = 0; i < columns.size(); ++i)
+					{
+						row += "?,";
+					}
+					row += "?,?)";
+
+					std::string query = "INSERT INTO " + conversions::to_utf8string(table_name) + "(" + c_columns + ") VALUES";
+					query.reserve(query.size() + rows * (row.size() + 1) + c_updates.size() + 32);
+					for (size_t i = 0; i < rows; ++i)
+					{
+						query += i == 0 ? row : "," + row;
+					}
+					query += " ON DUPLICATE KEY UPDATE " + c_updates;
+					return query;
+				}
+
+				/// <summary>
+				/// Builds the SELECT of the partitions that hold rows RowKeys.
+				/// </summary>
+				std::string partitionsQuery(size_t rows) const
+				{
+					std::string query = "SELECT RowKey, PartitionKey FROM " + conversions::to_utf8string(table_name) + " WHERE RowKey IN (";
+					for (size_t i = 0; i < rows; ++i)
+					{
+						query += i == 0 ? "?" : ",?";
+					}
+					query += ")";
+					return query;
+				}
+
+				/// <summary>
+				/// Marks the rows of a chunk whose RowKey is stored in another partition as failed.
+				/// The guarded ON DUPLICATE KEY UPDATE left those rows untouched.
+				/// </summary>
+				void checkPartitions(MysqlConnectionLease& connection, const std::vector<size_t>& members, size_t first, size_t rows, bool cached, std::vector<Result>& results) const
+				{
+					std::string query = partitionsQuery(rows);
+					std::unique_ptr<sql::PreparedStatement> owned;
+					sql::PreparedStatement *pre_statmt;
+					if (cached)
+					{
+						pre_statmt = connection.prepareStatement(query);
+					}
+					else
+					{
+						owned.reset(connection->prepareStatement(query));
+						pre_statmt = owned.get();
+					}
+
+					for (size_t row = 0; row < rows; ++row)
+					{
+						pre_statmt->setString(static_cast<unsigned int>(row + 1), conversions::to_utf8string(entities[members[first + row]].row_key()));
+					}
+
+					//Keys compare case-insensitively, as in MySQL
+					std::map<string_t, string_t> stored;
+					std::unique_ptr<sql::ResultSet> res(pre_statmt->executeQuery());
+					while (res->next())
+					{
+						stored[MysqlSchema::key(conversions::to_string_t(res->getString(1)))] = MysqlSchema::key(conversions::to_string_t(res->getString(2)));
+					}
+
+					for (size_t row = first; row < first + rows; ++row)
+					{
+						const mysql_table_entity& entity = entities[members[row]];
+						auto iter = stored.find(MysqlSchema::key(entity.row_key()));
+						if (iter != stored.end() && iter->second != MysqlSchema::key(entity.partition_key()))
+						{
+							results[members[row]].succeeded = false;
+							results[members[row]].error = U("The RowKey is used by another partition");
+						}
+					}
+				}
+			};
+
+			MysqlBatch::MysqlBatch(string_t table_name) : bimpl{ new MBImpl }
+			{
+				bimpl->table_name = table_name;
+			}
+
+			MysqlBatch::~MysqlBatch()
+			{
+			}
+
+			void MysqlBatch::add(const mysql_table_entity& entity)
+			{
+				bimpl->entities.push_back(entity);
+			}
+
+			size_t MysqlBatch::size() const
+			{
+				return bimpl->entities.size();
+			}
+
+			std::vector<MysqlBatch::Result> MysqlBatch::execute()
+			{
+				std::vector<Result> results(bimpl->entities.size());
+				if (bimpl->entities.empty())
+					return results;
+
+				//Group entity indexes by their sorted column names
+				std::map<std::vector<string_t>, std::vector<size_t>> groups;
+				mysql_table_entity::properties_type all_columns;
+				for (size_t i = 0; i < bimpl->entities.size(); ++i)
+				{
+					std::vector<string_t> columns;
+					columns.reserve(bimpl->entities[i].properties().size());
+					for (const auto& property : bimpl->entities[i].properties())
+					{
+						columns.push_back(property.first);
+						all_columns.insert(property);
+					}
+					std::sort(columns.begin(), columns.end());
+					groups[columns].push_back(i);
+				}
+
+				//ALTER TABLE commits implicitly, so columns are added before the transaction starts
+				if (!MysqlTable::createColumns(bimpl->table_name, all_columns))
+				{
+					for (auto& result : results)
+					{
+						result.error = U("Could not add the entity columns to the table");
+					}
+					return results;
+				}
+
+				try
+				{
+					MysqlConnectionLease connection = MysqlConnection::get_instance().acquire();
+					connection->setAutoCommit(false);
+
+					try
+					{
+						for (const auto& group : groups)
+						{
+							const std::vector<string_t>& columns = group.first;
+							const std::vector<size_t>& members = group.second;
+							const size_t chunk_rows = std::max<size_t>(1, std::min(max_batch_rows, max_batch_placeholders / (columns.size() + 2)));
+
+							for (size_t first = 0; first < members.size(); first += chunk_rows)
+							{
+								const size_t rows = std::min(chunk_rows, members.size() - first);
+
+								//Full chunks repeat across requests and are worth caching, the remainder is not
+								std::string query = bimpl->insertQuery(columns, rows);
+								std::unique_ptr<sql::PreparedStatement> owned;
+								sql::PreparedStatement *pre_statmt;
+								if (rows == chunk_rows)
+								{
+									pre_statmt = connection.prepareStatement(query);
+								}
+								else
+								{
+									owned.reset(connection->prepareStatement(query));
+									pre_statmt = owned.get();
+								}
+
+								int index = 1;
+								for (size_t row = first; row < first + rows; ++row)
+								{
+									const mysql_table_entity& entity = bimpl->entities[members[row]];
+									for (const auto& column : columns)
+									{
+										MysqlEntity::bindProperty(pre_statmt, index++, entity.properties().find(column)->second);
+									}
+									pre_statmt->setString(index++, conversions::to_utf8string(entity.partition_key()));
+									pre_statmt->setString(index++, conversions::to_utf8string(entity.row_key()));
+								}
+
+								std::unique_ptr<sql::Savepoint> savepoint(connection->setSavepoint("bolt_batch"));
+								bool succeeded = true;
+								string_t error;
+								try
+								{
+									pre_statmt->execute();
+									connection->releaseSavepoint(savepoint.get());
+								}
+								catch (sql::SQLException& e)
+								{
+									connection->rollback(savepoint.get());
+									succeeded = false;
+									error = conversions::to_string_t(e.what());
+								}
+
+								for (size_t row = first; row < first + rows; ++row)
+								{
+									results[members[row]].succeeded = succeeded;
+									results[members[row]].error = error;
+								}
+
+								if (succeeded)
+								{
+									bimpl->checkPartitions(connection, members, first, rows, rows == chunk_rows, results);
+								}
+							}
+						}
+
+						connection->commit();
+						connection->setAutoCommit(true);
+						connection.done();
+					}
+					catch (sql::SQLException&)
+					{
+						//Do not hand the connection out again inside the transaction
+						try
+						{
+							connection->rollback();
+							connection->setAutoCommit(true);
+						}
+						catch (sql::SQLException&)
+						{
+							connection.invalidate();
+						}
+						throw;
+					}
+				}
+				catch (sql::SQLException& e)
+				{
+					BoltLog logger;
+					logger << BoltLog::LOG_ERROR << "SQLException in MysqlBatch "
+						<< "(execute) #ERR: " << e.what() << " (MySQL error code: "
+						<< e.getErrorCode() << ", SQLState: " << e.getSQLState() << " )";
+
+					for (auto& result : results)
+					{
+						result.succeeded = false;
+						result.error = conversions::to_string_t(e.what());
+					}
+				}
+				return results;
+			}
+		}
+	}
+}
@@ -1,4 +1,5 @@
 #include <mysql_connection.h>
+#include <configuration.hpp>
 
 namespace bolt {
 	namespace storage {
@@ -14,24 +15,46 @@ namespace bolt {
 
 			MysqlConnection::MysqlConnection()
 			{
-				setConnectionParams("localhost", "root", "knight", "boltdata");
+				Config &config = Config::getInstance();
+
+				//The server and account are shared with the auth pool, the database is its own
+				MysqlPoolOptions options;
+				options.host = config.getStdConfigOption(Config::mysql_host);
+				options.port = config.getNumberOption(Config::mysql_port, 1, 65535);
+				options.user = config.getStdConfigOption(Config::mysql_user);
+				options.password = config.getStdConfigOption(Config::mysql_password);
+				options.schema = config.getStdConfigOption(Config::data_pool_database);
+
+				options.max_size = config.getNumberOption(Config::data_pool_max_size, 1, 1024);
+				options.min_size = config.getNumberOption(Config::data_pool_min_size, 0, options.max_size);
+				options.wait_timeout = std::chrono::milliseconds(config.getNumberOption(Config::data_pool_wait_timeout, 0, 10 * 60 * 1000));
+				options.idle_timeout = std::chrono::seconds(config.getNumberOption(Config::data_pool_idle_timeout, 0, 24 * 60 * 60));
+
+				setConnectionParams(options);
 			}
 
-			int MysqlConnection::setConnectionParams(std::string host, std::string username, std::string password, std::string db){
-				sql::Driver* m_driver = get_driver_instance();
-				m_connection = std::shared_ptr<sql::Connection>(m_driver->connect(host, username, password));
-				/* Connect to the MySQL test database */
-				m_connection->setSchema(db);
+			int MysqlConnection::setConnectionParams(const MysqlPoolOptions& options){
+				m_pool.reset(new MysqlConnectionPool(options));
 				return 0;
 			}
 
 			/// <summary>
-			/// Returns the connection.
+			/// Checks a connection out of the pool.
 			/// </summary>
 			/// <returns></returns>
-			std::shared_ptr<sql::Connection> MysqlConnection::getConnection()
+			MysqlConnectionLease MysqlConnection::acquire()
+			{
+				return m_pool->acquire();
+			}
+
+			MysqlPoolStatistics MysqlConnection::statistics()
+			{
+				return m_pool->statistics();
+			}
+
+			void MysqlConnection::invalidateStatements()
 			{
-				return m_connection;
+				m_pool->invalidateStatements();
 			}
 		}
 	}
@@ -17,8 +17,8 @@ namespace bolt
 				std::vector<mysql_incognito_entity> entites;
 
 				try {
-					MysqlConnection &connection = MysqlConnection::get_instance();
-					std::unique_ptr<sql::PreparedStatement> stmt(connection.getConnection()->prepareStatement(conversions::to_utf8string(sql)));
+					MysqlConnectionLease connection = MysqlConnection::get_instance().acquire();
+					std::unique_ptr<sql::PreparedStatement> stmt(connection->prepareStatement(conversions::to_utf8string(sql)));
 					std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
 
 					//vector<map<string,string>> data;
@@ -41,6 +41,7 @@ namespace bolt
 						mysql_incognito_entity incoent(property_type);
 						entites.push_back(incoent);
 					}
+					connection.done();
 				}
 				catch (sql::SQLException &e)
 				{
@@ -1,5 +1,6 @@
 #include <mysql_delete.h>
 #include <mysql_connection.h>
+#include <mysql_entity.h>
 
 namespace bolt {
 	namespace storage {
@@ -13,6 +14,7 @@ namespace bolt {
 				std::vector<utility::string_t> sfields;
 
 				std::map<utility::string_t, utility::string_t> m_query;
+				std::vector<mysql_property> m_parameters;
 
 				BoltLog bolt_logger;
 
@@ -53,10 +55,24 @@ namespace bolt {
 
 				try
 				{
-					MysqlConnection &connection = MysqlConnection::get_instance();
-					std::unique_ptr<sql::Statement> stmt(connection.getConnection()->createStatement());
+					MysqlConnectionLease connection = MysqlConnection::get_instance().acquire();
+					std::string query = utility::conversions::to_utf8string(dimpl->buildQuery());
 
-					res = stmt->execute(utility::conversions::to_utf8string(dimpl->buildQuery()));
+					if (dimpl->m_parameters.empty())
+					{
+						std::unique_ptr<sql::Statement> stmt(connection->createStatement());
+						res = stmt->execute(query);
+						connection.done();
+						return true;
+					}
+
+					sql::PreparedStatement *stmt = connection.prepareStatement(query);
+					for (size_t i = 0; i < dimpl->m_parameters.size(); ++i)
+					{
+						MysqlEntity::bindProperty(stmt, static_cast<int>(i + 1), dimpl->m_parameters[i]);
+					}
+					res = stmt->execute();
+					connection.done();
 					return true;
 				}
 				catch (sql::SQLException &e)
@@ -96,6 +112,12 @@ namespace bolt {
 				return *this;
 			}
 
+			MysqlDelete& MysqlDelete::bind(std::vector<mysql_property> parameters)
+			{
+				dimpl->m_parameters = std::move(parameters);
+				return *this;
+			}
+
 			MysqlDelete& MysqlDelete::orWhere(utility::string_t conditions)
 			{
 				auto iter = dimpl->m_query.find(U("where"));
@@ -1,6 +1,7 @@
 #include <mysql_entity.h>
 #include <mysql_connection.h>
 #include <mysql_table.h>
+#include <mysql_schema.h>
 
 namespace bolt
 {
@@ -15,6 +16,9 @@ namespace bolt
 				string_t table_name;
 				mysql_table_entity table_entity;
 
+				//Set by the last upsert, an update of an existing row leaves it false
+				bool inserted = false;
+
 				string_t trans_partition_key;
 				string_t trans_row_key;
 				string_t trans_table_name;
@@ -37,6 +41,11 @@ namespace bolt
 			{
 			}
 
+			const mysql_table_entity& MysqlEntity::tableEntity() const
+			{
+				return eimpl->table_entity;
+			}
+
 			void MysqlEntity::insertInt32(string_t PropertyName, int32_t value)
 			{
 				eimpl->table_entity.properties().insert(mysql_table_entity::property_type(PropertyName, mysql_property(value)));
@@ -67,77 +76,145 @@ namespace bolt
 				eimpl->table_entity.properties().insert(mysql_table_entity::property_type(PropertyName, mysql_property(value)));
 			}
 
-			bool MysqlEntity::executeEntity()
+			void MysqlEntity::bindProperty(sql::PreparedStatement *statement, int index, const mysql_property& property)
 			{
-				if (entityExists(eimpl->table_entity.row_key(), eimpl->table_entity.partition_key()))
+				switch (property.property_type())
 				{
-					return patchEntity();
+				case myedm_type::boolean:
+					statement->setBoolean(index, property.boolean_value());
+					break;
+				case myedm_type::datetime:
+					statement->setDateTime(index, conversions::to_utf8string(property.datetime_value().to_string()));
+					break;
+				case myedm_type::double_floating_point:
+					statement->setDouble(index, property.double_value());
+					break;
+				case myedm_type::int32:
+					statement->setInt(index, property.int32_value());
+					break;
+				case myedm_type::int64:
+					statement->setInt64(index, property.int64_value());
+					break;
+				default:
+					statement->setString(index, conversions::to_utf8string(property.string_value()));
+					break;
 				}
-				auto properties = eimpl->table_entity.properties();
+			}
 
-				for (const auto& property : properties)
+			/// <summary>
+			/// Binds the entity properties to consecutive parameters, starting at index.
+			/// </summary>
+			/// <returns>The index of the next free parameter.</returns>
+			static int bindProperties(sql::PreparedStatement *pre_statmt, const mysql_table_entity::properties_type& properties, int index)
+			{
+				for (auto iter = properties.cbegin(); iter != properties.cend(); ++iter, ++index)
 				{
-					if (!MysqlTable::hasColumn(eimpl->table_name, property.first))
-						MysqlTable::createColumn(eimpl->table_name, property.first, property.second.property_type());
+					MysqlEntity::bindProperty(pre_statmt, index, iter->second);
 				}
+				return index;
+			}
 
+			bool MysqlEntity::executeEntity()
+			{
+				return upsertEntity(upsert_mode::merge);
+			}
+
+			bool MysqlEntity::replaceEntity()
+			{
+				return upsertEntity(upsert_mode::replace);
+			}
+
+			std::string MysqlEntity::samePartitionUpdate(const std::string& column, const std::string& value)
+			{
+				return column + " = IF(PartitionKey = VALUES(PartitionKey), " + value + ", " + column + ")";
+			}
+
+			bool MysqlEntity::upsertEntity(upsert_mode mode)
+			{
+				const auto& properties = eimpl->table_entity.properties();
+
+				MysqlTable::createColumns(eimpl->table_name, properties);
 
 				std::string c_values = "";
 				std::string c_columns = "";
+				std::string c_updates = "";
 
 				for (auto iter = properties.cbegin(); iter != properties.cend(); ++iter)
 				{
-					c_columns += "`" + conversions::to_utf8string(iter->first) + "`,";
+					std::string column = "`" + conversions::to_utf8string(iter->first) + "`";
+					c_columns += column + ",";
 					c_values += "?,";
+					c_updates += samePartitionUpdate(column, "VALUES(" + column + ")") + ",";
+				}
+
+				if (mode == upsert_mode::replace)
+				{
+					//The row's other columns are cleared, as a delete and insert would
+					auto columns = MysqlSchema::get_instance().getColumns(eimpl->table_name);
+					if (!columns)
+					{
+						eimpl->bolt_logger << BoltLog::LOG_ERROR << "MysqlEntity (upsertEntity) could not read the columns of "
+							<< conversions::to_utf8string(eimpl->table_name);
+						return false;
+					}
+
+					for (const auto& column : *columns)
+					{
+						if (column.first == U("partitionkey") || column.first == U("rowkey") || column.first == U("timestamp"))
+							continue;
+
+						bool in_entity = false;
+						for (auto iter = properties.cbegin(); iter != properties.cend() && !in_entity; ++iter)
+						{
+							in_entity = MysqlSchema::key(iter->first) == column.first;
+						}
+						if (!in_entity)
+						{
+							c_updates += samePartitionUpdate("`" + conversions::to_utf8string(column.first) + "`", "NULL") + ",";
+						}
+					}
 				}
 
 				//Add postition to column and value 
 				c_columns += "PartitionKey,RowKey";
 				c_values += "?,?";
+				//Keeps the clause valid for an entity without properties
+				c_updates += "PartitionKey = PartitionKey";
 
-				sql::SQLString qery("INSERT INTO " + conversions::to_utf8string(eimpl->table_name) + "(" + c_columns +
-					") VALUES(" + c_values + ")");
+				std::string query = "INSERT INTO " + conversions::to_utf8string(eimpl->table_name) + "(" + c_columns + ") VALUES(" + c_values + ")"
+					+ " ON DUPLICATE KEY UPDATE " + c_updates;
 
 				try
 				{
-					MysqlConnection& connection = MysqlConnection::get_instance();
-					std::unique_ptr<sql::PreparedStatement> pre_statmt(connection.getConnection()->prepareStatement(qery));
-
-					int index = 1;
-					for (auto iter = properties.cbegin(); iter != properties.cend(); ++iter, ++index)
+					int affected = 0;
 					{
-						switch (iter->second.property_type())
-						{
-						case myedm_type::boolean:
-							pre_statmt->setBoolean(index, iter->second.boolean_value());
-							break;
-						case myedm_type::datetime:
-							pre_statmt->setDateTime(index, conversions::to_utf8string(iter->second.datetime_value().to_string()));
-							break;
-						case myedm_type::double_floating_point:
-							pre_statmt->setDouble(index, iter->second.double_value());
-							break;
-						case myedm_type::int32:
-							pre_statmt->setInt(index, iter->second.int32_value());
-							break;
-						case myedm_type::int64:
-							pre_statmt->setInt64(index, iter->second.int64_value());
-							break;
-						default:
-							pre_statmt->setString(index, conversions::to_utf8string(iter->second.string_value()));
-						}
-					}
+						MysqlConnectionLease connection = MysqlConnection::get_instance().acquire();
+						sql::PreparedStatement *pre_statmt = connection.prepareStatement(query);
 
-					pre_statmt->setString(index, conversions::to_utf8string(eimpl->table_entity.partition_key()));
-					pre_statmt->setString(++index, conversions::to_utf8string(eimpl->table_entity.row_key()));
+						int index = bindProperties(pre_statmt, properties, 1);
+
+						pre_statmt->setString(index, conversions::to_utf8string(eimpl->table_entity.partition_key()));
+						pre_statmt->setString(++index, conversions::to_utf8string(eimpl->table_entity.row_key()));
 
-					pre_statmt->execute();
+						affected = pre_statmt->executeUpdate();
+						connection.done();
+					}
+					eimpl->inserted = affected == 1;
+
+					//1 row affected for an insert, 2 for an update. None when the row kept its values,
+					//either because they were equal or because the RowKey belongs to another partition.
+					if (affected == 0 && !entityExists(eimpl->table_entity.row_key(), eimpl->table_entity.partition_key()))
+					{
+						eimpl->bolt_logger << BoltLog::LOG_ERROR << "MysqlEntity (upsertEntity) RowKey "
+							<< conversions::to_utf8string(eimpl->table_entity.row_key()) << " is used by another partition";
+						return false;
+					}
 					return true;
 				}
 				catch (sql::SQLException& e)
 				{
-					eimpl->bolt_logger << BoltLog::LOG_ERROR << "SQLException in MysqlInsert "
-						<< "(insertData) #ERR: " << e.what() << " (MySQL error code: "
+					eimpl->bolt_logger << BoltLog::LOG_ERROR << "SQLException in MysqlEntity "
+						<< "(upsertEntity) #ERR: " << e.what() << " (MySQL error code: "
 						<< e.getErrorCode() << ", SQLState: " << e.getSQLState() << " )";
 				}
 				return false;
@@ -146,24 +223,20 @@ namespace bolt
 
 			bool MysqlEntity::patchEntity()
 			{
-				auto properties = eimpl->table_entity.properties();
+				const auto& properties = eimpl->table_entity.properties();
 
-				for (const auto& property : properties)
-				{
-					if (!MysqlTable::hasColumn(eimpl->table_name, property.first))
-						MysqlTable::createColumn(eimpl->table_name, property.first, property.second.property_type());
-				}
+				MysqlTable::createColumns(eimpl->table_name, properties);
 
 
 				std::string c_columns = "";
 
 				for (auto iter = properties.cbegin(); iter != properties.cend(); ++iter)
 				{
-					c_columns += "`" + conversions::to_utf8string(iter->first) + "` = ?";
-					if (iter != (--properties.cend()))
+					if (iter != properties.cbegin())
 					{
 						c_columns += ",";
 					}
+					c_columns += "`" + conversions::to_utf8string(iter->first) + "` = ?";
 				}
 
 				sql::SQLString qery("UPDATE " + conversions::to_utf8string(eimpl->table_name) + " SET " + c_columns
@@ -171,39 +244,16 @@ namespace bolt
 
 				try
 				{
-					MysqlConnection& connection = MysqlConnection::get_instance();
-					std::unique_ptr<sql::PreparedStatement> pre_statmt(connection.getConnection()->prepareStatement(qery));
+					MysqlConnectionLease connection = MysqlConnection::get_instance().acquire();
+					sql::PreparedStatement *pre_statmt = connection.prepareStatement(qery);
 
-					int index = 1;
-					for (auto iter = properties.cbegin(); iter != properties.cend(); ++iter, ++index)
-					{
-						switch (iter->second.property_type())
-						{
-						case myedm_type::boolean:
-							pre_statmt->setBoolean(index, iter->second.boolean_value());
-							break;
-						case myedm_type::datetime:
-							pre_statmt->setDateTime(index, conversions::to_utf8string(iter->second.datetime_value().to_string()));
-							break;
-						case myedm_type::double_floating_point:
-							pre_statmt->setDouble(index, iter->second.double_value());
-							break;
-						case myedm_type::int32:
-							pre_statmt->setInt(index, iter->second.int32_value());
-							break;
-						case myedm_type::int64:
-							pre_statmt->setInt64(index, iter->second.int64_value());
-							break;
-						default:
-							pre_statmt->setString(index, conversions::to_utf8string(iter->second.string_value()));
-							break;
-						}
-					}
+					int index = bindProperties(pre_statmt, properties, 1);
 
 					pre_statmt->setString(index, conversions::to_utf8string(eimpl->table_entity.partition_key()));
 					pre_statmt->setString(++index, conversions::to_utf8string(eimpl->table_entity.row_key()));
 
 					pre_statmt->executeUpdate();
+					connection.done();
 					return true;
 				}
 				catch (sql::SQLException& e)
@@ -220,8 +270,8 @@ namespace bolt
 				try
 				{
 					sql::SQLString query("SELECT COUNT(*) AS count FROM " + conversions::to_utf8string(eimpl->table_name) + " WHERE PartitionKey = ? AND RowKey = ?");
-					MysqlConnection& connection = MysqlConnection::get_instance();
-					std::unique_ptr<sql::PreparedStatement> stmt(connection.getConnection()->prepareStatement(query));
+					MysqlConnectionLease connection = MysqlConnection::get_instance().acquire();
+					sql::PreparedStatement *stmt = connection.prepareStatement(query);
 
 					stmt->setString(1, conversions::to_utf8string(partition_key));
 					stmt->setString(2, conversions::to_utf8string(row_key));
@@ -229,10 +279,9 @@ namespace bolt
 					std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
 
 					res->rowsCount();
-					if (res->next() && res->getInt(1) == 1)
-					{
-						return true;
-					}
+					bool exists = res->next() && res->getInt(1) == 1;
+					connection.done();
+					return exists;
 				}
 				catch (sql::SQLException& e)
 				{
@@ -244,20 +293,26 @@ namespace bolt
 				return false;
 			}
 
+			bool MysqlEntity::inserted() const
+			{
+				return eimpl->inserted;
+			}
+
 			bool MysqlEntity::abort()
 			{
 				bool res = false;
 
 				try
 				{
-					MysqlConnection &connection = MysqlConnection::get_instance();
+					MysqlConnectionLease connection = MysqlConnection::get_instance().acquire();
 					sql::SQLString qery("DELETE FROM " + conversions::to_utf8string(eimpl->table_name) + " WHERE PartitionKey = ? AND RowKey = ?");
-					std::unique_ptr<sql::PreparedStatement> stmt(connection.getConnection()->prepareStatement(qery));
+					sql::PreparedStatement *stmt = connection.prepareStatement(qery);
 
 					stmt->setString(1, conversions::to_utf8string(eimpl->table_entity.partition_key()));
-					stmt->setString(1, conversions::to_utf8string(eimpl->table_entity.row_key()));
+					stmt->setString(2, conversions::to_utf8string(eimpl->table_entity.row_key()));
 
 					res = stmt->execute();
+					connection.done();
 					return true;
 				}
 				catch (sql::SQLException &e)
@@ -268,12 +323,6 @@ namespace bolt
 				}
 				return res;
 			}
-
-			bool MysqlEntity::replaceEntity()
-			{
-				//TODO: Implement function body
-				return false;
-			}
 		}
 	}
 }
\ No newline at end of file
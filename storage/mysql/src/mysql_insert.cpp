@@ -87,8 +87,8 @@ namespace bolt {
 
 				try
 				{
-					MysqlConnection &connection = MysqlConnection::get_instance();
-					std::unique_ptr<sql::PreparedStatement> pre_statmt(connection.getConnection()->prepareStatement(qery));
+					MysqlConnectionLease connection = MysqlConnection::get_instance().acquire();
+					std::unique_ptr<sql::PreparedStatement> pre_statmt(connection->prepareStatement(qery));
 
 					int index = 1;
 					for (auto iter = ifields.begin(); iter != ifields.end(); ++iter, ++index)
@@ -117,6 +117,7 @@ namespace bolt {
 					}
 
 					res = pre_statmt->execute();
+					connection.done();
 				}
 				catch (sql::SQLException &e)
 				{
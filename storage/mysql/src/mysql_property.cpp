@@ -21,6 +21,10 @@ namespace bolt {
 					throw std::runtime_error(error_entity_property_not_boolean);
 				}
 
+				if (m_value.empty())
+				{
+					return m_boolean;
+				}
 				if (m_value.compare(U("false")) == 0)
 				{
 					return false;
@@ -39,7 +43,9 @@ namespace bolt {
 					throw std::runtime_error(error_entity_property_not_datetime);
 				}
 
-				utility::datetime result = utility::datetime::from_string(m_value, utility::datetime::ISO_8601);
+				utility::datetime result = m_value.empty()
+					? utility::datetime() + m_datetime
+					: utility::datetime::from_string(m_value, utility::datetime::ISO_8601);
 				if (!result.is_initialized())
 				{
 					throw std::runtime_error(error_parse_datetime);
@@ -55,6 +61,10 @@ namespace bolt {
 					throw std::runtime_error(error_entity_property_not_double);
 				}
 
+				if (m_value.empty())
+				{
+					return m_double;
+				}
 				if (m_value.compare(double_not_a_number) == 0)
 				{
 					return std::numeric_limits<double>::quiet_NaN();
@@ -98,6 +108,11 @@ namespace bolt {
 					throw std::runtime_error(error_entity_property_not_int32);
 				}
 
+				if (m_value.empty())
+				{
+					return static_cast<int32_t>(m_integer);
+				}
+
 				int32_t result;
 				utility::istringstream_t buffer(m_value);
 				buffer >> result;
@@ -117,6 +132,11 @@ namespace bolt {
 					throw std::runtime_error(error_entity_property_not_int64);
 				}
 
+				if (m_value.empty())
+				{
+					return m_integer;
+				}
+
 				int64_t result;
 				utility::istringstream_t buffer(m_value);
 				buffer >> result;
@@ -133,34 +153,50 @@ namespace bolt {
 				return m_value;
 			}
 
-			void mysql_property::set_value_impl(double value)
-			{
-				utility::ostringstream_t buffer;
-				buffer.precision(std::numeric_limits<double>::digits10 + 2);
-				buffer << value;
-				m_value = buffer.str();
-			}
-
-			void mysql_property::set_value_impl(long double value)
+			utility::string_t mysql_property::str() const
 			{
-				utility::ostringstream_t buffer;
-				buffer.precision(std::numeric_limits<long double>::digits10 + 2);
-				buffer << value;
-				m_value = buffer.str();
-			}
+				//Strings and binary, and values given a new type by set_property_type, are held as text
+				if (!m_value.empty() || m_property_type == myedm_type::string || m_property_type == myedm_type::binary)
+				{
+					return m_value;
+				}
 
-			void mysql_property::set_value_impl(int32_t value)
-			{
-				utility::ostringstream_t buffer;
-				buffer << value;
-				m_value = buffer.str();
-			}
+				switch (m_property_type)
+				{
+				case myedm_type::boolean:
+					return m_boolean ? U("true") : U("false");
+				case myedm_type::datetime:
+					return (utility::datetime() + m_datetime).to_string(utility::datetime::ISO_8601);
+				case myedm_type::double_floating_point:
+				{
+					if (m_double != m_double)
+					{
+						return double_not_a_number;
+					}
+					if (m_double == std::numeric_limits<double>::infinity())
+					{
+						return double_infinity;
+					}
+					if (m_double == -std::numeric_limits<double>::infinity())
+					{
+						return double_negative_infinity;
+					}
 
-			void mysql_property::set_value_impl(int64_t value)
-			{
-				utility::ostringstream_t buffer;
-				buffer << value;
-				m_value = buffer.str();
+					utility::ostringstream_t buffer;
+					buffer.precision(std::numeric_limits<double>::digits10 + 2);
+					buffer << m_double;
+					return buffer.str();
+				}
+				case myedm_type::int32:
+				case myedm_type::int64:
+				{
+					utility::ostringstream_t buffer;
+					buffer << m_integer;
+					return buffer.str();
+				}
+				default:
+					return m_value;
+				}
 			}
 		}
 
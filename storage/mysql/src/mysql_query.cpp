@@ -2,6 +2,7 @@
 #include <mysql_query.h>
 #include <mysql_connection.h>
 #include <mysql_result.h>
+#include <mysql_entity.h>
 
 namespace bolt {
 	namespace storage {
@@ -13,19 +14,41 @@ namespace bolt {
 				utility::string_t tblname;
 
 				std::map<utility::string_t, utility::string_t> m_query;
+				std::vector<mysql_property> m_parameters;
 
 				BoltLog bolt_logger;
 
-				std::deque<mysql_table_entity> innerQuery(std::unique_ptr<sql::ResultSet> &res)
+				/// <summary>
+				/// Runs the query. Without parameters it runs as a plain statement owned by statement,
+				/// otherwise as a prepared statement that belongs to the connection.
+				/// </summary>
+				std::unique_ptr<sql::ResultSet> execute(MysqlConnectionLease &connection, std::unique_ptr<sql::Statement> &statement, bool forward_only)
 				{
+					std::string query = utility::conversions::to_utf8string(buildQuery());
 
-					std::deque<mysql_table_entity> entites;
-
-					sql::ResultSetMetaData *res_meta = res->getMetaData();
+					if (m_parameters.empty())
+					{
+						statement.reset(connection->createStatement());
+						if (forward_only)
+							statement->setResultSetType(sql::ResultSet::TYPE_FORWARD_ONLY);
+						return std::unique_ptr<sql::ResultSet>(statement->executeQuery(query));
+					}
 
-					int column_count = res_meta->getColumnCount();
+					sql::PreparedStatement *prepared = connection.prepareStatement(query);
+					if (forward_only)
+						prepared->setResultSetType(sql::ResultSet::TYPE_FORWARD_ONLY);
+					for (size_t i = 0; i < m_parameters.size(); ++i)
+					{
+						MysqlEntity::bindProperty(prepared, static_cast<int>(i + 1), m_parameters[i]);
+					}
+					return std::unique_ptr<sql::ResultSet>(prepared->executeQuery());
+				}
 
-					//Declare variabels outside loops to improve perfomance
+				/// <summary>
+				/// Reads the current row of the result set into table_entity, replacing its properties.
+				/// </summary>
+				void readRow(std::unique_ptr<sql::ResultSet> &res, const std::vector<mysql_result_set::field> &fields, mysql_table_entity &table_entity)
+				{
 					//Partition key of an entity
 					utility::string_t parition_key;
 					//Row key of an entity
@@ -33,71 +56,47 @@ namespace bolt {
 					utility::datetime timestamp;
 					//a propery of an entity
 					mysql_property property;
-					//MySql table column column name
-					utility::string_t column_name;
-					//A MySql entity
-					mysql_table_entity table_entity;
 
-					while (res->next())
+					//Clear properties of the previous row
+					table_entity.clear_properties();
+
+					for (const mysql_result_set::field &column : fields)
 					{
+						switch (column.target)
+						{
+						case mysql_result_set::field::partition_key:
+							parition_key = utility::conversions::to_string_t(res->getString(column.index));
+							continue;
+						case mysql_result_set::field::row_key:
+							row_key = utility::conversions::to_string_t(res->getString(column.index));
+							continue;
+						case mysql_result_set::field::timestamp:
+							timestamp = utility::datetime::from_string(utility::conversions::to_string_t(res->getString(column.index)));
+							continue;
+						default:
+							break;
+						}
 
-						for (int i = 1; i <= column_count; i++)
+						switch (column.type)
 						{
-							column_name = utility::conversions::to_string_t(res_meta->getColumnName(i));
-
-							if (column_name == U("PartitionKey"))
-							{
-								parition_key = utility::conversions::to_string_t(res->getString(i));
-								continue;
-							}
-							if (column_name == U("RowKey"))
-							{
-								row_key = utility::conversions::to_string_t(res->getString(i));
-								continue;
-							}
-							if (column_name == U("TimeStamp"))
-							{
-								timestamp = utility::datetime::from_string(utility::conversions::to_string_t(res->getString(i)));
-								continue;
-							}
-							switch (res_meta->getColumnType(i))
-							{
-							case sql::DataType::BIT: //fall thorugh switch
-							case sql::DataType::TINYINT:
-							case sql::DataType::SMALLINT:
-							case sql::DataType::MEDIUMINT:
-							case sql::DataType::INTEGER:
-								property.set_value(res->getInt(i));
-								break;
-							case sql::DataType::BIGINT:
-								property.set_value(res->getInt64(i));
-								break;
-							case sql::DataType::DOUBLE: //fall thorugh switch
-							case sql::DataType::REAL:
-							case sql::DataType::DECIMAL:
-							case sql::DataType::NUMERIC:
-								property.set_value(res->getDouble(i));
-								break;
-							case sql::DataType::SQLNULL:
-							case sql::DataType::UNKNOWN:
-								continue;
-							default:
-								property.set_value(utility::conversions::to_string_t(res->getString(i)));
-								break;
-							}
-							table_entity.add_property(column_name, property);
+						case myedm_type::int32:
+							property.set_value(res->getInt(column.index));
+							break;
+						case myedm_type::int64:
+							property.set_value(res->getInt64(column.index));
+							break;
+						case myedm_type::double_floating_point:
+							property.set_value(res->getDouble(column.index));
+							break;
+						default:
+							property.set_value(utility::conversions::to_string_t(res->getString(column.index)));
+							break;
 						}
-						//To improve performance try not to declare new objects
-						table_entity.set_partition_key(parition_key);
-						table_entity.set_row_key(row_key);
-						table_entity.set_timestamp(timestamp);
-						//add entity to vector
-						entites.push_back(table_entity);
-						//Clear properties of the entity
-						table_entity.clear_properties();
+						table_entity.add_property(column.name, property);
 					}
-
-					return entites;
+					table_entity.set_partition_key(parition_key);
+					table_entity.set_row_key(row_key);
+					table_entity.set_timestamp(timestamp);
 				}
 
 
@@ -357,17 +356,23 @@ namespace bolt {
 				return *this;
 			}
 
-			std::deque<mysql_table_entity> MysqlQuery::queryAll()
+			MysqlQuery& MysqlQuery::bind(std::vector<mysql_property> parameters)
+			{
+				qimpl->m_parameters = std::move(parameters);
+				return *this;
+			}
+
+			mysql_result_set MysqlQuery::queryAll()
 			{
-				std::deque<mysql_table_entity> entities;
 				try
 				{
-				MysqlConnection &connection = MysqlConnection::get_instance();
-				utility::string_t query = qimpl->buildQuery();
-				std::unique_ptr<sql::Statement> stmt(connection.getConnection()->createStatement());
-				std::unique_ptr<sql::ResultSet> res(stmt->executeQuery(utility::conversions::to_utf8string(query)));
+					MysqlConnectionLease connection = MysqlConnection::get_instance().acquire();
+					std::unique_ptr<sql::Statement> stmt;
+					std::unique_ptr<sql::ResultSet> res(qimpl->execute(connection, stmt, false));
 
-				entities = qimpl->innerQuery(res);
+					mysql_result_set result = mysql_result_set::read(*res);
+					connection.done();
+					return result;
 				}
 				catch (sql::SQLException &e)
 				{
@@ -375,28 +380,58 @@ namespace bolt {
 						<< e.what() << " (MySQL error code: "
 						<< std::to_string(e.getErrorCode()) << ", SQLState: " << e.getSQLState() << " )";
 				}
-				return entities;
+				return mysql_result_set();
 			}
 
 
-			std::deque<mysql_table_entity> MysqlQuery::filterByKey(utility::string_t partition_key, utility::string_t row_key)
+			bool MysqlQuery::queryEach(std::function<bool(const mysql_table_entity&)> callback)
+			{
+				try
+				{
+					MysqlConnectionLease connection = MysqlConnection::get_instance().acquire();
+					std::unique_ptr<sql::Statement> stmt;
+					//Forward only result sets are read from the server row by row instead of being buffered whole
+					std::unique_ptr<sql::ResultSet> res(qimpl->execute(connection, stmt, true));
+
+					std::vector<mysql_result_set::field> fields = mysql_result_set::describe(res->getMetaData());
+
+					mysql_table_entity table_entity;
+					while (res->next())
+					{
+						qimpl->readRow(res, fields, table_entity);
+						if (!callback(table_entity))
+							break;
+					}
+					connection.done();
+					return true;
+				}
+				catch (sql::SQLException &e)
+				{
+					qimpl->bolt_logger << BoltLog::LOG_ERROR << "SQLException in MysqlQuery (queryEach) #ERR: "
+						<< e.what() << " (MySQL error code: "
+						<< std::to_string(e.getErrorCode()) << ", SQLState: " << e.getSQLState() << " )";
+				}
+				return false;
+			}
+
+			mysql_result_set MysqlQuery::filterByKey(utility::string_t partition_key, utility::string_t row_key)
 			{
 				where(U("PartitionKey=?"));
 				andWhere(U("RowKey=?"));
 
-				std::deque<mysql_table_entity> entities;
-
 				try
 				{
-					MysqlConnection &connection = MysqlConnection::get_instance();
+					MysqlConnectionLease connection = MysqlConnection::get_instance().acquire();
 					utility::string_t query = qimpl->buildQuery(); 
-					std::unique_ptr<sql::PreparedStatement> stmt(connection.getConnection()->prepareStatement(utility::conversions::to_utf8string(query)));
+					sql::PreparedStatement *stmt = connection.prepareStatement(utility::conversions::to_utf8string(query));
 					stmt->setString(1, utility::conversions::to_utf8string(partition_key));
 					stmt->setString(2, utility::conversions::to_utf8string(row_key));
 					
 					std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
 
-					entities = qimpl->innerQuery(res);
+					mysql_result_set result = mysql_result_set::read(*res);
+					connection.done();
+					return result;
 				}
 				catch (sql::SQLException &e)
 				{
@@ -404,7 +439,7 @@ namespace bolt {
 						<< e.what() << " (MySQL error code: "
 						<< std::to_string(e.getErrorCode()) << ", SQLState: " << e.getSQLState() << " )";
 				}
-				return entities;
+				return mysql_result_set();
 			}
 		}
 	}
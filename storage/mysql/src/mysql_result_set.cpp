@@ -0,0 +1,193 @@
+#include <mysql_result_set.h>
+#include <mysql_connection.h>
+
+namespace bolt {
+	namespace storage {
+		namespace mysql {
+
+			std::vector<mysql_result_set::field> mysql_result_set::describe(sql::ResultSetMetaData *meta)
+			{
+				int column_count = static_cast<int>(meta->getColumnCount());
+
+				std::vector<field> fields;
+				fields.reserve(column_count);
+
+				for (int i = 1; i <= column_count; i++)
+				{
+					field entry;
+					entry.index = i;
+					entry.type = myedm_type::string;
+					entry.name = utility::conversions::to_string_t(meta->getColumnName(i));
+
+					if (entry.name == U("PartitionKey"))
+					{
+						entry.target = field::partition_key;
+					}
+					else if (entry.name == U("RowKey"))
+					{
+						entry.target = field::row_key;
+					}
+					else if (entry.name == U("TimeStamp"))
+					{
+						entry.target = field::timestamp;
+					}
+					else
+					{
+						entry.target = field::property;
+						switch (meta->getColumnType(i))
+						{
+						case sql::DataType::BIT: //fall thorugh switch
+						case sql::DataType::TINYINT:
+						case sql::DataType::SMALLINT:
+						case sql::DataType::MEDIUMINT:
+						case sql::DataType::INTEGER:
+							entry.type = myedm_type::int32;
+							break;
+						case sql::DataType::BIGINT:
+							entry.type = myedm_type::int64;
+							break;
+						case sql::DataType::DOUBLE: //fall thorugh switch
+						case sql::DataType::REAL:
+						case sql::DataType::DECIMAL:
+						case sql::DataType::NUMERIC:
+							entry.type = myedm_type::double_floating_point;
+							break;
+						case sql::DataType::SQLNULL:
+						case sql::DataType::UNKNOWN:
+							continue;
+						default:
+							break;
+						}
+
+						//An entity keeps the first property of a name, as the property map always did
+						bool taken = false;
+						for (const field &earlier : fields)
+						{
+							if (earlier.target == field::property && earlier.name == entry.name)
+							{
+								taken = true;
+								break;
+							}
+						}
+						if (taken)
+							continue;
+					}
+					fields.push_back(std::move(entry));
+				}
+				return fields;
+			}
+
+			mysql_result_set mysql_result_set::read(sql::ResultSet &res)
+			{
+				mysql_result_set result;
+				std::vector<field> fields = describe(res.getMetaData());
+
+				//Buffered results know their size, forward only ones are read from the server as they go
+				size_t expected = res.getType() != sql::ResultSet::TYPE_FORWARD_ONLY ? res.rowsCount() : 0;
+
+				//The property column of every field, nullptr for the keys
+				std::vector<column*> columns(fields.size(), nullptr);
+				size_t property_count = 0;
+				for (const field &source : fields)
+				{
+					if (source.target == field::property)
+						++property_count;
+				}
+				result.m_columns.reserve(property_count);
+
+				for (size_t f = 0; f < fields.size(); ++f)
+				{
+					if (fields[f].target != field::property)
+						continue;
+
+					result.m_columns.push_back(column());
+					column &target = result.m_columns.back();
+					target.m_name = fields[f].name;
+					target.m_type = fields[f].type;
+					switch (target.m_type)
+					{
+					case myedm_type::int32:
+					case myedm_type::int64:
+						target.m_integers.reserve(expected);
+						break;
+					case myedm_type::double_floating_point:
+						target.m_doubles.reserve(expected);
+						break;
+					default:
+						target.m_strings.reserve(expected);
+						break;
+					}
+					columns[f] = &target;
+				}
+				result.m_partition_keys.reserve(expected);
+				result.m_row_keys.reserve(expected);
+				result.m_timestamps.reserve(expected);
+
+				while (res.next())
+				{
+					//Rows without key columns get empty keys, as an entity always had
+					text_range partition_key = { 0, 0 };
+					text_range row_key = { 0, 0 };
+					utility::datetime::interval_type timestamp = 0;
+
+					for (size_t f = 0; f < fields.size(); ++f)
+					{
+						const field &source = fields[f];
+						switch (source.target)
+						{
+						case field::partition_key:
+							partition_key = result.intern(result.m_partition_keys, utility::conversions::to_string_t(res.getString(source.index)));
+							continue;
+						case field::row_key:
+							row_key = result.intern(result.m_row_keys, utility::conversions::to_string_t(res.getString(source.index)));
+							continue;
+						case field::timestamp:
+							timestamp = utility::datetime::from_string(utility::conversions::to_string_t(res.getString(source.index))).to_interval();
+							continue;
+						default:
+							break;
+						}
+
+						column &target = *columns[f];
+						switch (target.m_type)
+						{
+						case myedm_type::int32:
+							target.m_integers.push_back(res.getInt(source.index));
+							break;
+						case myedm_type::int64:
+							target.m_integers.push_back(res.getInt64(source.index));
+							break;
+						case myedm_type::double_floating_point:
+							target.m_doubles.push_back(static_cast<double>(res.getDouble(source.index)));
+							break;
+						default:
+							target.m_strings.push_back(result.intern(target.m_strings, utility::conversions::to_string_t(res.getString(source.index))));
+							break;
+						}
+					}
+
+					result.m_partition_keys.push_back(partition_key);
+					result.m_row_keys.push_back(row_key);
+					result.m_timestamps.push_back(timestamp);
+					++result.m_size;
+				}
+
+				return result;
+			}
+
+			mysql_result_set::text_range mysql_result_set::intern(const std::vector<text_range> &cells, const utility::string_t &value)
+			{
+				if (!cells.empty())
+				{
+					const text_range &above = cells.back();
+					if (above.length == value.size() && m_text.compare(above.offset, above.length, value) == 0)
+						return above;
+				}
+
+				text_range range = { m_text.size(), value.size() };
+				m_text += value;
+				return range;
+			}
+		}
+	}
+}
@@ -0,0 +1,113 @@
+#include <mysql_schema.h>
+#include <mysql_connection.h>
+#include <logger.hpp>
+#include <vector>
+
+namespace bolt {
+	namespace storage {
+		namespace mysql {
+			std::unique_ptr<MysqlSchema> MysqlSchema::m_instance;
+			std::once_flag MysqlSchema::m_instance_flag;
+
+			MysqlSchema& MysqlSchema::get_instance()
+			{
+				call_once(m_instance_flag, [] {m_instance.reset(new MysqlSchema); });
+				return *m_instance.get();
+			}
+
+			utility::string_t MysqlSchema::key(const utility::string_t& name)
+			{
+				utility::string_t key(name);
+				for (auto& c : key)
+				{
+					if (c >= U('A') && c <= U('Z'))
+						c = c - U('A') + U('a');
+				}
+				return key;
+			}
+
+			std::shared_ptr<const MysqlSchema::columns_type> MysqlSchema::getColumns(const utility::string_t& table_name)
+			{
+				std::shared_ptr<columns_type> columns;
+				//A load overtaken by a schema change is read again, a few times at most
+				for (int attempt = 0; attempt < max_load_attempts; ++attempt)
+				{
+					//Entries are never erased, a table without one has not changed yet
+					unsigned long generation = 0;
+					{
+						std::lock_guard<std::mutex> lock(m_mutex);
+						auto iter = m_tables.find(table_name);
+						if (iter != m_tables.end())
+						{
+							if (iter->second.columns)
+								return iter->second.columns;
+							generation = iter->second.generation;
+						}
+					}
+
+					columns = std::make_shared<columns_type>();
+					try
+					{
+						MysqlConnectionLease connection = MysqlConnection::get_instance().acquire();
+						std::unique_ptr<sql::Statement> stmt(connection->createStatement());
+						std::unique_ptr<sql::ResultSet> res(stmt->executeQuery("SHOW COLUMNS IN " + utility::conversions::to_utf8string(table_name)));
+
+						while (res->next())
+						{
+							(*columns)[key(utility::conversions::to_string_t(res->getString(1)))] = res->getString(2);
+						}
+						connection.done();
+					}
+					catch (sql::SQLException& e)
+					{
+						BoltLog logger;
+						logger << BoltLog::LOG_ERROR << "SQLException in MysqlSchema "
+							<< "(getColumns) #ERR: " << e.what() << " (MySQL error code: "
+							<< e.getErrorCode() << ", SQLState: " << e.getSQLState() << " )";
+						return nullptr;
+					}
+
+					std::lock_guard<std::mutex> lock(m_mutex);
+					Table& table = m_tables[table_name];
+					//Another thread may have read or extended the table meanwhile, keep its copy
+					if (table.columns)
+						return table.columns;
+					if (table.generation == generation)
+					{
+						table.columns = columns;
+						return table.columns;
+					}
+				}
+
+				//The table keeps changing, this caller gets the last read without caching it
+				return columns;
+			}
+
+			void MysqlSchema::addColumns(const utility::string_t& table_name, const std::vector<std::pair<utility::string_t, std::string>>& columns)
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				Table& table = m_tables[table_name];
+				//A load still running may have read the table before the columns were added
+				++table.generation;
+				if (!table.columns)
+					return;
+
+				std::shared_ptr<columns_type> updated = std::make_shared<columns_type>(*table.columns);
+				for (const auto& column : columns)
+				{
+					(*updated)[key(column.first)] = column.second;
+				}
+				table.columns = updated;
+			}
+
+			void MysqlSchema::invalidate(const utility::string_t& table_name)
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				//The entry stays, its generation tells a running load that it read an outdated table
+				Table& table = m_tables[table_name];
+				++table.generation;
+				table.columns.reset();
+			}
+		}
+	}
+}
@@ -1,6 +1,8 @@
 #include <mysql_table.h>
 #include <mysql_connection.h>
+#include <mysql_schema.h>
 #include <logger.hpp>
+#include <unordered_set>
 
 namespace bolt
 {
@@ -23,8 +25,8 @@ namespace bolt
 
 				try
 				{
-					MysqlConnection& connection = MysqlConnection::get_instance();
-					std::unique_ptr<sql::PreparedStatement> stmt(connection.getConnection()->prepareStatement(conversions::to_utf8string(sql)));
+					MysqlConnectionLease connection = MysqlConnection::get_instance().acquire();
+					std::unique_ptr<sql::PreparedStatement> stmt(connection->prepareStatement(conversions::to_utf8string(sql)));
 					std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
 
 					//vector<map<string,string>> data;
@@ -47,6 +49,7 @@ namespace bolt
 						mysql_incognito_entity incoent(property_type);
 						entites.push_back(incoent);
 					}
+					connection.done();
 				}
 				catch (sql::SQLException& e)
 				{
@@ -64,13 +67,15 @@ namespace bolt
 			{
 				try
 				{
-					MysqlConnection& connection = MysqlConnection::get_instance();
+					MysqlConnectionLease connection = MysqlConnection::get_instance().acquire();
 					sql::SQLString qery("CREATE TABLE IF NOT EXISTS " + conversions::to_utf8string(table_name)
 						+ "(PartitionKey VARCHAR(255) NOT NULL, INDEX(PartitionKey(50)) , RowKey VARCHAR(255) PRIMARY KEY NOT NULL , `Timestamp` TIMESTAMP DEFAULT CURRENT_TIMESTAMP ON UPDATE CURRENT_TIMESTAMP)");
 
-					std::unique_ptr<sql::Statement> pre_statmt(connection.getConnection()->createStatement());
+					std::unique_ptr<sql::Statement> pre_statmt(connection->createStatement());
 
 					pre_statmt->execute(qery);
+					connection.done();
+					MysqlSchema::get_instance().invalidate(table_name);
 					return true;
 				}
 				catch (sql::SQLException& e)
@@ -89,15 +94,16 @@ namespace bolt
 
 				try
 				{
-					MysqlConnection& connection = MysqlConnection::get_instance();
+					MysqlConnectionLease connection = MysqlConnection::get_instance().acquire();
 					sql::SQLString query2("SHOW TABLES");
-					std::unique_ptr<sql::Statement> stmt(connection.getConnection()->createStatement());
+					std::unique_ptr<sql::Statement> stmt(connection->createStatement());
 					std::unique_ptr<sql::ResultSet> res(stmt->executeQuery(query2));
 
 					while (res->next())
 					{
 						tables.push_back(conversions::to_string_t(res->getString(1))); // TABLE_NAME
 					}
+					connection.done();
 				}
 				catch (sql::SQLException& e)
 				{
@@ -113,12 +119,15 @@ namespace bolt
 			{
 				try
 				{
-					MysqlConnection& connection = MysqlConnection::get_instance();
+					MysqlConnectionLease connection = MysqlConnection::get_instance().acquire();
 					sql::SQLString qery("DROP TABLE IF EXISTS " + conversions::to_utf8string(table_name));
 
-					std::unique_ptr<sql::Statement> pre_statmt(connection.getConnection()->createStatement());
+					std::unique_ptr<sql::Statement> pre_statmt(connection->createStatement());
 
 					pre_statmt->execute(qery);
+					connection.done();
+					MysqlSchema::get_instance().invalidate(table_name);
+					MysqlConnection::get_instance().invalidateStatements();
 					return true;
 				}
 				catch (sql::SQLException& e)
@@ -136,15 +145,16 @@ namespace bolt
 
 				try
 				{
-					MysqlConnection& connection = MysqlConnection::get_instance();
+					MysqlConnectionLease connection = MysqlConnection::get_instance().acquire();
 					sql::SQLString query2("SHOW COLUMNS IN " + conversions::to_utf8string(table_name));
-					std::unique_ptr<sql::Statement> stmt(connection.getConnection()->createStatement());
+					std::unique_ptr<sql::Statement> stmt(connection->createStatement());
 					std::unique_ptr<sql::ResultSet> res(stmt->executeQuery(query2));
 
 					while (res->next())
 					{
 						tables.push_back(conversions::to_string_t(res->getString(1)));
 					}
+					connection.done();
 				}
 				catch (sql::SQLException& e)
 				{
@@ -156,47 +166,45 @@ namespace bolt
 				return tables;
 			}
 
+			std::string MysqlTable::columnType(myedm_type datatype)
+			{
+				switch (datatype)
+				{
+				case myedm_type::boolean:
+					return "TINYINT(1)";
+				case myedm_type::datetime:
+					return "TIMESTAMP";
+				case myedm_type::double_floating_point:
+					return "DOUBLE";
+				case myedm_type::guid:
+					return "VARCHAR(255)";
+				case myedm_type::int32:
+					return "INT";
+				case myedm_type::int64:
+					return "BIGINT";
+				case myedm_type::binary:
+					return "BLOB";
+				default:
+					return "TEXT";
+				}
+			}
+
 			bool MysqlTable::createColumn(string_t table_name, string_t column_name, myedm_type datatype)
 			{
 				try
 				{
-					MysqlConnection& connection = MysqlConnection::get_instance();
+					MysqlConnectionLease connection = MysqlConnection::get_instance().acquire();
 
+					std::string type = columnType(datatype);
 					sql::SQLString query("ALTER TABLE " + conversions::to_utf8string(table_name) +
-						" ADD `" + conversions::to_utf8string(column_name) + "`");
-
-					switch (datatype)
-					{
-					case myedm_type::string:
-						query += " TEXT";
-						break;
-					case myedm_type::boolean:
-						query += " TINYINT(1)";
-						break;
-					case myedm_type::datetime:
-						query += " TIMESTAMP";
-						break;
-					case myedm_type::double_floating_point:
-						query += " DOUBLE";
-						break;
-					case myedm_type::guid:
-						query += " VARCHAR(255)";
-						break;
-					case myedm_type::int32:
-						query += " INT";
-						break;
-					case myedm_type::int64:
-						query += " BIGINT";
-						break;
-					default:
-						//TODO: this will omit the column name
-						//Find a column data type for default
-						break;
-					}
+						" ADD `" + conversions::to_utf8string(column_name) + "` " + type);
 
-					std::unique_ptr<sql::Statement> pre_statmt(connection.getConnection()->createStatement());
+					std::unique_ptr<sql::Statement> pre_statmt(connection->createStatement());
 
 					pre_statmt->execute(query);
+					connection.done();
+					MysqlSchema::get_instance().addColumns(table_name, { std::make_pair(column_name, type) });
+					MysqlConnection::get_instance().invalidateStatements();
 					return true;
 				}
 				catch (sql::SQLException& e)
@@ -209,20 +217,70 @@ namespace bolt
 				}
 			}
 
-			bool MysqlTable::hasColumn(string_t table_name, string_t column_name)
+			bool MysqlTable::createColumns(string_t table_name, const mysql_table_entity::properties_type& properties)
 			{
-				auto columns_in_table = getColumns(table_name);
-
-				for (auto column : columns_in_table)
+				//A second attempt covers a column added by another writer after the schema was cached
+				for (int attempt = 0; attempt < 2; ++attempt)
 				{
-					if (column == column_name)
+					auto columns = MysqlSchema::get_instance().getColumns(table_name);
+					if (!columns)
+						return false;
+
+					std::vector<std::pair<string_t, std::string>> missing;
+					std::unordered_set<string_t> added;
+					for (const auto& property : properties)
 					{
+						string_t key = MysqlSchema::key(property.first);
+						if (columns->find(key) == columns->end() && added.insert(key).second)
+							missing.push_back(std::make_pair(property.first, columnType(property.second.property_type())));
+					}
+
+					if (missing.empty())
 						return true;
+
+					std::string query("ALTER TABLE " + conversions::to_utf8string(table_name));
+					for (auto iter = missing.cbegin(); iter != missing.cend(); ++iter)
+					{
+						query += iter == missing.cbegin() ? " ADD `" : ", ADD `";
+						query += conversions::to_utf8string(iter->first) + "` " + iter->second;
+					}
+
+					try
+					{
+						MysqlConnectionLease connection = MysqlConnection::get_instance().acquire();
+						std::unique_ptr<sql::Statement> pre_statmt(connection->createStatement());
+
+						pre_statmt->execute(query);
+						connection.done();
+						MysqlSchema::get_instance().addColumns(table_name, missing);
+						MysqlConnection::get_instance().invalidateStatements();
+						return true;
+					}
+					catch (sql::SQLException& e)
+					{
+						//ER_DUP_FIELDNAME
+						if (e.getErrorCode() == 1060 && attempt == 0)
+						{
+							MysqlSchema::get_instance().invalidate(table_name);
+							continue;
+						}
+
+						BoltLog logger;
+						logger << BoltLog::LOG_ERROR << "SQLException in MysqlTable "
+							<< "(createColumns) #ERR: " << e.what() << " (MySQL error code: "
+							<< e.getErrorCode() << ", SQLState: " << e.getSQLState() << " )";
+						return false;
 					}
 				}
 				return false;
 			}
 
+			bool MysqlTable::hasColumn(string_t table_name, string_t column_name)
+			{
+				auto columns = MysqlSchema::get_instance().getColumns(table_name);
+				return columns && columns->find(MysqlSchema::key(column_name)) != columns->end();
+			}
+
 			std::vector<mysql_incognito_entity> MysqlTable::analyzeTable(string_t table_name)
 			{
 				string_t sql = U("ANALYZE TABLE ") + table_name;